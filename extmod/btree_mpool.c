@@ -0,0 +1,323 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "py/mpconfig.h"
+
+#if MICROPY_PY_BTREE
+
+#include <db.h>
+
+// The page cache used by berkeley-db's btree, in place of the library's
+// mpool/mpool.c and with the same interface.  All the cache pages are
+// allocated at once in an arena when the pool is opened, instead of one
+// malloc per page.  Pages are found through a hash table sized for the
+// cache, and the least recently used page that isn't pinned is reused when
+// another is needed, without walking over the pinned ones.  Only when every
+// page is pinned is a page allocated outside the arena, as the library does.
+
+// Page flags, as in the library's mpool.h
+#define MPOOL_DIRTY 0x01 // page needs to be written
+#define MPOOL_PINNED 0x02 // page is pinned into memory
+
+typedef struct _mpool_bkt_t {
+    struct _mpool_bkt_t *hash_next; // next page in the same hash chain
+    // Neighbours in the LRU list, which holds the pages that aren't pinned.
+    // Arena slots not holding a page are kept in a list through next.
+    struct _mpool_bkt_t *prev;
+    struct _mpool_bkt_t *next;
+    pgno_t pgno;
+    uint8_t flags;
+    // the page follows
+} mpool_bkt_t;
+
+typedef struct MPOOL {
+    mpool_bkt_t **hash; // hash_mask + 1 chains of pages, by page number
+    pgno_t hash_mask;
+    mpool_bkt_t *lru_head; // least recently used page that isn't pinned
+    mpool_bkt_t *lru_tail;
+    mpool_bkt_t *free; // arena slots not holding a page
+    char *arena;
+    char *arena_end;
+    size_t slot_size;
+    pgno_t npages; // number of pages in the file
+    size_t pagesize;
+    virt_fd_t fd;
+    const FILEVTABLE *fvtable;
+    void (*pgin)(void *, pgno_t, void *);
+    void (*pgout)(void *, pgno_t, void *);
+    void *pgcookie;
+} MPOOL;
+
+#define BKT_PAGE(bp) ((void*)((bp) + 1))
+#define PAGE_BKT(page) ((mpool_bkt_t*)(page) - 1)
+
+STATIC bool mpool_in_arena(MPOOL *mp, mpool_bkt_t *bp) {
+    return (char*)bp >= mp->arena && (char*)bp < mp->arena_end;
+}
+
+STATIC void mpool_lru_remove(MPOOL *mp, mpool_bkt_t *bp) {
+    if (bp->prev == NULL) {
+        mp->lru_head = bp->next;
+    } else {
+        bp->prev->next = bp->next;
+    }
+    if (bp->next == NULL) {
+        mp->lru_tail = bp->prev;
+    } else {
+        bp->next->prev = bp->prev;
+    }
+}
+
+STATIC void mpool_lru_append(MPOOL *mp, mpool_bkt_t *bp) {
+    bp->prev = mp->lru_tail;
+    bp->next = NULL;
+    if (mp->lru_tail == NULL) {
+        mp->lru_head = bp;
+    } else {
+        mp->lru_tail->next = bp;
+    }
+    mp->lru_tail = bp;
+}
+
+STATIC mpool_bkt_t **mpool_hash_chain(MPOOL *mp, pgno_t pgno) {
+    return &mp->hash[pgno & mp->hash_mask];
+}
+
+STATIC void mpool_hash_remove(MPOOL *mp, mpool_bkt_t *bp) {
+    mpool_bkt_t **link = mpool_hash_chain(mp, bp->pgno);
+    while (*link != bp) {
+        link = &(*link)->hash_next;
+    }
+    *link = bp->hash_next;
+}
+
+// Give back a slot that doesn't hold a page.
+STATIC void mpool_release(MPOOL *mp, mpool_bkt_t *bp) {
+    if (mpool_in_arena(mp, bp)) {
+        bp->next = mp->free;
+        mp->free = bp;
+    } else {
+        free(bp);
+    }
+}
+
+STATIC int mpool_write(MPOOL *mp, mpool_bkt_t *bp) {
+    void *page = BKT_PAGE(bp);
+    if (mp->pgout != NULL) {
+        mp->pgout(mp->pgcookie, bp->pgno, page);
+    }
+    off_t off = (off_t)mp->pagesize * bp->pgno;
+    bool ok = mp->fvtable->lseek(mp->fd, off, SEEK_SET) == off
+        && mp->fvtable->write(mp->fd, page, mp->pagesize) == (ssize_t)mp->pagesize;
+    // the output filter may have changed the in-core copy
+    if (mp->pgin != NULL) {
+        mp->pgin(mp->pgcookie, bp->pgno, page);
+    }
+    if (!ok) {
+        return RET_ERROR;
+    }
+    bp->flags &= ~MPOOL_DIRTY;
+    return RET_SUCCESS;
+}
+
+// Get a slot for a page: a free one in the arena, else the least recently
+// used page that isn't pinned, written first if it's dirty.
+STATIC mpool_bkt_t *mpool_bkt(MPOOL *mp) {
+    mpool_bkt_t *bp = mp->free;
+    if (bp != NULL) {
+        mp->free = bp->next;
+        return bp;
+    }
+    bp = mp->lru_head;
+    if (bp != NULL) {
+        if ((bp->flags & MPOOL_DIRTY) && mpool_write(mp, bp) == RET_ERROR) {
+            return NULL;
+        }
+        mpool_lru_remove(mp, bp);
+        mpool_hash_remove(mp, bp);
+        return bp;
+    }
+    // Every page is pinned.  This page stays in the cache, so the cache
+    // grows by one page until the pool is closed.
+    return malloc(mp->slot_size);
+}
+
+// Pin a new page in a slot from mpool_bkt().
+STATIC void *mpool_pin(MPOOL *mp, mpool_bkt_t *bp, pgno_t pgno) {
+    mpool_bkt_t **chain = mpool_hash_chain(mp, pgno);
+    bp->pgno = pgno;
+    bp->flags = MPOOL_PINNED;
+    bp->hash_next = *chain;
+    *chain = bp;
+    return BKT_PAGE(bp);
+}
+
+MPOOL *mpool_open(void *key, virt_fd_t fd, const FILEVTABLE *fvtable, pgno_t pagesize, pgno_t maxcache) {
+    (void)key;
+    off_t size = fvtable->lseek(fd, 0, SEEK_END);
+    if (size == -1) {
+        return NULL;
+    }
+    if (maxcache == 0) {
+        maxcache = 1;
+    }
+    pgno_t hash_size = 1;
+    while (hash_size < maxcache) {
+        hash_size <<= 1;
+    }
+
+    MPOOL *mp = calloc(1, sizeof(MPOOL));
+    if (mp == NULL) {
+        return NULL;
+    }
+    // keep each page aligned like the bucket in front of it
+    mp->slot_size = (sizeof(mpool_bkt_t) + pagesize + sizeof(mpool_bkt_t*) - 1) & ~(sizeof(mpool_bkt_t*) - 1);
+    mp->hash = calloc(hash_size, sizeof(*mp->hash));
+    mp->arena = malloc(mp->slot_size * maxcache);
+    if (mp->hash == NULL || mp->arena == NULL) {
+        free(mp->hash);
+        free(mp->arena);
+        free(mp);
+        return NULL;
+    }
+    mp->hash_mask = hash_size - 1;
+    mp->arena_end = mp->arena + mp->slot_size * maxcache;
+    for (char *slot = mp->arena; slot < mp->arena_end; slot += mp->slot_size) {
+        mpool_release(mp, (mpool_bkt_t*)slot);
+    }
+    mp->npages = size / pagesize;
+    mp->pagesize = pagesize;
+    mp->fd = fd;
+    mp->fvtable = fvtable;
+    return mp;
+}
+
+void mpool_filter(MPOOL *mp, void (*pgin)(void *, pgno_t, void *), void (*pgout)(void *, pgno_t, void *), void *pgcookie) {
+    mp->pgin = pgin;
+    mp->pgout = pgout;
+    mp->pgcookie = pgcookie;
+}
+
+void *mpool_new(MPOOL *mp, pgno_t *pgnoaddr) {
+    if (mp->npages == (pgno_t)-1) {
+        errno = ENOSPC;
+        return NULL;
+    }
+    mpool_bkt_t *bp = mpool_bkt(mp);
+    if (bp == NULL) {
+        return NULL;
+    }
+    *pgnoaddr = mp->npages++;
+    return mpool_pin(mp, bp, *pgnoaddr);
+}
+
+void *mpool_get(MPOOL *mp, pgno_t pgno, unsigned int flags) {
+    (void)flags;
+    if (pgno >= mp->npages) {
+        errno = EINVAL;
+        return NULL;
+    }
+    for (mpool_bkt_t *bp = *mpool_hash_chain(mp, pgno); bp != NULL; bp = bp->hash_next) {
+        if (bp->pgno == pgno) {
+            if (!(bp->flags & MPOOL_PINNED)) {
+                mpool_lru_remove(mp, bp);
+                bp->flags |= MPOOL_PINNED;
+            }
+            return BKT_PAGE(bp);
+        }
+    }
+
+    mpool_bkt_t *bp = mpool_bkt(mp);
+    if (bp == NULL) {
+        return NULL;
+    }
+    off_t off = (off_t)mp->pagesize * pgno;
+    if (mp->fvtable->lseek(mp->fd, off, SEEK_SET) != off) {
+        mpool_release(mp, bp);
+        return NULL;
+    }
+    ssize_t nr = mp->fvtable->read(mp->fd, BKT_PAGE(bp), mp->pagesize);
+    if (nr != (ssize_t)mp->pagesize) {
+        if (nr >= 0) {
+            // a short page: the file isn't a btree file
+            errno = EINVAL;
+        }
+        mpool_release(mp, bp);
+        return NULL;
+    }
+    void *page = mpool_pin(mp, bp, pgno);
+    if (mp->pgin != NULL) {
+        mp->pgin(mp->pgcookie, pgno, page);
+    }
+    return page;
+}
+
+int mpool_put(MPOOL *mp, void *page, unsigned int flags) {
+    mpool_bkt_t *bp = PAGE_BKT(page);
+    bp->flags |= flags & MPOOL_DIRTY;
+    if (bp->flags & MPOOL_PINNED) {
+        bp->flags &= ~MPOOL_PINNED;
+        mpool_lru_append(mp, bp);
+    }
+    return RET_SUCCESS;
+}
+
+int mpool_sync(MPOOL *mp) {
+    for (pgno_t i = 0; i <= mp->hash_mask; i++) {
+        for (mpool_bkt_t *bp = mp->hash[i]; bp != NULL; bp = bp->hash_next) {
+            if ((bp->flags & MPOOL_DIRTY) && mpool_write(mp, bp) == RET_ERROR) {
+                return RET_ERROR;
+            }
+        }
+    }
+    return mp->fvtable->fsync(mp->fd) ? RET_ERROR : RET_SUCCESS;
+}
+
+int mpool_close(MPOOL *mp) {
+    // pages allocated when every page was pinned are outside the arena
+    for (pgno_t i = 0; i <= mp->hash_mask; i++) {
+        mpool_bkt_t *bp = mp->hash[i];
+        while (bp != NULL) {
+            mpool_bkt_t *next = bp->hash_next;
+            if (!mpool_in_arena(mp, bp)) {
+                free(bp);
+            }
+            bp = next;
+        }
+    }
+    free(mp->arena);
+    free(mp->hash);
+    free(mp);
+    return RET_SUCCESS;
+}
+
+#endif // MICROPY_PY_BTREE
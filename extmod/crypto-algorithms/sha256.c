@@ -14,14 +14,15 @@
 
 /*************************** HEADER FILES ***************************/
 #include <stdlib.h>
+#include <string.h>
 #include "sha256.h"
 
 /****************************** MACROS ******************************/
 #define ROTLEFT(a,b) (((a) << (b)) | ((a) >> (32-(b))))
 #define ROTRIGHT(a,b) (((a) >> (b)) | ((a) << (32-(b))))
 
-#define CH(x,y,z) (((x) & (y)) ^ (~(x) & (z)))
-#define MAJ(x,y,z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define CH(x,y,z) ((z) ^ ((x) & ((y) ^ (z))))
+#define MAJ(x,y,z) (((x) & (y)) | ((z) & ((x) | (y))))
 #define EP0(x) (ROTRIGHT(x,2) ^ ROTRIGHT(x,13) ^ ROTRIGHT(x,22))
 #define EP1(x) (ROTRIGHT(x,6) ^ ROTRIGHT(x,11) ^ ROTRIGHT(x,25))
 #define SIG0(x) (ROTRIGHT(x,7) ^ ROTRIGHT(x,18) ^ ((x) >> 3))
@@ -40,14 +41,33 @@ static const WORD k[64] = {
 };
 
 /*********************** FUNCTION DEFINITIONS ***********************/
+// The message schedule is kept as a rolling window of 16 words, and the
+// rounds are unrolled 8 at a time so that the working variables rotate by
+// renaming instead of being shifted through a-h on every round.
+#define LOAD_BE32(p) (((WORD)(p)[0] << 24) | ((WORD)(p)[1] << 16) | ((WORD)(p)[2] << 8) | ((WORD)(p)[3]))
+#define SCHED(i) (m[(i) & 15] += SIG1(m[((i) - 2) & 15]) + m[((i) - 7) & 15] + SIG0(m[((i) - 15) & 15]))
+
+#define RND(a,b,c,d,e,f,g,h,i) \
+	t1 = h + EP1(e) + CH(e,f,g) + k[i] + W(i); \
+	d += t1; \
+	h = t1 + EP0(a) + MAJ(a,b,c)
+
+#define RND8(i) \
+	RND(a,b,c,d,e,f,g,h,(i)); \
+	RND(h,a,b,c,d,e,f,g,(i) + 1); \
+	RND(g,h,a,b,c,d,e,f,(i) + 2); \
+	RND(f,g,h,a,b,c,d,e,(i) + 3); \
+	RND(e,f,g,h,a,b,c,d,(i) + 4); \
+	RND(d,e,f,g,h,a,b,c,(i) + 5); \
+	RND(c,d,e,f,g,h,a,b,(i) + 6); \
+	RND(b,c,d,e,f,g,h,a,(i) + 7)
+
 static void sha256_transform(CRYAL_SHA256_CTX *ctx, const BYTE data[])
 {
-	WORD a, b, c, d, e, f, g, h, i, j, t1, t2, m[64];
+	WORD a, b, c, d, e, f, g, h, i, t1, m[16];
 
-	for (i = 0, j = 0; i < 16; ++i, j += 4)
-		m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
-	for ( ; i < 64; ++i)
-		m[i] = SIG1(m[i - 2]) + m[i - 7] + SIG0(m[i - 15]) + m[i - 16];
+	for (i = 0; i < 16; ++i)
+		m[i] = LOAD_BE32(data + i * 4);
 
 	a = ctx->state[0];
 	b = ctx->state[1];
@@ -58,18 +78,16 @@ static void sha256_transform(CRYAL_SHA256_CTX *ctx, const BYTE data[])
 	g = ctx->state[6];
 	h = ctx->state[7];
 
-	for (i = 0; i < 64; ++i) {
-		t1 = h + EP1(e) + CH(e,f,g) + k[i] + m[i];
-		t2 = EP0(a) + MAJ(a,b,c);
-		h = g;
-		g = f;
-		f = e;
-		e = d + t1;
-		d = c;
-		c = b;
-		b = a;
-		a = t1 + t2;
+#define W(i) m[i]
+	RND8(0);
+	RND8(8);
+#undef W
+#define W(i) SCHED(i)
+	for (i = 16; i < 64; i += 16) {
+		RND8(i);
+		RND8(i + 8);
 	}
+#undef W
 
 	ctx->state[0] += a;
 	ctx->state[1] += b;
@@ -97,17 +115,30 @@ void sha256_init(CRYAL_SHA256_CTX *ctx)
 
 void sha256_update(CRYAL_SHA256_CTX *ctx, const BYTE data[], size_t len)
 {
-	WORD i;
+	// Top up a partially filled block first
+	if (ctx->datalen != 0) {
+		size_t n = 64 - ctx->datalen;
+		if (n > len)
+			n = len;
+		memcpy(ctx->data + ctx->datalen, data, n);
+		ctx->datalen += n;
+		data += n;
+		len -= n;
+		if (ctx->datalen < 64)
+			return;
+		sha256_transform(ctx, ctx->data);
+		ctx->bitlen += 512;
+		ctx->datalen = 0;
+	}
 
-	for (i = 0; i < len; ++i) {
-		ctx->data[ctx->datalen] = data[i];
-		ctx->datalen++;
-		if (ctx->datalen == 64) {
-			sha256_transform(ctx, ctx->data);
-			ctx->bitlen += 512;
-			ctx->datalen = 0;
-		}
+	// Whole blocks are hashed straight from the caller's buffer
+	for (; len >= 64; data += 64, len -= 64) {
+		sha256_transform(ctx, data);
+		ctx->bitlen += 512;
 	}
+
+	memcpy(ctx->data, data, len);
+	ctx->datalen = len;
 }
 
 void sha256_final(CRYAL_SHA256_CTX *ctx, BYTE hash[])
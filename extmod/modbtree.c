@@ -31,6 +31,8 @@
 
 #include "py/runtime.h"
 #include "py/stream.h"
+#include "py/objarray.h"
+#include "py/objlist.h"
 
 #if MICROPY_PY_BTREE
 
@@ -69,6 +71,7 @@ STATIC mp_obj_btree_t *btree_new(DB *db) {
     o->db = db;
     o->start_key = mp_const_none;
     o->end_key = mp_const_none;
+    o->flags = FLAG_ITER_KEYS;
     o->next_flags = 0;
     return o;
 }
@@ -190,27 +193,32 @@ STATIC mp_obj_t btree_getiter(mp_obj_t self_in, mp_obj_iter_buf_t *iter_buf) {
     return self_in;
 }
 
-STATIC mp_obj_t btree_iternext(mp_obj_t self_in) {
-    mp_obj_btree_t *self = MP_OBJ_TO_PTR(self_in);
-    DBT key, val;
+// Fetch the next record of the range set up by btree_getiter() into key/val,
+// returning false once the range is exhausted.  The data of key/val point into
+// a cache page and stay valid only until the next operation on the database.
+STATIC bool btree_iter_fetch(mp_obj_btree_t *self, DBT *key, DBT *val) {
     int res;
     bool desc = self->flags & FLAG_DESC;
+    if (self->end_key == MP_OBJ_NULL) {
+        // range already finished
+        return false;
+    }
     if (self->start_key != MP_OBJ_NULL) {
         int flags = R_FIRST;
         if (self->start_key != mp_const_none) {
-            key.data = (void*)mp_obj_str_get_data(self->start_key, &key.size);
+            key->data = (void*)mp_obj_str_get_data(self->start_key, &key->size);
             flags = R_CURSOR;
         } else if (desc) {
             flags = R_LAST;
         }
-        res = __bt_seq(self->db, &key, &val, flags);
+        res = __bt_seq(self->db, key, val, flags);
         self->start_key = MP_OBJ_NULL;
     } else {
-        res = __bt_seq(self->db, &key, &val, desc ? R_PREV : R_NEXT);
+        res = __bt_seq(self->db, key, val, desc ? R_PREV : R_NEXT);
     }
 
     if (res == RET_SPECIAL) {
-        return MP_OBJ_STOP_ITERATION;
+        return false;
     }
     CHECK_ERROR(res);
 
@@ -218,7 +226,7 @@ STATIC mp_obj_t btree_iternext(mp_obj_t self_in) {
         DBT end_key;
         end_key.data = (void*)mp_obj_str_get_data(self->end_key, &end_key.size);
         BTREE *t = self->db->internal;
-        int cmp = t->bt_cmp(&key, &end_key);
+        int cmp = t->bt_cmp(key, &end_key);
         if (desc) {
             cmp = -cmp;
         }
@@ -227,9 +235,18 @@ STATIC mp_obj_t btree_iternext(mp_obj_t self_in) {
         }
         if (cmp >= 0) {
             self->end_key = MP_OBJ_NULL;
-            return MP_OBJ_STOP_ITERATION;
+            return false;
         }
     }
+    return true;
+}
+
+STATIC mp_obj_t btree_iternext(mp_obj_t self_in) {
+    mp_obj_btree_t *self = MP_OBJ_TO_PTR(self_in);
+    DBT key, val;
+    if (!btree_iter_fetch(self, &key, &val)) {
+        return MP_OBJ_STOP_ITERATION;
+    }
 
     switch (self->flags & FLAG_ITER_TYPE_MASK) {
         case FLAG_ITER_KEYS:
@@ -246,6 +263,81 @@ STATIC mp_obj_t btree_iternext(mp_obj_t self_in) {
     }
 }
 
+#if MICROPY_PY_BUILTINS_MEMORYVIEW
+// Point views->items[i] at len bytes of buf starting at offset, reusing the
+// memoryview already in that slot if it was handed out by a previous scan.
+STATIC void btree_scan_set_view(mp_obj_list_t *views, size_t i, void *buf, size_t offset, size_t len) {
+    mp_obj_t view_in = views->items[i];
+    if (MP_OBJ_IS_TYPE(view_in, &mp_type_memoryview)) {
+        mp_obj_array_t *view = MP_OBJ_TO_PTR(view_in);
+        if (view->items == buf && view->typecode == 'B') {
+            view->free = offset;
+            view->len = len;
+            return;
+        }
+    }
+    mp_obj_array_t *view = MP_OBJ_TO_PTR(mp_obj_new_memoryview('B', len, buf));
+    view->free = offset;
+    views->items[i] = MP_OBJ_FROM_PTR(view);
+}
+
+// Batched form of iteration: copy as many of the following records as fit
+// into buf, and fill the list views with memoryviews of them (keys, values
+// or alternating key/value as set up by keys(), values() or items()).  The
+// views are reused from call to call, so a scan in steady state allocates
+// nothing per record.  Returns the number of records, 0 at the end.
+STATIC mp_obj_t btree_scan(mp_obj_t self_in, mp_obj_t buf_in, mp_obj_t views_in) {
+    mp_obj_btree_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_WRITE);
+    if (!MP_OBJ_IS_TYPE(views_in, &mp_type_list)) {
+        mp_raise_TypeError(NULL);
+    }
+    mp_obj_list_t *views = MP_OBJ_TO_PTR(views_in);
+
+    if (self->next_flags != 0) {
+        btree_getiter(self_in, NULL);
+    }
+
+    size_t per_record = (self->flags & FLAG_ITER_TYPE_MASK) == FLAG_ITER_ITEMS ? 2 : 1;
+    byte *buf = bufinfo.buf;
+    size_t offset = 0;
+    size_t n = 0;
+    DBT key, val;
+    while ((n + 1) * per_record <= views->len && btree_iter_fetch(self, &key, &val)) {
+        size_t need = 0;
+        if ((self->flags & FLAG_ITER_TYPE_MASK) != FLAG_ITER_VALUES) {
+            need += key.size;
+        }
+        if ((self->flags & FLAG_ITER_TYPE_MASK) != FLAG_ITER_KEYS) {
+            need += val.size;
+        }
+        if (offset + need > bufinfo.len) {
+            if (n == 0) {
+                mp_raise_ValueError(translate("buffer too small"));
+            }
+            // Resume from this record on the next call
+            self->start_key = mp_obj_new_bytes(key.data, key.size);
+            break;
+        }
+        size_t i = n * per_record;
+        if ((self->flags & FLAG_ITER_TYPE_MASK) != FLAG_ITER_VALUES) {
+            memcpy(buf + offset, key.data, key.size);
+            btree_scan_set_view(views, i++, buf, offset, key.size);
+            offset += key.size;
+        }
+        if ((self->flags & FLAG_ITER_TYPE_MASK) != FLAG_ITER_KEYS) {
+            memcpy(buf + offset, val.data, val.size);
+            btree_scan_set_view(views, i, buf, offset, val.size);
+            offset += val.size;
+        }
+        n++;
+    }
+    return MP_OBJ_NEW_SMALL_INT(n);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(btree_scan_obj, btree_scan);
+#endif
+
 STATIC mp_obj_t btree_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
     mp_obj_btree_t *self = MP_OBJ_TO_PTR(self_in);
     if (value == MP_OBJ_NULL) {
@@ -304,6 +396,9 @@ STATIC const mp_rom_map_elem_t btree_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_keys), MP_ROM_PTR(&btree_keys_obj) },
     { MP_ROM_QSTR(MP_QSTR_values), MP_ROM_PTR(&btree_values_obj) },
     { MP_ROM_QSTR(MP_QSTR_items), MP_ROM_PTR(&btree_items_obj) },
+    #if MICROPY_PY_BUILTINS_MEMORYVIEW
+    { MP_ROM_QSTR(MP_QSTR_scan), MP_ROM_PTR(&btree_scan_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(btree_locals_dict, btree_locals_dict_table);
@@ -44,11 +44,17 @@ typedef struct _mp_obj_framebuf_t {
 typedef void (*setpixel_t)(const mp_obj_framebuf_t*, int, int, uint32_t);
 typedef uint32_t (*getpixel_t)(const mp_obj_framebuf_t*, int, int);
 typedef void (*fill_rect_t)(const mp_obj_framebuf_t *, int, int, int, int, uint32_t);
+// Read n pixels of row y into buf, sampling at x, x + step, ... in 16.16 fixed point.
+typedef void (*read_row_t)(const mp_obj_framebuf_t*, uint32_t, uint32_t, int, int, uint16_t*);
+// Write n pixels from buf to row y starting at x, skipping those equal to key.
+typedef void (*write_row_t)(const mp_obj_framebuf_t*, int, int, int, const uint16_t*, uint32_t);
 
 typedef struct _mp_framebuf_p_t {
     setpixel_t setpixel;
     getpixel_t getpixel;
     fill_rect_t fill_rect;
+    read_row_t read_row;
+    write_row_t write_row;
 } mp_framebuf_p_t;
 
 // constants for formats
@@ -88,6 +94,28 @@ STATIC void mono_horiz_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int
     }
 }
 
+STATIC void mono_horiz_read_row(const mp_obj_framebuf_t *fb, uint32_t x, uint32_t step, int y, int n, uint16_t *buf) {
+    const uint8_t *row = &((uint8_t*)fb->buf)[(y * fb->stride) >> 3];
+    int reverse = fb->format == FRAMEBUF_MHMSB;
+    for (; n; --n, x += step) {
+        uint32_t xx = x >> 16;
+        int offset = reverse ? xx & 7 : 7 - (xx & 7);
+        *buf++ = (row[xx >> 3] >> offset) & 0x01;
+    }
+}
+
+STATIC void mono_horiz_write_row(const mp_obj_framebuf_t *fb, int x, int y, int n, const uint16_t *buf, uint32_t key) {
+    uint8_t *row = &((uint8_t*)fb->buf)[(y * fb->stride) >> 3];
+    int reverse = fb->format == FRAMEBUF_MHMSB;
+    for (; n; --n, ++x) {
+        uint32_t col = *buf++;
+        if (col != key) {
+            int offset = reverse ? x & 7 : 7 - (x & 7);
+            row[x >> 3] = (row[x >> 3] & ~(0x01 << offset)) | ((col != 0) << offset);
+        }
+    }
+}
+
 // Functions for MVLSB format
 
 STATIC void mvlsb_setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
@@ -112,6 +140,25 @@ STATIC void mvlsb_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, in
     }
 }
 
+STATIC void mvlsb_read_row(const mp_obj_framebuf_t *fb, uint32_t x, uint32_t step, int y, int n, uint16_t *buf) {
+    const uint8_t *row = &((uint8_t*)fb->buf)[(y >> 3) * fb->stride];
+    uint8_t offset = y & 0x07;
+    for (; n; --n, x += step) {
+        *buf++ = (row[x >> 16] >> offset) & 0x01;
+    }
+}
+
+STATIC void mvlsb_write_row(const mp_obj_framebuf_t *fb, int x, int y, int n, const uint16_t *buf, uint32_t key) {
+    uint8_t *b = &((uint8_t*)fb->buf)[(y >> 3) * fb->stride + x];
+    uint8_t offset = y & 0x07;
+    for (; n; --n, ++b) {
+        uint32_t col = *buf++;
+        if (col != key) {
+            *b = (*b & ~(0x01 << offset)) | ((col != 0) << offset);
+        }
+    }
+}
+
 // Functions for RGB565 format
 
 STATIC void rgb565_setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
@@ -132,6 +179,23 @@ STATIC void rgb565_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, i
     }
 }
 
+STATIC void rgb565_read_row(const mp_obj_framebuf_t *fb, uint32_t x, uint32_t step, int y, int n, uint16_t *buf) {
+    const uint16_t *row = &((uint16_t*)fb->buf)[y * fb->stride];
+    for (; n; --n, x += step) {
+        *buf++ = row[x >> 16];
+    }
+}
+
+STATIC void rgb565_write_row(const mp_obj_framebuf_t *fb, int x, int y, int n, const uint16_t *buf, uint32_t key) {
+    uint16_t *b = &((uint16_t*)fb->buf)[x + y * fb->stride];
+    for (; n; --n, ++b) {
+        uint32_t col = *buf++;
+        if (col != key) {
+            *b = col;
+        }
+    }
+}
+
 // Functions for GS2_HMSB format
 
 STATIC void gs2_hmsb_setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
@@ -156,6 +220,25 @@ STATIC void gs2_hmsb_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w,
     }
 }
 
+STATIC void gs2_hmsb_read_row(const mp_obj_framebuf_t *fb, uint32_t x, uint32_t step, int y, int n, uint16_t *buf) {
+    const uint8_t *row = &((uint8_t*)fb->buf)[(y * fb->stride) >> 2];
+    for (; n; --n, x += step) {
+        uint32_t xx = x >> 16;
+        *buf++ = (row[xx >> 2] >> ((xx & 0x3) << 1)) & 0x3;
+    }
+}
+
+STATIC void gs2_hmsb_write_row(const mp_obj_framebuf_t *fb, int x, int y, int n, const uint16_t *buf, uint32_t key) {
+    uint8_t *row = &((uint8_t*)fb->buf)[(y * fb->stride) >> 2];
+    for (; n; --n, ++x) {
+        uint32_t col = *buf++;
+        if (col != key) {
+            uint8_t shift = (x & 0x3) << 1;
+            row[x >> 2] = ((col & 0x3) << shift) | (row[x >> 2] & ~(0x3 << shift));
+        }
+    }
+}
+
 // Functions for GS4_HMSB format
 
 STATIC void gs4_hmsb_setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
@@ -207,6 +290,29 @@ STATIC void gs4_hmsb_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w,
     }
 }
 
+STATIC void gs4_hmsb_read_row(const mp_obj_framebuf_t *fb, uint32_t x, uint32_t step, int y, int n, uint16_t *buf) {
+    const uint8_t *row = &((uint8_t*)fb->buf)[(y * fb->stride) >> 1];
+    for (; n; --n, x += step) {
+        uint32_t xx = x >> 16;
+        *buf++ = (xx & 1) ? row[xx >> 1] & 0x0f : row[xx >> 1] >> 4;
+    }
+}
+
+STATIC void gs4_hmsb_write_row(const mp_obj_framebuf_t *fb, int x, int y, int n, const uint16_t *buf, uint32_t key) {
+    uint8_t *row = &((uint8_t*)fb->buf)[(y * fb->stride) >> 1];
+    for (; n; --n, ++x) {
+        uint32_t col = *buf++;
+        if (col != key) {
+            uint8_t *pixel = &row[x >> 1];
+            if (x & 1) {
+                *pixel = ((uint8_t)col & 0x0f) | (*pixel & 0xf0);
+            } else {
+                *pixel = ((uint8_t)col << 4) | (*pixel & 0x0f);
+            }
+        }
+    }
+}
+
 // Functions for GS8 format
 
 STATIC void gs8_setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
@@ -226,16 +332,46 @@ STATIC void gs8_fill_rect(const mp_obj_framebuf_t *fb, int x, int y, int w, int
     }
 }
 
+STATIC void gs8_read_row(const mp_obj_framebuf_t *fb, uint32_t x, uint32_t step, int y, int n, uint16_t *buf) {
+    const uint8_t *row = &((uint8_t*)fb->buf)[y * fb->stride];
+    for (; n; --n, x += step) {
+        *buf++ = row[x >> 16];
+    }
+}
+
+STATIC void gs8_write_row(const mp_obj_framebuf_t *fb, int x, int y, int n, const uint16_t *buf, uint32_t key) {
+    uint8_t *b = &((uint8_t*)fb->buf)[x + y * fb->stride];
+    for (; n; --n, ++b) {
+        uint32_t col = *buf++;
+        if (col != key) {
+            *b = col & 0xff;
+        }
+    }
+}
+
 STATIC mp_framebuf_p_t formats[] = {
-    [FRAMEBUF_MVLSB] = {mvlsb_setpixel, mvlsb_getpixel, mvlsb_fill_rect},
-    [FRAMEBUF_RGB565] = {rgb565_setpixel, rgb565_getpixel, rgb565_fill_rect},
-    [FRAMEBUF_GS2_HMSB] = {gs2_hmsb_setpixel, gs2_hmsb_getpixel, gs2_hmsb_fill_rect},
-    [FRAMEBUF_GS4_HMSB] = {gs4_hmsb_setpixel, gs4_hmsb_getpixel, gs4_hmsb_fill_rect},
-    [FRAMEBUF_GS8] = {gs8_setpixel, gs8_getpixel, gs8_fill_rect},
-    [FRAMEBUF_MHLSB] = {mono_horiz_setpixel, mono_horiz_getpixel, mono_horiz_fill_rect},
-    [FRAMEBUF_MHMSB] = {mono_horiz_setpixel, mono_horiz_getpixel, mono_horiz_fill_rect},
+    [FRAMEBUF_MVLSB] = {mvlsb_setpixel, mvlsb_getpixel, mvlsb_fill_rect, mvlsb_read_row, mvlsb_write_row},
+    [FRAMEBUF_RGB565] = {rgb565_setpixel, rgb565_getpixel, rgb565_fill_rect, rgb565_read_row, rgb565_write_row},
+    [FRAMEBUF_GS2_HMSB] = {gs2_hmsb_setpixel, gs2_hmsb_getpixel, gs2_hmsb_fill_rect, gs2_hmsb_read_row, gs2_hmsb_write_row},
+    [FRAMEBUF_GS4_HMSB] = {gs4_hmsb_setpixel, gs4_hmsb_getpixel, gs4_hmsb_fill_rect, gs4_hmsb_read_row, gs4_hmsb_write_row},
+    [FRAMEBUF_GS8] = {gs8_setpixel, gs8_getpixel, gs8_fill_rect, gs8_read_row, gs8_write_row},
+    [FRAMEBUF_MHLSB] = {mono_horiz_setpixel, mono_horiz_getpixel, mono_horiz_fill_rect, mono_horiz_read_row, mono_horiz_write_row},
+    [FRAMEBUF_MHMSB] = {mono_horiz_setpixel, mono_horiz_getpixel, mono_horiz_fill_rect, mono_horiz_read_row, mono_horiz_write_row},
 };
 
+// Number of bits per pixel of formats which pack pixels along a row, or 0.
+STATIC uint8_t row_bits(const mp_obj_framebuf_t *fb) {
+    switch (fb->format) {
+        case FRAMEBUF_RGB565: return 16;
+        case FRAMEBUF_GS8: return 8;
+        case FRAMEBUF_GS4_HMSB: return 4;
+        case FRAMEBUF_GS2_HMSB: return 2;
+        case FRAMEBUF_MHLSB:
+        case FRAMEBUF_MHMSB: return 1;
+        default: return 0;
+    }
+}
+
 static inline void setpixel(const mp_obj_framebuf_t *fb, int x, int y, uint32_t col) {
     formats[fb->format].setpixel(fb, x, y, col);
 }
@@ -467,48 +603,180 @@ STATIC mp_obj_t framebuf_line(size_t n_args, const mp_obj_t *args) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_line_obj, 6, 6, framebuf_line);
 
+// Pixels are moved a chunk of a row at a time through a line buffer.
+#define BLIT_CHUNK (32)
+
+STATIC const mp_obj_type_t mp_type_framebuf;
+
+// Get the FrameBuffer passed as an argument, which may be an instance of a
+// subclass.
+STATIC mp_obj_framebuf_t *framebuf_get_arg(mp_obj_t arg) {
+    mp_obj_t native = mp_instance_cast_to_native_base(arg, MP_OBJ_FROM_PTR(&mp_type_framebuf));
+    if (native == MP_OBJ_NULL) {
+        mp_raise_TypeError(translate("expected a FrameBuffer"));
+    }
+    return MP_OBJ_TO_PTR(native);
+}
+
+// Copy source, scaled to w x h, to (x, y) of self.  Source pixels equal to
+// key are skipped, after mapping through the palette if there is one.  If
+// mask is given, or alpha isn't negative, self must be RGB565 and pixels are
+// blended into it with the 8-bit alpha values of the GS8 mask, or alpha.
+STATIC void blit_rect(const mp_obj_framebuf_t *self, const mp_obj_framebuf_t *source,
+    int x, int y, int w, int h, mp_int_t key, const mp_obj_framebuf_t *palette,
+    const mp_obj_framebuf_t *mask, int alpha) {
+    if (w < 1 || h < 1 || x >= self->width || y >= self->height || x + w <= 0 || y + h <= 0
+        || source->width == 0 || source->height == 0) {
+        // Out of bounds, no-op.
+        return;
+    }
+
+    // Clip, and find the 16.16 fixed point step through source for each
+    // pixel of self.  Pixels are sampled at their centres.
+    int x0 = MAX(0, x);
+    int y0 = MAX(0, y);
+    int x0end = MIN(self->width, x + w);
+    int y0end = MIN(self->height, y + h);
+    uint32_t xstep = ((uint32_t)source->width << 16) / w;
+    uint32_t ystep = ((uint32_t)source->height << 16) / h;
+    uint32_t xstart = (x0 - x) * xstep + (xstep >> 1);
+    uint32_t ystart = (y0 - y) * ystep + (ystep >> 1);
+    int width = x0end - x0;
+
+    // A plain copy between the same row-packed formats is done with memmove
+    // for the whole bytes of each row, leaving just the odd pixels at the end.
+    uint8_t bits = row_bits(self);
+    if (xstep == 0x10000 && ystep == 0x10000 && key == -1 && palette == NULL && mask == NULL && alpha < 0
+        && source->format == self->format && bits != 0
+        && ((x0 * bits) & 7) == 0 && (((xstart >> 16) * bits) & 7) == 0) {
+        int nbytes = (width * bits) >> 3;
+        int sy = ystart >> 16;
+        for (int yy = y0; yy < y0end; ++yy, ++sy) {
+            memmove(&((uint8_t*)self->buf)[(yy * self->stride * bits + x0 * bits) >> 3],
+                &((uint8_t*)source->buf)[(sy * source->stride * bits + (xstart >> 16) * bits) >> 3], nbytes);
+        }
+        int done = (nbytes << 3) / bits;
+        x0 += done;
+        xstart += done << 16;
+        width -= done;
+        if (width == 0) {
+            return;
+        }
+    }
+
+    read_row_t read_row = formats[source->format].read_row;
+    write_row_t write_row = formats[self->format].write_row;
+    bool blend = alpha >= 0 || mask != NULL;
+    uint16_t buf[BLIT_CHUNK];
+    uint16_t under[BLIT_CHUNK];
+    uint16_t a[BLIT_CHUNK];
+    uint32_t sy = ystart;
+    for (int yy = y0; yy < y0end; ++yy, sy += ystep) {
+        uint32_t sx = xstart;
+        for (int xx = x0; xx < x0 + width; xx += BLIT_CHUNK, sx += xstep * BLIT_CHUNK) {
+            int n = MIN(BLIT_CHUNK, x0 + width - xx);
+            read_row(source, sx, xstep, sy >> 16, n, buf);
+            if (palette != NULL) {
+                for (int i = 0; i < n; ++i) {
+                    if (buf[i] < palette->width) {
+                        buf[i] = getpixel(palette, buf[i], 0);
+                    }
+                }
+            }
+            if (blend) {
+                // blend each channel of RGB565 using 5-bit alpha
+                rgb565_read_row(self, xx << 16, 0x10000, yy, n, under);
+                if (mask != NULL) {
+                    gs8_read_row(mask, sx, xstep, sy >> 16, n, a);
+                }
+                for (int i = 0; i < n; ++i) {
+                    if (buf[i] == (uint32_t)key) {
+                        buf[i] = under[i];
+                        continue;
+                    }
+                    uint32_t a5 = ((mask != NULL ? a[i] : alpha) + 4) >> 3;
+                    uint32_t s = (buf[i] | (buf[i] << 16)) & 0x07e0f81f;
+                    uint32_t d = (under[i] | (under[i] << 16)) & 0x07e0f81f;
+                    d = (d + (((s - d) * a5) >> 5)) & 0x07e0f81f;
+                    buf[i] = d | (d >> 16);
+                }
+            }
+            write_row(self, xx, yy, n, buf, blend ? (uint32_t)-1 : (uint32_t)key);
+        }
+    }
+}
+
 STATIC mp_obj_t framebuf_blit(size_t n_args, const mp_obj_t *args) {
     mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(args[0]);
-    mp_obj_framebuf_t *source = MP_OBJ_TO_PTR(args[1]);
+    mp_obj_framebuf_t *source = framebuf_get_arg(args[1]);
     mp_int_t x = mp_obj_get_int(args[2]);
     mp_int_t y = mp_obj_get_int(args[3]);
     mp_int_t key = -1;
     if (n_args > 4) {
         key = mp_obj_get_int(args[4]);
     }
+    mp_obj_framebuf_t *palette = NULL;
+    if (n_args > 5 && args[5] != mp_const_none) {
+        palette = framebuf_get_arg(args[5]);
+    }
 
-    if (
-        (x >= self->width) ||
-        (y >= self->height) ||
-        (-x >= source->width) ||
-        (-y >= source->height)
-    ) {
-        // Out of bounds, no-op.
-        return mp_const_none;
+    blit_rect(self, source, x, y, source->width, source->height, key, palette, NULL, -1);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_blit_obj, 4, 6, framebuf_blit);
+
+STATIC mp_obj_t framebuf_blit_scaled(size_t n_args, const mp_obj_t *args) {
+    mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_obj_framebuf_t *source = framebuf_get_arg(args[1]);
+    mp_int_t x = mp_obj_get_int(args[2]);
+    mp_int_t y = mp_obj_get_int(args[3]);
+    mp_int_t w = mp_obj_get_int(args[4]);
+    mp_int_t h = mp_obj_get_int(args[5]);
+    mp_int_t key = -1;
+    if (n_args > 6) {
+        key = mp_obj_get_int(args[6]);
+    }
+    mp_obj_framebuf_t *palette = NULL;
+    if (n_args > 7 && args[7] != mp_const_none) {
+        palette = framebuf_get_arg(args[7]);
     }
 
-    // Clip.
-    int x0 = MAX(0, x);
-    int y0 = MAX(0, y);
-    int x1 = MAX(0, -x);
-    int y1 = MAX(0, -y);
-    int x0end = MIN(self->width, x + source->width);
-    int y0end = MIN(self->height, y + source->height);
-
-    for (; y0 < y0end; ++y0) {
-        int cx1 = x1;
-        for (int cx0 = x0; cx0 < x0end; ++cx0) {
-            uint32_t col = getpixel(source, cx1, y1);
-            if (col != (uint32_t)key) {
-                setpixel(self, cx0, y0, col);
-            }
-            ++cx1;
+    // keep the fixed point source position within 32 bits
+    if (w > 0xffff || h > 0xffff) {
+        mp_raise_ValueError(translate("invalid dimensions"));
+    }
+    blit_rect(self, source, x, y, w, h, key, palette, NULL, -1);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_blit_scaled_obj, 6, 8, framebuf_blit_scaled);
+
+STATIC mp_obj_t framebuf_blend(size_t n_args, const mp_obj_t *args) {
+    mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_obj_framebuf_t *source = framebuf_get_arg(args[1]);
+    mp_int_t x = mp_obj_get_int(args[2]);
+    mp_int_t y = mp_obj_get_int(args[3]);
+    mp_obj_framebuf_t *mask = NULL;
+    mp_int_t alpha = -1;
+    if (mp_obj_is_integer(args[4])) {
+        alpha = MIN(255, MAX(0, mp_obj_get_int(args[4])));
+    } else {
+        mask = framebuf_get_arg(args[4]);
+        if (mask->format != FRAMEBUF_GS8 || mask->width < source->width || mask->height < source->height) {
+            mp_raise_ValueError(translate("alpha mask must be GS8 and cover the source"));
         }
-        ++y1;
     }
+    mp_int_t key = -1;
+    if (n_args > 5) {
+        key = mp_obj_get_int(args[5]);
+    }
+    if (self->format != FRAMEBUF_RGB565) {
+        mp_raise_ValueError(translate("blend needs an RGB565 FrameBuffer"));
+    }
+
+    blit_rect(self, source, x, y, source->width, source->height, key, NULL, mask, alpha);
     return mp_const_none;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_blit_obj, 4, 5, framebuf_blit);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(framebuf_blend_obj, 5, 6, framebuf_blend);
 
 STATIC mp_obj_t framebuf_scroll(mp_obj_t self_in, mp_obj_t xstep_in, mp_obj_t ystep_in) {
     mp_obj_framebuf_t *self = MP_OBJ_TO_PTR(self_in);
@@ -589,6 +857,8 @@ STATIC const mp_rom_map_elem_t framebuf_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_rect), MP_ROM_PTR(&framebuf_rect_obj) },
     { MP_ROM_QSTR(MP_QSTR_line), MP_ROM_PTR(&framebuf_line_obj) },
     { MP_ROM_QSTR(MP_QSTR_blit), MP_ROM_PTR(&framebuf_blit_obj) },
+    { MP_ROM_QSTR(MP_QSTR_blit_scaled), MP_ROM_PTR(&framebuf_blit_scaled_obj) },
+    { MP_ROM_QSTR(MP_QSTR_blend), MP_ROM_PTR(&framebuf_blend_obj) },
     { MP_ROM_QSTR(MP_QSTR_scroll), MP_ROM_PTR(&framebuf_scroll_obj) },
     { MP_ROM_QSTR(MP_QSTR_text), MP_ROM_PTR(&framebuf_text_obj) },
 };
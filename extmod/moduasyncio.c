@@ -0,0 +1,483 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "py/builtin.h"
+#include "py/mphal.h"
+#include "py/mpstate.h"
+#include "py/runtime.h"
+#include "py/smallint.h"
+#include "py/stream.h"
+#include "extmod/modutimeq.h"
+
+#include "supervisor/shared/translate.h"
+
+#if MICROPY_PY_UASYNCIO
+
+#define MODULO MICROPY_PY_UTIME_TICKS_PERIOD
+
+// Initial size of the timer queue. It grows when more tasks sleep at once.
+#define TIMER_QUEUE_ALLOC (8)
+
+// What a task is doing. A task that awaits something sets its state and then
+// yields uasyncio_yield_obj so the loop knows where to put it.
+typedef enum {
+    TASK_READY,
+    TASK_SLEEPING,
+    TASK_WAITING_IO,
+    TASK_WAITING_TASK,
+    TASK_DONE,
+} task_state_t;
+
+typedef struct _mp_obj_task_t {
+    mp_obj_base_t base;
+    mp_obj_t coro;
+    // Next task in the ready or I/O queue.
+    struct _mp_obj_task_t *next;
+    // Task awaiting this one to finish.
+    struct _mp_obj_task_t *waiter;
+    // Milliseconds to sleep, object to poll, or the result once done.
+    mp_obj_t data;
+    mp_uint_t io_events;
+    task_state_t state;
+    // Set when about to yield to the loop and cleared by the loop.
+    bool yielding;
+    // Done because of an exception, which is in data.
+    bool failed;
+    // Resume by throwing the exception in data into the task.
+    bool throw;
+} mp_obj_task_t;
+
+typedef struct _uasyncio_loop_t {
+    mp_obj_task_t *ready_head;
+    mp_obj_task_t *ready_tail;
+    mp_obj_task_t *current;
+    mp_obj_t timers;
+    #if MICROPY_PY_UASYNCIO_POLL
+    mp_obj_task_t *io_head;
+    mp_obj_t poller;
+    #endif
+    bool running;
+} uasyncio_loop_t;
+
+STATIC const mp_obj_type_t task_type;
+STATIC const mp_obj_base_t uasyncio_yield_obj;
+
+STATIC mp_int_t ticks_diff(mp_uint_t end, mp_uint_t start) {
+    return ((end - start + MODULO / 2) & (MODULO - 1)) - MODULO / 2;
+}
+
+STATIC uasyncio_loop_t *get_loop(void) {
+    uasyncio_loop_t *loop = MP_STATE_VM(uasyncio_loop);
+    if (loop == NULL) {
+        loop = m_new0(uasyncio_loop_t, 1);
+        loop->timers = mp_utimeq_new(TIMER_QUEUE_ALLOC);
+        MP_STATE_VM(uasyncio_loop) = loop;
+    }
+    return loop;
+}
+
+STATIC mp_obj_task_t *current_task(void) {
+    uasyncio_loop_t *loop = MP_STATE_VM(uasyncio_loop);
+    if (loop == NULL || loop->current == NULL) {
+        mp_raise_RuntimeError(translate("not in a task"));
+    }
+    return loop->current;
+}
+
+STATIC void ready_push(uasyncio_loop_t *loop, mp_obj_task_t *task) {
+    task->state = TASK_READY;
+    task->next = NULL;
+    if (loop->ready_tail == NULL) {
+        loop->ready_head = task;
+    } else {
+        loop->ready_tail->next = task;
+    }
+    loop->ready_tail = task;
+}
+
+STATIC mp_obj_task_t *ready_pop(uasyncio_loop_t *loop) {
+    mp_obj_task_t *task = loop->ready_head;
+    loop->ready_head = task->next;
+    if (loop->ready_head == NULL) {
+        loop->ready_tail = NULL;
+    }
+    task->next = NULL;
+    return task;
+}
+
+// Yield to the loop after setting the current task's state.
+STATIC mp_obj_t yield_to_loop(mp_obj_task_t *task, task_state_t state) {
+    task->state = state;
+    task->yielding = true;
+    return MP_OBJ_FROM_PTR(&uasyncio_yield_obj);
+}
+
+// The object awaited by sleep and wait_io. It yields to the loop once and
+// completes when the loop resumes the task.
+STATIC mp_obj_t uasyncio_yield_iternext(mp_obj_t self_in) {
+    uasyncio_loop_t *loop = MP_STATE_VM(uasyncio_loop);
+    if (loop != NULL && loop->current != NULL && loop->current->yielding) {
+        return self_in;
+    }
+    return MP_OBJ_STOP_ITERATION;
+}
+
+STATIC const mp_obj_type_t uasyncio_yield_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_uasyncio,
+    .getiter = mp_identity_getiter,
+    .iternext = uasyncio_yield_iternext,
+};
+
+STATIC const mp_obj_base_t uasyncio_yield_obj = {&uasyncio_yield_type};
+
+STATIC mp_obj_task_t *task_new(mp_obj_t coro) {
+    if (!MP_OBJ_IS_TYPE(coro, &mp_type_gen_instance)) {
+        mp_raise_TypeError(translate("coroutine expected"));
+    }
+    mp_obj_task_t *task = m_new_obj(mp_obj_task_t);
+    task->base.type = &task_type;
+    task->coro = coro;
+    task->next = NULL;
+    task->waiter = NULL;
+    task->data = mp_const_none;
+    task->yielding = false;
+    task->failed = false;
+    task->throw = false;
+    ready_push(get_loop(), task);
+    return task;
+}
+
+STATIC mp_obj_t task_iternext(mp_obj_t self_in) {
+    mp_obj_task_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->state == TASK_DONE) {
+        if (self->failed) {
+            nlr_raise(self->data);
+        }
+        if (self->data == mp_const_none) {
+            return MP_OBJ_STOP_ITERATION;
+        }
+        nlr_raise(mp_obj_new_exception_arg1(&mp_type_StopIteration, self->data));
+    }
+    mp_obj_task_t *current = current_task();
+    if (self->waiter != NULL && self->waiter != current) {
+        mp_raise_RuntimeError(translate("task already awaited"));
+    }
+    self->waiter = current;
+    return yield_to_loop(current, TASK_WAITING_TASK);
+}
+
+STATIC mp_obj_t task_done(mp_obj_t self_in) {
+    mp_obj_task_t *self = MP_OBJ_TO_PTR(self_in);
+    return mp_obj_new_bool(self->state == TASK_DONE);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(task_done_obj, task_done);
+
+STATIC const mp_rom_map_elem_t task_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_done), MP_ROM_PTR(&task_done_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(task_locals_dict, task_locals_dict_table);
+
+STATIC const mp_obj_type_t task_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Task,
+    .getiter = mp_identity_getiter,
+    .iternext = task_iternext,
+    .locals_dict = (mp_obj_dict_t*)&task_locals_dict,
+};
+
+STATIC mp_obj_t uasyncio_create_task(mp_obj_t coro) {
+    return MP_OBJ_FROM_PTR(task_new(coro));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(uasyncio_create_task_obj, uasyncio_create_task);
+
+STATIC mp_obj_t uasyncio_sleep_ms(mp_obj_t ms_in) {
+    mp_obj_task_t *task = current_task();
+    mp_int_t ms = mp_obj_get_int(ms_in);
+    task->data = MP_OBJ_NEW_SMALL_INT(ms < 0 ? 0 : ms);
+    return yield_to_loop(task, TASK_SLEEPING);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(uasyncio_sleep_ms_obj, uasyncio_sleep_ms);
+
+STATIC mp_obj_t uasyncio_sleep(mp_obj_t seconds_in) {
+    #if MICROPY_PY_BUILTINS_FLOAT
+    mp_int_t ms = 1000 * mp_obj_get_float(seconds_in);
+    #else
+    mp_int_t ms = 1000 * mp_obj_get_int(seconds_in);
+    #endif
+    return uasyncio_sleep_ms(MP_OBJ_NEW_SMALL_INT(ms));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(uasyncio_sleep_obj, uasyncio_sleep);
+
+#if MICROPY_PY_UASYNCIO_POLL
+STATIC mp_obj_t uasyncio_wait_io(mp_obj_t obj, mp_obj_t events_in) {
+    mp_obj_task_t *task = current_task();
+    task->data = obj;
+    task->io_events = mp_obj_get_int(events_in);
+    return yield_to_loop(task, TASK_WAITING_IO);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(uasyncio_wait_io_obj, uasyncio_wait_io);
+
+STATIC void poller_call(uasyncio_loop_t *loop, qstr method, size_t n_args, mp_obj_t arg0, mp_obj_t arg1) {
+    mp_obj_t dest[4];
+    mp_load_method(loop->poller, method, dest);
+    dest[2] = arg0;
+    dest[3] = arg1;
+    mp_call_method_n_kw(n_args, 0, dest);
+}
+
+// The events wanted by the tasks in the I/O queue that wait on obj.
+STATIC mp_uint_t io_events_for(uasyncio_loop_t *loop, mp_obj_t obj) {
+    mp_uint_t events = 0;
+    for (mp_obj_task_t *task = loop->io_head; task != NULL; task = task->next) {
+        if (task->data == obj) {
+            events |= task->io_events;
+        }
+    }
+    return events;
+}
+
+// Register the object a task waits on, for the events that all the tasks
+// waiting on it want.  An error is thrown into the task, so that a bad object
+// doesn't stop the loop.
+STATIC void io_wait_start(uasyncio_loop_t *loop, mp_obj_task_t *task) {
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        if (loop->poller == MP_OBJ_NULL) {
+            mp_obj_t poll = mp_load_attr(MP_OBJ_FROM_PTR(&mp_module_uselect), MP_QSTR_poll);
+            loop->poller = mp_call_function_0(poll);
+        }
+        mp_uint_t events = task->io_events | io_events_for(loop, task->data);
+        poller_call(loop, MP_QSTR_register, 2, task->data, MP_OBJ_NEW_SMALL_INT(events));
+        nlr_pop();
+        task->next = loop->io_head;
+        loop->io_head = task;
+    } else {
+        task->data = MP_OBJ_FROM_PTR(nlr.ret_val);
+        task->throw = true;
+        ready_push(loop, task);
+    }
+}
+
+// Poll for up to timeout milliseconds, or forever if negative, and make
+// tasks whose events happened runnable.  Errors and hangups wake every task
+// waiting on the object.
+STATIC void io_wait(uasyncio_loop_t *loop, mp_int_t timeout) {
+    mp_obj_t dest[3];
+    mp_load_method(loop->poller, MP_QSTR_poll, dest);
+    dest[2] = MP_OBJ_NEW_SMALL_INT(timeout);
+    mp_obj_t ready = mp_call_method_n_kw(1, 0, dest);
+    size_t len;
+    mp_obj_t *items;
+    mp_obj_list_get(ready, &len, &items);
+    for (size_t i = 0; i < len; i++) {
+        mp_obj_t *entry;
+        mp_obj_get_array_fixed_n(items[i], 2, &entry);
+        mp_obj_t obj = entry[0];
+        mp_uint_t events = mp_obj_get_int(entry[1]);
+        if (events & ~(MP_STREAM_POLL_RD | MP_STREAM_POLL_WR)) {
+            events = (mp_uint_t)-1;
+        }
+        mp_obj_task_t **link = &loop->io_head;
+        while (*link != NULL) {
+            mp_obj_task_t *task = *link;
+            if (task->data == obj && (task->io_events & events)) {
+                *link = task->next;
+                ready_push(loop, task);
+            } else {
+                link = &task->next;
+            }
+        }
+        mp_uint_t waiting = io_events_for(loop, obj);
+        if (waiting == 0) {
+            poller_call(loop, MP_QSTR_unregister, 1, obj, MP_OBJ_NULL);
+        } else {
+            poller_call(loop, MP_QSTR_modify, 2, obj, MP_OBJ_NEW_SMALL_INT(waiting));
+        }
+    }
+}
+#endif
+
+// Put a task that yielded to the loop where it waits.
+STATIC void task_yielded(uasyncio_loop_t *loop, mp_obj_task_t *task, mp_obj_t value) {
+    if (value != MP_OBJ_FROM_PTR(&uasyncio_yield_obj) || !task->yielding) {
+        // A bare yield runs the other ready tasks first.
+        ready_push(loop, task);
+        return;
+    }
+    task->yielding = false;
+    switch (task->state) {
+        case TASK_SLEEPING: {
+            if (task->data == MP_OBJ_NEW_SMALL_INT(0)) {
+                ready_push(loop, task);
+                break;
+            }
+            mp_uint_t wake = mp_hal_ticks_ms() + MP_OBJ_SMALL_INT_VALUE(task->data);
+            loop->timers = mp_utimeq_push(loop->timers, wake, MP_OBJ_FROM_PTR(task), mp_const_none);
+            break;
+        }
+        #if MICROPY_PY_UASYNCIO_POLL
+        case TASK_WAITING_IO:
+            io_wait_start(loop, task);
+            break;
+        #endif
+        case TASK_WAITING_TASK:
+            // The awaited task makes this one ready when it finishes.
+            break;
+        default:
+            ready_push(loop, task);
+            break;
+    }
+}
+
+// The main task of run() counts as awaited, since run() returns its result.
+STATIC void task_finished(mp_obj_task_t *task, bool awaited, bool failed, mp_obj_t value) {
+    task->state = TASK_DONE;
+    task->failed = failed;
+    task->data = value;
+    if (failed && !mp_obj_is_subclass_fast(MP_OBJ_FROM_PTR(mp_obj_get_type(value)), MP_OBJ_FROM_PTR(&mp_type_Exception))) {
+        // KeyboardInterrupt, SystemExit and reloads stop the loop.
+        nlr_raise(value);
+    }
+    if (task->waiter != NULL) {
+        ready_push(MP_STATE_VM(uasyncio_loop), task->waiter);
+        task->waiter = NULL;
+    } else if (failed && !awaited) {
+        mp_obj_print_exception(&mp_plat_print, value);
+    }
+}
+
+STATIC void run_loop(uasyncio_loop_t *loop, mp_obj_task_t *main_task) {
+    while (main_task == NULL || main_task->state != TASK_DONE) {
+        #ifdef MICROPY_VM_HOOK_LOOP
+        MICROPY_VM_HOOK_LOOP
+        #endif
+        mp_handle_pending();
+
+        mp_uint_t now = 0;
+        if (mp_utimeq_len(loop->timers) > 0) {
+            now = mp_hal_ticks_ms() & (MODULO - 1);
+            while (mp_utimeq_len(loop->timers) > 0 && ticks_diff(mp_utimeq_peektime(loop->timers), now) <= 0) {
+                mp_obj_t args;
+                ready_push(loop, MP_OBJ_TO_PTR(mp_utimeq_pop(loop->timers, &args)));
+            }
+        }
+
+        if (loop->ready_head == NULL) {
+            mp_int_t timeout = -1;
+            if (mp_utimeq_len(loop->timers) > 0) {
+                timeout = ticks_diff(mp_utimeq_peektime(loop->timers), now);
+            }
+            #if MICROPY_PY_UASYNCIO_POLL
+            if (loop->io_head != NULL) {
+                io_wait(loop, timeout);
+                continue;
+            }
+            #endif
+            if (timeout < 0) {
+                // Nothing left that could make a task ready.
+                break;
+            }
+            mp_hal_delay_ms(timeout);
+            continue;
+        }
+
+        mp_obj_task_t *task = ready_pop(loop);
+        mp_obj_t send_value = mp_const_none;
+        mp_obj_t throw_value = MP_OBJ_NULL;
+        if (task->throw) {
+            send_value = MP_OBJ_NULL;
+            throw_value = task->data;
+            task->data = mp_const_none;
+            task->throw = false;
+        }
+        loop->current = task;
+        mp_obj_t value;
+        mp_vm_return_kind_t kind = mp_resume(task->coro, send_value, throw_value, &value);
+        loop->current = NULL;
+        if (kind == MP_VM_RETURN_YIELD) {
+            task_yielded(loop, task, value);
+        } else if (kind == MP_VM_RETURN_NORMAL) {
+            task_finished(task, task == main_task, false, value == MP_OBJ_STOP_ITERATION ? mp_const_none : value);
+        } else {
+            task_finished(task, task == main_task, true, value);
+        }
+    }
+}
+
+STATIC mp_obj_t uasyncio_run(size_t n_args, const mp_obj_t *args) {
+    uasyncio_loop_t *loop = get_loop();
+    if (loop->running) {
+        mp_raise_RuntimeError(translate("loop already running"));
+    }
+    mp_obj_task_t *main_task = NULL;
+    if (n_args > 0 && args[0] != mp_const_none) {
+        main_task = task_new(args[0]);
+    }
+    loop->running = true;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        run_loop(loop, main_task);
+        nlr_pop();
+    } else {
+        MP_STATE_VM(uasyncio_loop) = NULL;
+        nlr_jump(nlr.ret_val);
+    }
+    MP_STATE_VM(uasyncio_loop) = NULL;
+
+    if (main_task == NULL) {
+        return mp_const_none;
+    }
+    if (main_task->state != TASK_DONE) {
+        mp_raise_RuntimeError(translate("tasks are waiting on each other"));
+    }
+    if (main_task->failed) {
+        nlr_raise(main_task->data);
+    }
+    return main_task->data;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(uasyncio_run_obj, 0, 1, uasyncio_run);
+
+STATIC const mp_rom_map_elem_t mp_module_uasyncio_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_uasyncio) },
+    { MP_ROM_QSTR(MP_QSTR_Task), MP_ROM_PTR(&task_type) },
+    { MP_ROM_QSTR(MP_QSTR_create_task), MP_ROM_PTR(&uasyncio_create_task_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run), MP_ROM_PTR(&uasyncio_run_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sleep), MP_ROM_PTR(&uasyncio_sleep_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sleep_ms), MP_ROM_PTR(&uasyncio_sleep_ms_obj) },
+    #if MICROPY_PY_UASYNCIO_POLL
+    { MP_ROM_QSTR(MP_QSTR_wait_io), MP_ROM_PTR(&uasyncio_wait_io_obj) },
+    #endif
+};
+
+STATIC MP_DEFINE_CONST_DICT(mp_module_uasyncio_globals, mp_module_uasyncio_globals_table);
+
+const mp_obj_module_t mp_module_uasyncio = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&mp_module_uasyncio_globals,
+};
+
+#endif // MICROPY_PY_UASYNCIO
@@ -28,6 +28,9 @@
 #include <string.h>
 
 #include "py/runtime.h"
+#include "py/builtin.h"
+#include "py/stream.h"
+#include "py/objarray.h"
 
 #include "supervisor/shared/translate.h"
 
@@ -232,6 +235,134 @@ STATIC const mp_obj_type_t uhashlib_sha1_type = {
 };
 #endif
 
+#if MICROPY_PY_UHASHLIB_SHA256 && MICROPY_PY_UHASHLIB_HMAC
+// HMAC-SHA256 (RFC 2104) built on the sha256 object above, so it works with
+// whichever SHA-256 backend is compiled in.
+#define HMAC_SHA256_BLOCK_SIZE (64)
+
+typedef struct _mp_obj_hmac_t {
+    mp_obj_base_t base;
+    mp_obj_t inner;
+    mp_obj_t outer;
+} mp_obj_hmac_t;
+
+STATIC mp_obj_t uhashlib_hmac_sha256_update(mp_obj_t self_in, mp_obj_t arg);
+
+// Copy a sha256 object, so it can be finalised while the original is kept
+STATIC mp_obj_t uhashlib_sha256_copy(mp_obj_t self_in) {
+    #if MICROPY_SSL_MBEDTLS
+    size_t state_size = sizeof(mbedtls_sha256_context);
+    #else
+    size_t state_size = sizeof(CRYAL_SHA256_CTX);
+    #endif
+    mp_obj_hash_t *o = m_new_obj_var(mp_obj_hash_t, char, state_size);
+    memcpy(o, MP_OBJ_TO_PTR(self_in), sizeof(mp_obj_hash_t) + state_size);
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t uhashlib_hmac_sha256_make_new(const mp_obj_type_t *type, size_t n_args, const mp_obj_t *args, mp_map_t *kw_args) {
+    mp_arg_check_num(n_args, kw_args, 1, 2, false);
+    mp_buffer_info_t keyinfo;
+    mp_get_buffer_raise(args[0], &keyinfo, MP_BUFFER_READ);
+
+    // Keys longer than a block are replaced by their digest
+    byte pad[HMAC_SHA256_BLOCK_SIZE] = {0};
+    if (keyinfo.len > HMAC_SHA256_BLOCK_SIZE) {
+        mp_obj_t h = uhashlib_sha256_make_new(&uhashlib_sha256_type, 1, args, NULL);
+        mp_get_buffer_raise(uhashlib_sha256_digest(h), &keyinfo, MP_BUFFER_READ);
+    }
+    memcpy(pad, keyinfo.buf, keyinfo.len);
+
+    mp_obj_hmac_t *o = m_new_obj(mp_obj_hmac_t);
+    o->base.type = type;
+    o->inner = uhashlib_sha256_make_new(&uhashlib_sha256_type, 0, NULL, NULL);
+    o->outer = uhashlib_sha256_make_new(&uhashlib_sha256_type, 0, NULL, NULL);
+    mp_obj_t pad_obj = mp_obj_new_bytearray_by_ref(sizeof(pad), pad);
+    for (size_t i = 0; i < sizeof(pad); i++) {
+        pad[i] ^= 0x36;
+    }
+    uhashlib_sha256_update(o->inner, pad_obj);
+    for (size_t i = 0; i < sizeof(pad); i++) {
+        pad[i] ^= 0x36 ^ 0x5c;
+    }
+    uhashlib_sha256_update(o->outer, pad_obj);
+
+    if (n_args == 2) {
+        uhashlib_hmac_sha256_update(MP_OBJ_FROM_PTR(o), args[1]);
+    }
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t uhashlib_hmac_sha256_update(mp_obj_t self_in, mp_obj_t arg) {
+    mp_obj_hmac_t *self = MP_OBJ_TO_PTR(self_in);
+    return uhashlib_sha256_update(self->inner, arg);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(uhashlib_hmac_sha256_update_obj, uhashlib_hmac_sha256_update);
+
+STATIC mp_obj_t uhashlib_hmac_sha256_digest(mp_obj_t self_in) {
+    mp_obj_hmac_t *self = MP_OBJ_TO_PTR(self_in);
+    // finalise copies, so digest() can be repeated and followed by update()
+    mp_obj_t inner = uhashlib_sha256_copy(self->inner);
+    mp_obj_t outer = uhashlib_sha256_copy(self->outer);
+    uhashlib_sha256_update(outer, uhashlib_sha256_digest(inner));
+    return uhashlib_sha256_digest(outer);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(uhashlib_hmac_sha256_digest_obj, uhashlib_hmac_sha256_digest);
+
+STATIC const mp_rom_map_elem_t uhashlib_hmac_sha256_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_update), MP_ROM_PTR(&uhashlib_hmac_sha256_update_obj) },
+    { MP_ROM_QSTR(MP_QSTR_digest), MP_ROM_PTR(&uhashlib_hmac_sha256_digest_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(uhashlib_hmac_sha256_locals_dict, uhashlib_hmac_sha256_locals_dict_table);
+
+STATIC const mp_obj_type_t uhashlib_hmac_sha256_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_hmac_sha256,
+    .make_new = uhashlib_hmac_sha256_make_new,
+    .locals_dict = (void*)&uhashlib_hmac_sha256_locals_dict,
+};
+#endif
+
+#if MICROPY_PY_UHASHLIB_FILE_DIGEST
+// Hash the contents of a stream, reading it in large blocks into a single
+// buffer rather than creating a bytes object per read.
+STATIC mp_obj_t uhashlib_file_digest(mp_obj_t stream, mp_obj_t digest) {
+    mp_get_stream_raise(stream, MP_STREAM_OP_READ);
+    mp_obj_t h;
+    if (MP_OBJ_IS_STR(digest)) {
+        h = mp_call_function_0(mp_load_attr(MP_OBJ_FROM_PTR(&mp_module_uhashlib), mp_obj_str_get_qstr(digest)));
+    } else {
+        h = mp_call_function_0(digest);
+    }
+
+    mp_obj_t update[3];
+    mp_load_method(h, MP_QSTR_update, update);
+    mp_obj_array_t *buf = MP_OBJ_TO_PTR(mp_obj_new_bytearray_by_ref(MICROPY_PY_UHASHLIB_FILE_DIGEST_BUF_SIZE,
+        m_new(byte, MICROPY_PY_UHASHLIB_FILE_DIGEST_BUF_SIZE)));
+    for (;;) {
+        int errcode;
+        mp_uint_t n = mp_stream_rw(stream, buf->items, buf->len, &errcode, MP_STREAM_RW_READ);
+        if (errcode != 0) {
+            mp_raise_OSError(errcode);
+        }
+        if (n == 0) {
+            break;
+        }
+        update[2] = MP_OBJ_FROM_PTR(buf);
+        if (n < buf->len) {
+            update[2] = mp_obj_new_memoryview('B', n, buf->items);
+        }
+        mp_call_method_n_kw(1, 0, update);
+        if (n < buf->len) {
+            break;
+        }
+    }
+    return h;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(uhashlib_file_digest_obj, uhashlib_file_digest);
+#endif
+
 STATIC const mp_rom_map_elem_t mp_module_uhashlib_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_hashlib) },
     #if MICROPY_PY_UHASHLIB_SHA256
@@ -240,6 +371,12 @@ STATIC const mp_rom_map_elem_t mp_module_uhashlib_globals_table[] = {
     #if MICROPY_PY_UHASHLIB_SHA1
     { MP_ROM_QSTR(MP_QSTR_sha1), MP_ROM_PTR(&uhashlib_sha1_type) },
     #endif
+    #if MICROPY_PY_UHASHLIB_SHA256 && MICROPY_PY_UHASHLIB_HMAC
+    { MP_ROM_QSTR(MP_QSTR_hmac_sha256), MP_ROM_PTR(&uhashlib_hmac_sha256_type) },
+    #endif
+    #if MICROPY_PY_UHASHLIB_FILE_DIGEST
+    { MP_ROM_QSTR(MP_QSTR_file_digest), MP_ROM_PTR(&uhashlib_file_digest_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_uhashlib_globals, mp_module_uhashlib_globals_table);
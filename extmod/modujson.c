@@ -25,9 +25,9 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "py/objlist.h"
-#include "py/objstringio.h"
 #include "py/parsenum.h"
 #include "py/runtime.h"
 #include "py/stream.h"
@@ -36,10 +36,47 @@
 
 #if MICROPY_PY_UJSON
 
+// Output buffer for dump and dumps_into.  When it fills up it's written out
+// to stream, or if there is no stream then the output doesn't fit.
+typedef struct _ujson_dump_buf_t {
+    mp_obj_t stream;
+    byte *buf;
+    size_t len;
+    size_t size;
+} ujson_dump_buf_t;
+
+STATIC void ujson_dump_buf_strn(void *data, const char *str, size_t len) {
+    ujson_dump_buf_t *b = data;
+    while (b->len + len > b->size) {
+        if (b->stream == MP_OBJ_NULL) {
+            mp_raise_ValueError(translate("buffer too small"));
+        }
+        if (b->len == 0) {
+            // too big for the buffer so write it out directly
+            mp_stream_write(b->stream, str, len, MP_STREAM_RW_WRITE);
+            return;
+        }
+        size_t n = b->size - b->len;
+        memcpy(b->buf + b->len, str, n);
+        mp_stream_write(b->stream, b->buf, b->size, MP_STREAM_RW_WRITE);
+        b->len = 0;
+        str += n;
+        len -= n;
+    }
+    memcpy(b->buf + b->len, str, len);
+    b->len += len;
+}
+
 STATIC mp_obj_t mod_ujson_dump(mp_obj_t obj, mp_obj_t stream) {
     mp_get_stream_raise(stream, MP_STREAM_OP_WRITE);
-    mp_print_t print = {MP_OBJ_TO_PTR(stream), mp_stream_write_adaptor};
+    // collect the many small pieces of output into fewer, larger writes
+    byte buf[MICROPY_PY_UJSON_DUMP_BUF_SIZE];
+    ujson_dump_buf_t b = {stream, buf, 0, sizeof(buf)};
+    mp_print_t print = {&b, ujson_dump_buf_strn};
     mp_obj_print_helper(&print, obj, PRINT_JSON);
+    if (b.len > 0) {
+        mp_stream_write(stream, buf, b.len, MP_STREAM_RW_WRITE);
+    }
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_ujson_dump_obj, mod_ujson_dump);
@@ -53,6 +90,18 @@ STATIC mp_obj_t mod_ujson_dumps(mp_obj_t obj) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_dumps_obj, mod_ujson_dumps);
 
+#if MICROPY_PY_UJSON_DUMPS_INTO
+STATIC mp_obj_t mod_ujson_dumps_into(mp_obj_t obj, mp_obj_t buf_in) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_WRITE);
+    ujson_dump_buf_t b = {MP_OBJ_NULL, bufinfo.buf, 0, bufinfo.len};
+    mp_print_t print = {&b, ujson_dump_buf_strn};
+    mp_obj_print_helper(&print, obj, PRINT_JSON);
+    return mp_obj_new_int_from_uint(b.len);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_ujson_dumps_into_obj, mod_ujson_dumps_into);
+#endif
+
 // The function below implements a simple non-recursive JSON parser.
 //
 // The JSON specification is at http://www.ietf.org/rfc/rfc4627.txt
@@ -71,6 +120,12 @@ typedef struct _ujson_stream_t {
     mp_uint_t (*read)(mp_obj_t obj, void *buf, mp_uint_t size, int *errcode);
     int errcode;
     byte cur;
+    // Read-ahead buffer, refilled from the stream with one read call at a time.
+    // For loads() it is the whole input and read is NULL.
+    const byte *buf_cur;
+    const byte *buf_end;
+    byte *buf;
+    size_t buf_size;
 } ujson_stream_t;
 
 #define S_EOF (0) // null is not allowed in json stream so is ok as EOF marker
@@ -79,28 +134,48 @@ typedef struct _ujson_stream_t {
 #define S_NEXT(s) (ujson_stream_next(&(s)))
 
 STATIC byte ujson_stream_next(ujson_stream_t *s) {
-    mp_uint_t ret = s->read(s->stream_obj, &s->cur, 1, &s->errcode);
-    if (s->errcode != 0) {
-        mp_raise_OSError(s->errcode);
-    }
-    if (ret == 0) {
-        s->cur = S_EOF;
+    if (s->buf_cur == s->buf_end) {
+        mp_uint_t ret = 0;
+        if (s->read != NULL) {
+            ret = s->read(s->stream_obj, s->buf, s->buf_size, &s->errcode);
+            if (s->errcode != 0) {
+                mp_raise_OSError(s->errcode);
+            }
+        }
+        if (ret == 0) {
+            s->cur = S_EOF;
+            return s->cur;
+        }
+        s->buf_cur = s->buf;
+        s->buf_end = s->buf + ret;
     }
+    s->cur = *s->buf_cur++;
     return s->cur;
 }
 
-STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
+STATIC void ujson_stream_init(ujson_stream_t *s, mp_obj_t stream_obj, byte *buf, size_t buf_size) {
     const mp_stream_p_t *stream_p = mp_get_stream_raise(stream_obj, MP_STREAM_OP_READ);
-    ujson_stream_t s = {stream_obj, stream_p->read, 0, 0};
-    vstr_t vstr;
-    vstr_init(&vstr, 8);
+    s->stream_obj = stream_obj;
+    s->read = stream_p->read;
+    s->errcode = 0;
+    s->buf_cur = s->buf_end = s->buf = buf;
+    s->buf_size = buf_size;
+}
+
+STATIC NORETURN void ujson_syntax_error(void) {
+    mp_raise_ValueError(translate("syntax error in JSON"));
+}
+
+// Parse one JSON value starting at the current char, leaving the stream at the
+// first char after it.  vstr is scratch space for strings and numbers.
+STATIC mp_obj_t ujson_parse_value(ujson_stream_t *s_in, vstr_t *vstr) {
+    ujson_stream_t s = *s_in;
     mp_obj_list_t stack; // we use a list as a simple stack for nested JSON
     stack.len = 0;
     stack.items = NULL;
     mp_obj_t stack_top = MP_OBJ_NULL;
     mp_obj_type_t *stack_top_type = NULL;
     mp_obj_t stack_key = MP_OBJ_NULL;
-    S_NEXT(s);
     for (;;) {
         cont:
         if (S_END(s)) {
@@ -143,7 +218,7 @@ STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
                 }
                 break;
             case '"':
-                vstr_reset(&vstr);
+                vstr_reset(vstr);
                 for (; !S_END(s) && S_CUR(s) != '"';) {
                     byte c = S_CUR(s);
                     if (c == '\\') {
@@ -163,12 +238,12 @@ STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
                                     }
                                     num = (num << 4) | c;
                                 }
-                                vstr_add_char(&vstr, num);
+                                vstr_add_char(vstr, num);
                                 goto str_cont;
                             }
                         }
                     }
-                    vstr_add_byte(&vstr, c);
+                    vstr_add_byte(vstr, c);
                 str_cont:
                     S_NEXT(s);
                 }
@@ -176,14 +251,14 @@ STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
                     goto fail;
                 }
                 S_NEXT(s);
-                next = mp_obj_new_str(vstr.buf, vstr.len);
+                next = mp_obj_new_str(vstr->buf, vstr->len);
                 break;
             case '-':
             case '0': case '1': case '2': case '3': case '4': case '5': case '6': case '7': case '8': case '9': {
                 bool flt = false;
-                vstr_reset(&vstr);
+                vstr_reset(vstr);
                 for (;;) {
-                    vstr_add_byte(&vstr, cur);
+                    vstr_add_byte(vstr, cur);
                     cur = S_CUR(s);
                     if (cur == '.' || cur == 'E' || cur == 'e') {
                         flt = true;
@@ -195,9 +270,9 @@ STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
                     S_NEXT(s);
                 }
                 if (flt) {
-                    next = mp_parse_num_decimal(vstr.buf, vstr.len, false, false, NULL);
+                    next = mp_parse_num_decimal(vstr->buf, vstr->len, false, false, NULL);
                 } else {
-                    next = mp_parse_num_integer(vstr.buf, vstr.len, 10, NULL);
+                    next = mp_parse_num_integer(vstr->buf, vstr->len, 10, NULL);
                 }
                 break;
             }
@@ -262,41 +337,120 @@ STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
         }
     }
     success:
-    // eat trailing whitespace
-    while (unichar_isspace(S_CUR(s))) {
-        S_NEXT(s);
-    }
-    if (!S_END(s)) {
-        // unexpected chars
-        goto fail;
-    }
     if (stack_top == MP_OBJ_NULL || stack.len != 0) {
         // not exactly 1 object
         goto fail;
     }
-    vstr_clear(&vstr);
+    *s_in = s;
     return stack_top;
 
     fail:
-    mp_raise_ValueError(translate("syntax error in JSON"));
+    ujson_syntax_error();
+}
+
+// Parse a complete JSON document: exactly one value and trailing whitespace.
+STATIC mp_obj_t ujson_parse_document(ujson_stream_t *s) {
+    vstr_t vstr;
+    vstr_init(&vstr, 8);
+    S_NEXT(*s);
+    mp_obj_t value = ujson_parse_value(s, &vstr);
+    // eat trailing whitespace
+    while (unichar_isspace(S_CUR(*s))) {
+        S_NEXT(*s);
+    }
+    if (!S_END(*s)) {
+        // unexpected chars
+        ujson_syntax_error();
+    }
+    vstr_clear(&vstr);
+    return value;
+}
+
+STATIC mp_obj_t mod_ujson_load(mp_obj_t stream_obj) {
+    byte buf[MICROPY_PY_UJSON_LOAD_BUF_SIZE];
+    ujson_stream_t s;
+    ujson_stream_init(&s, stream_obj, buf, sizeof(buf));
+    return ujson_parse_document(&s);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_load_obj, mod_ujson_load);
 
 STATIC mp_obj_t mod_ujson_loads(mp_obj_t obj) {
     size_t len;
     const char *buf = mp_obj_str_get_data(obj, &len);
-    vstr_t vstr = {len, len, (char*)buf, true};
-    mp_obj_stringio_t sio = {{&mp_type_stringio}, &vstr, 0, MP_OBJ_NULL};
-    return mod_ujson_load(MP_OBJ_FROM_PTR(&sio));
+    // parse straight from the str/bytes data, which is all already in memory
+    ujson_stream_t s = {MP_OBJ_NULL, NULL, 0, 0, (const byte*)buf, (const byte*)buf + len, NULL, 0};
+    return ujson_parse_document(&s);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_loads_obj, mod_ujson_loads);
 
+#if MICROPY_PY_UJSON_ITERLOAD
+// Iterator over the elements of a top-level JSON array, parsing one element
+// per step so only that element needs to be held in memory.
+typedef struct _mp_obj_ujson_iterload_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    ujson_stream_t s;
+    vstr_t vstr;
+    bool done;
+    byte buf[MICROPY_PY_UJSON_LOAD_BUF_SIZE];
+} mp_obj_ujson_iterload_t;
+
+STATIC mp_obj_t ujson_iterload_iternext(mp_obj_t self_in) {
+    mp_obj_ujson_iterload_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->done) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    // skip separators up to the next element or the end of the array
+    while (unichar_isspace(S_CUR(self->s)) || S_CUR(self->s) == ',') {
+        S_NEXT(self->s);
+    }
+    if (S_CUR(self->s) != ']') {
+        return ujson_parse_value(&self->s, &self->vstr);
+    }
+    // end of array; only whitespace may follow
+    self->done = true;
+    do {
+        S_NEXT(self->s);
+    } while (unichar_isspace(S_CUR(self->s)));
+    if (!S_END(self->s)) {
+        ujson_syntax_error();
+    }
+    vstr_clear(&self->vstr);
+    return MP_OBJ_STOP_ITERATION;
+}
+
+STATIC mp_obj_t mod_ujson_iterload(mp_obj_t stream_obj) {
+    mp_obj_ujson_iterload_t *self = m_new_obj(mp_obj_ujson_iterload_t);
+    self->base.type = &mp_type_polymorph_iter;
+    self->iternext = ujson_iterload_iternext;
+    ujson_stream_init(&self->s, stream_obj, self->buf, sizeof(self->buf));
+    vstr_init(&self->vstr, 8);
+    self->done = false;
+    // the document must be an array, whose elements are then yielded in turn
+    do {
+        S_NEXT(self->s);
+    } while (unichar_isspace(S_CUR(self->s)));
+    if (S_CUR(self->s) != '[') {
+        ujson_syntax_error();
+    }
+    S_NEXT(self->s);
+    return MP_OBJ_FROM_PTR(self);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mod_ujson_iterload_obj, mod_ujson_iterload);
+#endif
+
 STATIC const mp_rom_map_elem_t mp_module_ujson_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ujson) },
     { MP_ROM_QSTR(MP_QSTR_dump), MP_ROM_PTR(&mod_ujson_dump_obj) },
     { MP_ROM_QSTR(MP_QSTR_dumps), MP_ROM_PTR(&mod_ujson_dumps_obj) },
+    #if MICROPY_PY_UJSON_DUMPS_INTO
+    { MP_ROM_QSTR(MP_QSTR_dumps_into), MP_ROM_PTR(&mod_ujson_dumps_into_obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_load), MP_ROM_PTR(&mod_ujson_load_obj) },
     { MP_ROM_QSTR(MP_QSTR_loads), MP_ROM_PTR(&mod_ujson_loads_obj) },
+    #if MICROPY_PY_UJSON_ITERLOAD
+    { MP_ROM_QSTR(MP_QSTR_iterload), MP_ROM_PTR(&mod_ujson_iterload_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_ujson_globals, mp_module_ujson_globals_table);
@@ -36,23 +36,69 @@
 #if MICROPY_PY_URE
 
 #define re1_5_stack_chk() MP_STACK_CHECK()
+#define re1_5_alloc(n) m_new(char, n)
+#define re1_5_free(p, n) m_del(char, p, n)
 
 #include "re1.5/re1.5.h"
 
 #define FLAG_DEBUG 0x1000
+#define FLAG_LINEAR 0x2000
 
 typedef struct _mp_obj_re_t {
     mp_obj_base_t base;
+    int flags;
     ByteProg re;
 } mp_obj_re_t;
 
+// The captures are stored as offsets into the subject, -1 for a group that
+// didn't match, and its data is fetched again when they're used because a
+// subject with the buffer protocol may be resized after matching.
 typedef struct _mp_obj_match_t {
     mp_obj_base_t base;
     int num_matches;
     mp_obj_t str;
-    const char *caps[0];
+    mp_int_t caps[0];
 } mp_obj_match_t;
 
+STATIC const mp_obj_type_t match_type;
+
+// Return the data of a subject, which can be str, bytes or any object with
+// the buffer protocol, so eg a memoryview can be matched without a copy.
+STATIC const char *ure_get_data(mp_obj_t str, size_t *len) {
+    if (MP_OBJ_IS_STR_OR_BYTES(str)) {
+        return mp_obj_str_get_data(str, len);
+    }
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(str, &bufinfo, MP_BUFFER_READ);
+    *len = bufinfo.len;
+    return bufinfo.buf;
+}
+
+// Return the type of the (sub)strings made from a subject; bytes are used
+// for subjects which aren't str or bytes.
+STATIC const mp_obj_type_t *ure_str_type(mp_obj_t str) {
+    if (MP_OBJ_IS_STR_OR_BYTES(str)) {
+        return mp_obj_get_type(str);
+    }
+    return &mp_type_bytes;
+}
+
+// caps point into the data of str, which starts at begin.
+STATIC mp_obj_t ure_new_match(mp_obj_t str, const char *begin, const char **caps, int caps_num) {
+    mp_obj_match_t *match = m_new_obj_var(mp_obj_match_t, mp_int_t, caps_num);
+    match->base.type = &match_type;
+    match->num_matches = caps_num / 2; // caps_num counts start and end pointers
+    match->str = str;
+    for (int i = 0; i < caps_num; i += 2) {
+        if (caps[i] == NULL) {
+            match->caps[i] = match->caps[i + 1] = -1;
+        } else {
+            match->caps[i] = caps[i] - begin;
+            match->caps[i + 1] = caps[i + 1] - begin;
+        }
+    }
+    return MP_OBJ_FROM_PTR(match);
+}
 
 STATIC void match_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
     (void)kind;
@@ -67,18 +113,68 @@ STATIC mp_obj_t match_group(mp_obj_t self_in, mp_obj_t no_in) {
         nlr_raise(mp_obj_new_exception_arg1(&mp_type_IndexError, no_in));
     }
 
-    const char *start = self->caps[no * 2];
-    if (start == NULL) {
+    mp_int_t start = self->caps[no * 2];
+    if (start < 0) {
         // no match for this group
         return mp_const_none;
     }
-    return mp_obj_new_str_of_type(mp_obj_get_type(self->str),
-        (const byte*)start, self->caps[no * 2 + 1] - start);
+    // stay within the subject in case it has shrunk since the match
+    size_t len;
+    const char *begin = ure_get_data(self->str, &len);
+    size_t end = MIN((size_t)self->caps[no * 2 + 1], len);
+    start = MIN((size_t)start, end);
+    return mp_obj_new_str_of_type(ure_str_type(self->str),
+        (const byte*)begin + start, end - start);
 }
 MP_DEFINE_CONST_FUN_OBJ_2(match_group_obj, match_group);
 
+#if MICROPY_PY_URE_MATCH_SPAN_START_END
+
+// Get the offsets of a group in the subject, which are -1 if it didn't match.
+STATIC void match_span_helper(size_t n_args, const mp_obj_t *args, mp_obj_t span[2]) {
+    mp_obj_match_t *self = MP_OBJ_TO_PTR(args[0]);
+    mp_int_t no = 0;
+    if (n_args == 2) {
+        no = mp_obj_get_int(args[1]);
+        if (no < 0 || no >= self->num_matches) {
+            nlr_raise(mp_obj_new_exception_arg1(&mp_type_IndexError, args[1]));
+        }
+    }
+
+    span[0] = mp_obj_new_int(self->caps[no * 2]);
+    span[1] = mp_obj_new_int(self->caps[no * 2 + 1]);
+}
+
+STATIC mp_obj_t match_span(size_t n_args, const mp_obj_t *args) {
+    mp_obj_t span[2];
+    match_span_helper(n_args, args, span);
+    return mp_obj_new_tuple(2, span);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(match_span_obj, 1, 2, match_span);
+
+STATIC mp_obj_t match_start(size_t n_args, const mp_obj_t *args) {
+    mp_obj_t span[2];
+    match_span_helper(n_args, args, span);
+    return span[0];
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(match_start_obj, 1, 2, match_start);
+
+STATIC mp_obj_t match_end(size_t n_args, const mp_obj_t *args) {
+    mp_obj_t span[2];
+    match_span_helper(n_args, args, span);
+    return span[1];
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(match_end_obj, 1, 2, match_end);
+
+#endif
+
 STATIC const mp_rom_map_elem_t match_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_group), MP_ROM_PTR(&match_group_obj) },
+    #if MICROPY_PY_URE_MATCH_SPAN_START_END
+    { MP_ROM_QSTR(MP_QSTR_span), MP_ROM_PTR(&match_span_obj) },
+    { MP_ROM_QSTR(MP_QSTR_start), MP_ROM_PTR(&match_start_obj) },
+    { MP_ROM_QSTR(MP_QSTR_end), MP_ROM_PTR(&match_end_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(match_locals_dict, match_locals_dict_table);
@@ -96,27 +192,65 @@ STATIC void re_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t
     mp_printf(print, "<re %p>", self);
 }
 
+// Run the compiled pattern with the matcher it was compiled for.
+STATIC int ure_exec_prog(mp_obj_re_t *self, Subject *subj, const char **caps, int caps_num, bool is_anchored) {
+    // cast is a workaround for a bug in msvc: it treats const char** as a const pointer instead of a pointer to pointer to const char
+    memset((char*)caps, 0, caps_num * sizeof(char*));
+    #if MICROPY_PY_URE_PIKEVM
+    if (self->flags & FLAG_LINEAR) {
+        return re1_5_pikevm(&self->re, subj, caps, caps_num, is_anchored);
+    }
+    #endif
+    return re1_5_recursiveloopprog(&self->re, subj, caps, caps_num, is_anchored);
+}
+
+// Set up subj for the whole of the subject str.
+STATIC void ure_init_subject(Subject *subj, mp_obj_t str) {
+    size_t len;
+    subj->begin = ure_get_data(str, &len);
+    subj->end = subj->begin + len;
+    subj->begin_line = subj->begin;
+}
+
+// Move on from an empty match at subj->begin by one character.
+STATIC void ure_skip_char(Subject *subj, mp_obj_t str) {
+    if (MP_OBJ_IS_STR(str)) {
+        subj->begin = (const char*)utf8_next_char((const byte*)subj->begin);
+    } else {
+        subj->begin++;
+    }
+}
+
 STATIC mp_obj_t ure_exec(bool is_anchored, uint n_args, const mp_obj_t *args) {
-    (void)n_args;
     mp_obj_re_t *self = MP_OBJ_TO_PTR(args[0]);
     Subject subj;
-    size_t len;
-    subj.begin = mp_obj_str_get_data(args[1], &len);
-    subj.end = subj.begin + len;
+    ure_init_subject(&subj, args[1]);
+    if (n_args > 2) {
+        // pos and endpos are byte offsets; ^ still only matches at offset 0
+        size_t len = subj.end - subj.begin;
+        mp_int_t pos = mp_obj_get_int(args[2]);
+        mp_int_t endpos = len;
+        if (n_args > 3) {
+            endpos = mp_obj_get_int(args[3]);
+        }
+        pos = MAX(0, MIN(pos, (mp_int_t)len));
+        endpos = MAX(0, MIN(endpos, (mp_int_t)len));
+        if (endpos < pos) {
+            return mp_const_none;
+        }
+        subj.end = subj.begin + endpos;
+        subj.begin += pos;
+    }
     int caps_num = (self->re.sub + 1) * 2;
-    mp_obj_match_t *match = m_new_obj_var(mp_obj_match_t, char*, caps_num);
-    // cast is a workaround for a bug in msvc: it treats const char** as a const pointer instead of a pointer to pointer to const char
-    memset((char*)match->caps, 0, caps_num * sizeof(char*));
-    int res = re1_5_recursiveloopprog(&self->re, &subj, match->caps, caps_num, is_anchored);
-    if (res == 0) {
-        m_del_var(mp_obj_match_t, char*, caps_num, match);
-        return mp_const_none;
+    const char **caps = mp_local_alloc(caps_num * sizeof(char*));
+    int res = ure_exec_prog(self, &subj, caps, caps_num, is_anchored);
+    mp_obj_t match = mp_const_none;
+    if (res != 0) {
+        match = ure_new_match(args[1], subj.begin_line, caps, caps_num);
     }
-
-    match->base.type = &match_type;
-    match->num_matches = caps_num / 2; // caps_num counts start and end pointers
-    match->str = args[1];
-    return MP_OBJ_FROM_PTR(match);
+    // cast is a workaround for a bug in msvc (see ure_exec_prog)
+    mp_local_free((char**)caps);
+    return match;
 }
 
 STATIC mp_obj_t re_match(size_t n_args, const mp_obj_t *args) {
@@ -132,10 +266,8 @@ MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(re_search_obj, 2, 4, re_search);
 STATIC mp_obj_t re_split(size_t n_args, const mp_obj_t *args) {
     mp_obj_re_t *self = MP_OBJ_TO_PTR(args[0]);
     Subject subj;
-    size_t len;
-    const mp_obj_type_t *str_type = mp_obj_get_type(args[1]);
-    subj.begin = mp_obj_str_get_data(args[1], &len);
-    subj.end = subj.begin + len;
+    const mp_obj_type_t *str_type = ure_str_type(args[1]);
+    ure_init_subject(&subj, args[1]);
     int caps_num = (self->re.sub + 1) * 2;
 
     int maxsplit = 0;
@@ -146,9 +278,7 @@ STATIC mp_obj_t re_split(size_t n_args, const mp_obj_t *args) {
     mp_obj_t retval = mp_obj_new_list(0, NULL);
     const char **caps = mp_local_alloc(caps_num * sizeof(char*));
     while (true) {
-        // cast is a workaround for a bug in msvc: it treats const char** as a const pointer instead of a pointer to pointer to const char
-        memset((char**)caps, 0, caps_num * sizeof(char*));
-        int res = re1_5_recursiveloopprog(&self->re, &subj, caps, caps_num, false);
+        int res = ure_exec_prog(self, &subj, caps, caps_num, false);
 
         // if we didn't have a match, or had an empty match, it's time to stop
         if (!res || caps[0] == caps[1]) {
@@ -174,10 +304,193 @@ STATIC mp_obj_t re_split(size_t n_args, const mp_obj_t *args) {
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(re_split_obj, 2, 3, re_split);
 
+#if MICROPY_PY_URE_FINDITER
+
+// The iterator keeps its place in the subject as an offset, because the
+// subject may be resized between searches, and a single capture array which
+// is reused for every search; only the match objects are allocated.
+typedef struct _mp_obj_re_finditer_t {
+    mp_obj_base_t base;
+    mp_fun_1_t iternext;
+    mp_obj_re_t *re;
+    mp_obj_t str;
+    mp_int_t pos; // -1 once the iterator is exhausted
+    int caps_num;
+    const char *caps[0];
+} mp_obj_re_finditer_t;
+
+STATIC mp_obj_t re_finditer_iternext(mp_obj_t self_in) {
+    mp_obj_re_finditer_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->pos < 0) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+    Subject subj;
+    ure_init_subject(&subj, self->str);
+    if (self->pos > subj.end - subj.begin) {
+        self->pos = -1;
+        return MP_OBJ_STOP_ITERATION;
+    }
+    subj.begin += self->pos;
+    if (!ure_exec_prog(self->re, &subj, self->caps, self->caps_num, false)) {
+        self->pos = -1;
+        return MP_OBJ_STOP_ITERATION;
+    }
+    subj.begin = self->caps[1];
+    if (self->caps[0] == self->caps[1]) {
+        // an empty match, so the next search must start further on
+        if (subj.begin == subj.end) {
+            subj.begin = NULL;
+        } else {
+            ure_skip_char(&subj, self->str);
+        }
+    }
+    self->pos = subj.begin == NULL ? -1 : subj.begin - subj.begin_line;
+    return ure_new_match(self->str, subj.begin_line, self->caps, self->caps_num);
+}
+
+STATIC mp_obj_t re_finditer(mp_obj_t self_in, mp_obj_t str) {
+    mp_obj_re_t *self = MP_OBJ_TO_PTR(self_in);
+    int caps_num = (self->re.sub + 1) * 2;
+    mp_obj_re_finditer_t *o = m_new_obj_var(mp_obj_re_finditer_t, char*, caps_num);
+    o->base.type = &mp_type_polymorph_iter;
+    o->iternext = re_finditer_iternext;
+    o->re = self;
+    o->str = str;
+    // check now that the subject can be matched
+    size_t len;
+    ure_get_data(str, &len);
+    o->pos = 0;
+    o->caps_num = caps_num;
+    return MP_OBJ_FROM_PTR(o);
+}
+MP_DEFINE_CONST_FUN_OBJ_2(re_finditer_obj, re_finditer);
+
+#endif
+
+#if MICROPY_PY_URE_SUB
+
+// Append the replacement for a match to vstr.  The template can refer to
+// groups as \N or \g<N>; a callable is passed a match object.
+STATIC void re_sub_append(vstr_t *vstr, mp_obj_t repl, mp_obj_t str, const Subject *subj, const char **caps, int caps_num) {
+    if (!MP_OBJ_IS_STR_OR_BYTES(repl)) {
+        mp_obj_t r = mp_call_function_1(repl, ure_new_match(str, subj->begin_line, caps, caps_num));
+        size_t len;
+        const char *data = mp_obj_str_get_data(r, &len);
+        vstr_add_strn(vstr, data, len);
+        return;
+    }
+
+    size_t len;
+    const char *p = mp_obj_str_get_data(repl, &len);
+    const char *top = p + len;
+    while (p < top) {
+        const char *lit = p;
+        while (p < top && *p != '\\') {
+            p++;
+        }
+        vstr_add_strn(vstr, lit, p - lit);
+        if (p >= top) {
+            break;
+        }
+
+        // p is at a backslash, see if it refers to a group
+        const char *q = p + 1;
+        bool angle = false;
+        if (q + 1 < top && q[0] == 'g' && q[1] == '<') {
+            angle = true;
+            q += 2;
+        }
+        int no = -1;
+        if (q < top && unichar_isdigit(*q)) {
+            no = 0;
+            do {
+                no = no * 10 + (*q++ - '0');
+            } while (angle && q < top && unichar_isdigit(*q));
+        }
+        if (no < 0 || (angle && (q >= top || *q++ != '>'))) {
+            // not a group reference, copy the backslash as is
+            vstr_add_byte(vstr, '\\');
+            p++;
+            continue;
+        }
+        if (no >= caps_num / 2) {
+            nlr_raise(mp_obj_new_exception_arg1(&mp_type_IndexError, MP_OBJ_NEW_SMALL_INT(no)));
+        }
+        const char *start = caps[no * 2];
+        if (start != NULL) {
+            vstr_add_strn(vstr, start, caps[no * 2 + 1] - start);
+        }
+        p = q;
+    }
+}
+
+// Build the result in one vstr, reusing one capture array for every search.
+STATIC mp_obj_t re_sub_helper(mp_obj_re_t *self, mp_obj_t repl, mp_obj_t str, mp_int_t count) {
+    if (!MP_OBJ_IS_STR_OR_BYTES(str) && !MP_OBJ_IS_STR_OR_BYTES(repl)) {
+        // a callable could resize the subject while it's being scanned, so
+        // scan a copy
+        size_t len;
+        const char *data = ure_get_data(str, &len);
+        str = mp_obj_new_bytes((const byte*)data, len);
+    }
+    Subject subj;
+    ure_init_subject(&subj, str);
+    int caps_num = (self->re.sub + 1) * 2;
+    const char **caps = mp_local_alloc(caps_num * sizeof(char*));
+
+    vstr_t vstr;
+    vstr_init(&vstr, subj.end - subj.begin);
+    while (true) {
+        if (!ure_exec_prog(self, &subj, caps, caps_num, false)) {
+            break;
+        }
+
+        // copy the text before the match, then the replacement
+        vstr_add_strn(&vstr, subj.begin, caps[0] - subj.begin);
+        re_sub_append(&vstr, repl, str, &subj, caps, caps_num);
+        subj.begin = caps[1];
+
+        if (caps[0] == caps[1]) {
+            // an empty match, so copy a character before searching again
+            if (subj.begin == subj.end) {
+                break;
+            }
+            const char *next = subj.begin;
+            ure_skip_char(&subj, str);
+            vstr_add_strn(&vstr, next, subj.begin - next);
+        }
+        if (count > 0 && --count == 0) {
+            break;
+        }
+    }
+    // cast is a workaround for a bug in msvc (see ure_exec_prog)
+    mp_local_free((char**)caps);
+
+    vstr_add_strn(&vstr, subj.begin, subj.end - subj.begin);
+    return mp_obj_new_str_from_vstr(ure_str_type(str), &vstr);
+}
+
+STATIC mp_obj_t re_sub(size_t n_args, const mp_obj_t *args) {
+    mp_int_t count = 0;
+    if (n_args > 3) {
+        count = mp_obj_get_int(args[3]);
+    }
+    return re_sub_helper(MP_OBJ_TO_PTR(args[0]), args[1], args[2], count);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(re_sub_obj, 3, 4, re_sub);
+
+#endif
+
 STATIC const mp_rom_map_elem_t re_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_match), MP_ROM_PTR(&re_match_obj) },
     { MP_ROM_QSTR(MP_QSTR_search), MP_ROM_PTR(&re_search_obj) },
     { MP_ROM_QSTR(MP_QSTR_split), MP_ROM_PTR(&re_split_obj) },
+    #if MICROPY_PY_URE_FINDITER
+    { MP_ROM_QSTR(MP_QSTR_finditer), MP_ROM_PTR(&re_finditer_obj) },
+    #endif
+    #if MICROPY_PY_URE_SUB
+    { MP_ROM_QSTR(MP_QSTR_sub), MP_ROM_PTR(&re_sub_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(re_locals_dict, re_locals_dict_table);
@@ -201,6 +514,7 @@ STATIC mp_obj_t mod_re_compile(size_t n_args, const mp_obj_t *args) {
     if (n_args > 1) {
         flags = mp_obj_get_int(args[1]);
     }
+    o->flags = flags;
     int error = re1_5_compilecode(&o->re, re_str);
     if (error != 0) {
 error:
@@ -232,12 +546,43 @@ STATIC mp_obj_t mod_re_search(size_t n_args, const mp_obj_t *args) {
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_re_search_obj, 2, 4, mod_re_search);
 
+#if MICROPY_PY_URE_FINDITER
+STATIC mp_obj_t mod_re_finditer(size_t n_args, const mp_obj_t *args) {
+    const mp_obj_t args2[] = {args[0], n_args > 2 ? args[2] : MP_OBJ_NEW_SMALL_INT(0)};
+    mp_obj_t self = mod_re_compile(2, args2);
+    return re_finditer(self, args[1]);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_re_finditer_obj, 2, 3, mod_re_finditer);
+#endif
+
+#if MICROPY_PY_URE_SUB
+STATIC mp_obj_t mod_re_sub(size_t n_args, const mp_obj_t *args) {
+    const mp_obj_t args2[] = {args[0], n_args > 4 ? args[4] : MP_OBJ_NEW_SMALL_INT(0)};
+    mp_obj_t self = mod_re_compile(2, args2);
+    mp_int_t count = 0;
+    if (n_args > 3) {
+        count = mp_obj_get_int(args[3]);
+    }
+    return re_sub_helper(MP_OBJ_TO_PTR(self), args[1], args[2], count);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_re_sub_obj, 3, 5, mod_re_sub);
+#endif
+
 STATIC const mp_rom_map_elem_t mp_module_re_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_ure) },
     { MP_ROM_QSTR(MP_QSTR_compile), MP_ROM_PTR(&mod_re_compile_obj) },
     { MP_ROM_QSTR(MP_QSTR_match), MP_ROM_PTR(&mod_re_match_obj) },
     { MP_ROM_QSTR(MP_QSTR_search), MP_ROM_PTR(&mod_re_search_obj) },
+    #if MICROPY_PY_URE_FINDITER
+    { MP_ROM_QSTR(MP_QSTR_finditer), MP_ROM_PTR(&mod_re_finditer_obj) },
+    #endif
+    #if MICROPY_PY_URE_SUB
+    { MP_ROM_QSTR(MP_QSTR_sub), MP_ROM_PTR(&mod_re_sub_obj) },
+    #endif
     { MP_ROM_QSTR(MP_QSTR_DEBUG), MP_ROM_INT(FLAG_DEBUG) },
+    #if MICROPY_PY_URE_PIKEVM
+    { MP_ROM_QSTR(MP_QSTR_LINEAR), MP_ROM_INT(FLAG_LINEAR) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_re_globals, mp_module_re_globals_table);
@@ -254,6 +599,9 @@ const mp_obj_module_t mp_module_ure = {
 #include "re1.5/compilecode.c"
 #include "re1.5/dumpcode.c"
 #include "re1.5/recursiveloop.c"
+#if MICROPY_PY_URE_PIKEVM
+#include "re1.5/pike.c"
+#endif
 #include "re1.5/charclass.c"
 
 #endif //MICROPY_PY_URE
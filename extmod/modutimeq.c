@@ -30,6 +30,7 @@
 #include "py/objlist.h"
 #include "py/runtime.h"
 #include "py/smallint.h"
+#include "extmod/modutimeq.h"
 
 #include "supervisor/shared/translate.h"
 
@@ -123,6 +124,30 @@ STATIC void heap_siftup(mp_obj_utimeq_t *heap, mp_uint_t pos) {
     heap_siftdown(heap, start_pos, pos);
 }
 
+STATIC void heap_push(mp_obj_utimeq_t *heap, mp_uint_t time, mp_obj_t callback, mp_obj_t args) {
+    mp_uint_t l = heap->len;
+    heap->items[l].time = time;
+    heap->items[l].id = utimeq_id++;
+    heap->items[l].callback = callback;
+    heap->items[l].args = args;
+    heap_siftdown(heap, 0, heap->len);
+    heap->len++;
+}
+
+STATIC mp_obj_t heap_pop(mp_obj_utimeq_t *heap, mp_obj_t *args) {
+    struct qentry *item = &heap->items[0];
+    mp_obj_t callback = item->callback;
+    *args = item->args;
+    heap->len -= 1;
+    heap->items[0] = heap->items[heap->len];
+    heap->items[heap->len].callback = MP_OBJ_NULL; // so we don't retain a pointer
+    heap->items[heap->len].args = MP_OBJ_NULL;
+    if (heap->len) {
+        heap_siftup(heap, 0);
+    }
+    return callback;
+}
+
 STATIC mp_obj_t mod_utimeq_heappush(size_t n_args, const mp_obj_t *args) {
     (void)n_args;
     mp_obj_t heap_in = args[0];
@@ -130,13 +155,7 @@ STATIC mp_obj_t mod_utimeq_heappush(size_t n_args, const mp_obj_t *args) {
     if (heap->len == heap->alloc) {
         mp_raise_IndexError(translate("queue overflow"));
     }
-    mp_uint_t l = heap->len;
-    heap->items[l].time = MP_OBJ_SMALL_INT_VALUE(args[1]);
-    heap->items[l].id = utimeq_id++;
-    heap->items[l].callback = args[2];
-    heap->items[l].args = args[3];
-    heap_siftdown(heap, 0, heap->len);
-    heap->len++;
+    heap_push(heap, MP_OBJ_SMALL_INT_VALUE(args[1]), args[2], args[3]);
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_utimeq_heappush_obj, 4, 4, mod_utimeq_heappush);
@@ -151,17 +170,8 @@ STATIC mp_obj_t mod_utimeq_heappop(mp_obj_t heap_in, mp_obj_t list_ref) {
         mp_raise_TypeError(NULL);
     }
 
-    struct qentry *item = &heap->items[0];
-    ret->items[0] = MP_OBJ_NEW_SMALL_INT(item->time);
-    ret->items[1] = item->callback;
-    ret->items[2] = item->args;
-    heap->len -= 1;
-    heap->items[0] = heap->items[heap->len];
-    heap->items[heap->len].callback = MP_OBJ_NULL; // so we don't retain a pointer
-    heap->items[heap->len].args = MP_OBJ_NULL;
-    if (heap->len) {
-        heap_siftup(heap, 0);
-    }
+    ret->items[0] = MP_OBJ_NEW_SMALL_INT(heap->items[0].time);
+    ret->items[1] = heap_pop(heap, &ret->items[2]);
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(mod_utimeq_heappop_obj, mod_utimeq_heappop);
@@ -229,4 +239,33 @@ const mp_obj_module_t mp_module_utimeq = {
     .globals = (mp_obj_dict_t*)&mp_module_utimeq_globals,
 };
 
+mp_obj_t mp_utimeq_new(size_t alloc) {
+    mp_obj_t arg = MP_OBJ_NEW_SMALL_INT(alloc);
+    return utimeq_make_new(&utimeq_type, 1, &arg, NULL);
+}
+
+size_t mp_utimeq_len(mp_obj_t heap_in) {
+    return get_heap(heap_in)->len;
+}
+
+mp_obj_t mp_utimeq_push(mp_obj_t heap_in, mp_uint_t time, mp_obj_t callback, mp_obj_t args) {
+    mp_obj_utimeq_t *heap = get_heap(heap_in);
+    if (heap->len == heap->alloc) {
+        size_t old_size = sizeof(mp_obj_utimeq_t) + heap->alloc * sizeof(struct qentry);
+        heap = (mp_obj_utimeq_t*)m_renew(byte, heap, old_size, old_size + heap->alloc * sizeof(struct qentry));
+        memset(&heap->items[heap->alloc], 0, heap->alloc * sizeof(struct qentry));
+        heap->alloc *= 2;
+    }
+    heap_push(heap, time & (MODULO - 1), callback, args);
+    return MP_OBJ_FROM_PTR(heap);
+}
+
+mp_uint_t mp_utimeq_peektime(mp_obj_t heap_in) {
+    return get_heap(heap_in)->items[0].time;
+}
+
+mp_obj_t mp_utimeq_pop(mp_obj_t heap_in, mp_obj_t *args) {
+    return heap_pop(get_heap(heap_in), args);
+}
+
 #endif //MICROPY_PY_UTIMEQ
@@ -37,6 +37,7 @@
 
 #define UZLIB_CONF_PARANOID_CHECKS (1)
 #include "../../lib/uzlib/src/tinf.h"
+#include "extmod/uzlib_deflate.h"
 
 #if 0 // print debugging info
 #define DEBUG_printf DEBUG_printf
@@ -49,24 +50,51 @@ typedef struct _mp_obj_decompio_t {
     mp_obj_t src_stream;
     TINF_DATA decomp;
     bool eof;
+    // Input is read ahead in blocks only from a stream that can seek, so the
+    // bytes read but not used can be given back
+    bool src_seekable;
+    byte src_buf[MICROPY_PY_UZLIB_DECOMPIO_BUF_SIZE];
 } mp_obj_decompio_t;
 
+// Called by the decompressor when it has used up decomp.source, to fetch the
+// next block of input into src_buf and return its first byte.
 STATIC int read_src_stream(TINF_DATA *data) {
     byte *p = (void*)data;
     p -= offsetof(mp_obj_decompio_t, decomp);
     mp_obj_decompio_t *self = (mp_obj_decompio_t*)p;
 
-    const mp_stream_p_t *stream = mp_get_stream(self->src_stream);
     int err;
-    byte c;
-    mp_uint_t out_sz = stream->read(self->src_stream, &c, 1, &err);
-    if (out_sz == MP_STREAM_ERROR) {
+    mp_uint_t out_sz = mp_stream_rw(self->src_stream, self->src_buf, self->src_seekable ? sizeof(self->src_buf) : 1, &err, MP_STREAM_RW_READ | MP_STREAM_RW_ONCE);
+    if (err != 0) {
         mp_raise_OSError(err);
     }
     if (out_sz == 0) {
         nlr_raise(mp_obj_new_exception(&mp_type_EOFError));
     }
-    return c;
+    data->source = self->src_buf + 1;
+    data->source_limit = self->src_buf + out_sz;
+    return self->src_buf[0];
+}
+
+STATIC bool decompio_seek_src(mp_obj_decompio_t *self, mp_off_t offset, int *err) {
+    const mp_stream_p_t *stream = mp_get_stream(self->src_stream);
+    if (stream->ioctl == NULL) {
+        *err = MP_EOPNOTSUPP;
+        return false;
+    }
+    struct mp_stream_seek_t seek_s = {offset, MP_SEEK_CUR};
+    return stream->ioctl(self->src_stream, MP_STREAM_SEEK, (uintptr_t)&seek_s, err) != MP_STREAM_ERROR;
+}
+
+// Give back the input that was read ahead but not used, so the source stream
+// is left just after the compressed data consumed so far.
+STATIC void decompio_unread_src(mp_obj_decompio_t *self) {
+    mp_int_t unused = self->decomp.source_limit - self->decomp.source;
+    self->decomp.source = self->decomp.source_limit;
+    int err;
+    if (unused > 0 && !decompio_seek_src(self, -unused, &err)) {
+        mp_raise_OSError(err);
+    }
 }
 
 STATIC mp_obj_t decompio_make_new(const mp_obj_type_t *type, size_t n_args, const mp_obj_t *args, mp_map_t *kw_args) {
@@ -78,6 +106,14 @@ STATIC mp_obj_t decompio_make_new(const mp_obj_type_t *type, size_t n_args, cons
     o->decomp.readSource = read_src_stream;
     o->src_stream = args[0];
     o->eof = false;
+    // a stream written in Python may not have an ioctl method at all
+    o->src_seekable = false;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        int err;
+        o->src_seekable = decompio_seek_src(o, 0, &err);
+        nlr_pop();
+    }
 
     mp_int_t dict_opt = 0;
     int dict_sz;
@@ -102,6 +138,7 @@ header_error:
         dict_sz = 1 << -dict_opt;
     }
 
+    decompio_unread_src(o);
     uzlib_uncompress_init(&o->decomp, m_new(byte, dict_sz), dict_sz);
     return MP_OBJ_FROM_PTR(o);
 }
@@ -115,6 +152,7 @@ STATIC mp_uint_t decompio_read(mp_obj_t o_in, void *buf, mp_uint_t size, int *er
     o->decomp.dest = buf;
     o->decomp.dest_limit = (unsigned char*)buf+size;
     int st = uzlib_uncompress_chksum(&o->decomp);
+    decompio_unread_src(o);
     if (st == TINF_DONE) {
         o->eof = true;
     }
@@ -184,11 +222,13 @@ STATIC mp_obj_t mod_uzlib_decompress(size_t n_args, const mp_obj_t *args) {
         if (st == TINF_DONE) {
             break;
         }
+        // grow the output geometrically so large data isn't copied many times
         size_t offset = decomp->dest - dest_buf;
-        dest_buf = m_renew(byte, dest_buf, dest_buf_size, dest_buf_size + 256);
-        dest_buf_size += 256;
+        size_t grow = dest_buf_size / 2 > 256 ? dest_buf_size / 2 : 256;
+        dest_buf = m_renew(byte, dest_buf, dest_buf_size, dest_buf_size + grow);
+        dest_buf_size += grow;
         decomp->dest = dest_buf + offset;
-        decomp->dest_limit = dest_buf + offset + 256;
+        decomp->dest_limit = dest_buf + dest_buf_size;
     }
 
     mp_uint_t final_sz = decomp->dest - dest_buf;
@@ -203,10 +243,149 @@ error:
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_uzlib_decompress_obj, 1, 3, mod_uzlib_decompress);
 
+#if MICROPY_PY_UZLIB_COMPRESS
+
+// Map a wbits argument to the window size in bits and the output format, the
+// same way as for decompression: 8 to 15 for zlib, -8 to -15 for raw deflate
+// and 24 to 31 for gzip.
+STATIC unsigned int compress_parse_wbits(mp_int_t wbits, int *format) {
+    if (wbits >= 8 && wbits <= 15) {
+        *format = UZLIB_DEFLATE_ZLIB;
+    } else if (wbits >= -15 && wbits <= -8) {
+        *format = UZLIB_DEFLATE_RAW;
+        wbits = -wbits;
+    } else if (wbits >= 16 + 8 && wbits <= 16 + 15) {
+        *format = UZLIB_DEFLATE_GZIP;
+        wbits -= 16;
+    } else {
+        mp_raise_ValueError(translate("invalid wbits"));
+    }
+    return wbits;
+}
+
+typedef struct _mp_obj_compio_t {
+    mp_obj_base_t base;
+    mp_obj_t dest_stream;
+    byte *mem;
+    size_t mem_size;
+    uzlib_deflate_t comp;
+} mp_obj_compio_t;
+
+STATIC void compio_out(void *data, const uint8_t *buf, size_t len) {
+    mp_obj_compio_t *self = data;
+    mp_stream_write(self->dest_stream, buf, len, MP_STREAM_RW_WRITE);
+}
+
+STATIC mp_obj_t compio_make_new(const mp_obj_type_t *type, size_t n_args, const mp_obj_t *args, mp_map_t *kw_args) {
+    mp_arg_check_num(n_args, kw_args, 1, 2, false);
+    mp_get_stream_raise(args[0], MP_STREAM_OP_WRITE);
+    int format;
+    unsigned int wbits = compress_parse_wbits(n_args > 1 ? mp_obj_get_int(args[1]) : MICROPY_PY_UZLIB_COMPRESS_WBITS, &format);
+    mp_obj_compio_t *o = m_new_obj(mp_obj_compio_t);
+    o->base.type = type;
+    o->dest_stream = args[0];
+    o->mem_size = uzlib_deflate_mem_size(wbits);
+    o->mem = m_new(byte, o->mem_size);
+    uzlib_deflate_init(&o->comp, wbits, format, o->mem, compio_out, o);
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_uint_t compio_write(mp_obj_t o_in, const void *buf, mp_uint_t size, int *errcode) {
+    mp_obj_compio_t *o = MP_OBJ_TO_PTR(o_in);
+    if (o->mem == NULL) {
+        *errcode = MP_EINVAL;
+        return MP_STREAM_ERROR;
+    }
+    uzlib_deflate_write(&o->comp, buf, size);
+    return size;
+}
+
+STATIC mp_uint_t compio_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg, int *errcode) {
+    (void)arg;
+    mp_obj_compio_t *o = MP_OBJ_TO_PTR(o_in);
+    switch (request) {
+        case MP_STREAM_FLUSH:
+            if (o->mem != NULL) {
+                uzlib_deflate_flush(&o->comp, false);
+            }
+            return 0;
+        case MP_STREAM_CLOSE:
+            // finishes the compressed stream, the destination stays open
+            if (o->mem != NULL) {
+                uzlib_deflate_flush(&o->comp, true);
+                m_del(byte, o->mem, o->mem_size);
+                o->mem = NULL;
+            }
+            return 0;
+        default:
+            *errcode = MP_EINVAL;
+            return MP_STREAM_ERROR;
+    }
+}
+
+STATIC mp_obj_t compio___exit__(size_t n_args, const mp_obj_t *args) {
+    (void)n_args;
+    return mp_stream_close(args[0]);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(compio___exit___obj, 4, 4, compio___exit__);
+
+STATIC const mp_rom_map_elem_t compio_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&mp_stream_write_obj) },
+    { MP_ROM_QSTR(MP_QSTR_flush), MP_ROM_PTR(&mp_stream_flush_obj) },
+    { MP_ROM_QSTR(MP_QSTR_close), MP_ROM_PTR(&mp_stream_close_obj) },
+    { MP_ROM_QSTR(MP_QSTR___enter__), MP_ROM_PTR(&mp_identity_obj) },
+    { MP_ROM_QSTR(MP_QSTR___exit__), MP_ROM_PTR(&compio___exit___obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(compio_locals_dict, compio_locals_dict_table);
+
+STATIC const mp_stream_p_t compio_stream_p = {
+    .write = compio_write,
+    .ioctl = compio_ioctl,
+};
+
+STATIC const mp_obj_type_t compio_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_CompIO,
+    .make_new = compio_make_new,
+    .protocol = &compio_stream_p,
+    .locals_dict = (void*)&compio_locals_dict,
+};
+
+STATIC void compress_vstr_out(void *data, const uint8_t *buf, size_t len) {
+    vstr_add_strn(data, (const char*)buf, len);
+}
+
+STATIC mp_obj_t mod_uzlib_compress(size_t n_args, const mp_obj_t *args) {
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[0], &bufinfo, MP_BUFFER_READ);
+    int format;
+    unsigned int wbits = compress_parse_wbits(n_args > 1 ? mp_obj_get_int(args[1]) : MICROPY_PY_UZLIB_COMPRESS_WBITS, &format);
+
+    vstr_t vstr;
+    vstr_init(&vstr, bufinfo.len / 2 + 32);
+    uzlib_deflate_t *comp = m_new_obj(uzlib_deflate_t);
+    size_t mem_size = uzlib_deflate_mem_size(wbits);
+    byte *mem = m_new(byte, mem_size);
+    uzlib_deflate_init(comp, wbits, format, mem, compress_vstr_out, &vstr);
+    uzlib_deflate_write(comp, bufinfo.buf, bufinfo.len);
+    uzlib_deflate_flush(comp, true);
+    m_del(byte, mem, mem_size);
+    m_del_obj(uzlib_deflate_t, comp);
+    return mp_obj_new_str_from_vstr(&mp_type_bytes, &vstr);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mod_uzlib_compress_obj, 1, 2, mod_uzlib_compress);
+
+#endif // MICROPY_PY_UZLIB_COMPRESS
+
 STATIC const mp_rom_map_elem_t mp_module_uzlib_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_uzlib) },
     { MP_ROM_QSTR(MP_QSTR_decompress), MP_ROM_PTR(&mod_uzlib_decompress_obj) },
     { MP_ROM_QSTR(MP_QSTR_DecompIO), MP_ROM_PTR(&decompio_type) },
+    #if MICROPY_PY_UZLIB_COMPRESS
+    { MP_ROM_QSTR(MP_QSTR_compress), MP_ROM_PTR(&mod_uzlib_compress_obj) },
+    { MP_ROM_QSTR(MP_QSTR_CompIO), MP_ROM_PTR(&compio_type) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_uzlib_globals, mp_module_uzlib_globals_table);
@@ -0,0 +1,243 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "re1.5.h"
+
+// Pike VM: runs all alternatives of the program in lockstep over the input,
+// so matching takes time linear in the length of the input and memory
+// bounded by the size of the program, and doesn't recurse.  Threads are kept
+// in priority order so the result is the same as the backtracking matchers'.
+
+typedef struct {
+    const char *ptr; // instruction to explore, or value to restore
+    int restore; // -1 to explore ptr, else index of capture to restore
+} PikeStackEntry;
+
+typedef struct {
+    ByteProg *prog;
+    Subject *input;
+    int nsubp;
+    int nthreads; // capacity of each thread list
+    unsigned char *marks; // instructions already added to the list being built
+    PikeStackEntry *stack;
+} PikeVM;
+
+typedef struct {
+    int n;
+    const char **pcs;
+    const char **caps; // nsubp entries per thread
+} PikeList;
+
+// Add the thread at pc to list, following jumps, splits and assertions so
+// that only consuming instructions and Match are added.  caps is updated
+// while following Saves but is restored on return.
+static void
+addthread(PikeVM *vm, PikeList *list, const char *pc, const char *sp, const char **caps)
+{
+    int sp_idx = 0;
+    vm->stack[sp_idx].ptr = pc;
+    vm->stack[sp_idx++].restore = -1;
+    while (sp_idx > 0) {
+        PikeStackEntry *e = &vm->stack[--sp_idx];
+        if (e->restore >= 0) {
+            caps[e->restore] = e->ptr;
+            continue;
+        }
+        pc = e->ptr;
+        for (;;) {
+            int off = pc - vm->prog->insts;
+            if (vm->marks[off >> 3] & (1 << (off & 7))) {
+                break;
+            }
+            vm->marks[off >> 3] |= 1 << (off & 7);
+            switch (*pc) {
+            case Jmp:
+                pc = pc + 2 + (signed char)pc[1];
+                continue;
+            case Split:
+                // second alternative has lower priority, so is explored later
+                vm->stack[sp_idx].ptr = pc + 2 + (signed char)pc[1];
+                vm->stack[sp_idx++].restore = -1;
+                pc += 2;
+                continue;
+            case RSplit:
+                vm->stack[sp_idx].ptr = pc + 2;
+                vm->stack[sp_idx++].restore = -1;
+                pc = pc + 2 + (signed char)pc[1];
+                continue;
+            case Save:
+                off = (unsigned char)pc[1];
+                if (off < vm->nsubp) {
+                    vm->stack[sp_idx].ptr = caps[off];
+                    vm->stack[sp_idx++].restore = off;
+                    caps[off] = sp;
+                }
+                pc += 2;
+                continue;
+            case Bol:
+                if (sp != vm->input->begin_line) {
+                    break;
+                }
+                pc++;
+                continue;
+            case Eol:
+                if (sp != vm->input->end) {
+                    break;
+                }
+                pc++;
+                continue;
+            default:
+                list->pcs[list->n] = pc;
+                memcpy((char*)&list->caps[list->n * vm->nsubp], (char*)caps, vm->nsubp * sizeof(*caps));
+                list->n++;
+                break;
+            }
+            break;
+        }
+    }
+}
+
+// Return the first instruction which consumes input, skipping Saves.
+static const char *
+firstconsumer(const char *pc)
+{
+    while (*pc == Save) {
+        pc += 2;
+    }
+    return pc;
+}
+
+int
+re1_5_pikevm(ByteProg *prog, Subject *input, const char **subp, int nsubp, int is_anchored)
+{
+    PikeVM vm;
+    vm.prog = prog;
+    vm.input = input;
+    vm.nsubp = nsubp;
+    vm.nthreads = prog->len;
+    size_t marks_len = (prog->bytelen + 7) / 8;
+    size_t mem_len = 2 * vm.nthreads * (nsubp + 1) * sizeof(char*)
+        + (prog->len + 1) * sizeof(PikeStackEntry) + marks_len;
+    char *mem = re1_5_alloc(mem_len);
+
+    PikeList lists[2];
+    const char **p = (const char**)mem;
+    for (int i = 0; i < 2; i++) {
+        lists[i].n = 0;
+        lists[i].pcs = p;
+        p += vm.nthreads;
+        lists[i].caps = p;
+        p += vm.nthreads * nsubp;
+    }
+    vm.stack = (PikeStackEntry*)p;
+    vm.marks = (unsigned char*)(vm.stack + prog->len + 1);
+    PikeList *clist = &lists[0];
+    PikeList *nlist = &lists[1];
+
+    const char *start = HANDLE_ANCHORED(prog->insts, is_anchored);
+    // For a search, the Any of the prefix moves the start of the match along.
+    // If the pattern starts with a literal character then, while no match is
+    // in progress, positions without that character can be skipped.
+    const char *scan = prog->insts + 2;
+    const char *first = firstconsumer(prog->insts + NON_ANCHORED_PREFIX);
+    int skip = !is_anchored && *first == Char;
+
+    const char *sp = input->begin;
+    memset(subp, 0, nsubp * sizeof(*subp));
+    memset(vm.marks, 0, marks_len);
+    addthread(&vm, clist, start, sp, subp);
+    int matched = 0;
+
+    for (;;) {
+        if (skip && !matched && clist->n == 2 && clist->pcs[0] == first && clist->pcs[1] == scan
+            && sp < input->end && *sp != first[1]) {
+            sp = memchr(sp, first[1], input->end - sp);
+            if (sp == NULL) {
+                break;
+            }
+            clist->n = 0;
+            memset(vm.marks, 0, marks_len);
+            memset(subp, 0, nsubp * sizeof(*subp));
+            addthread(&vm, clist, prog->insts + NON_ANCHORED_PREFIX, sp, subp);
+            addthread(&vm, clist, scan, sp, subp);
+        }
+        if (clist->n == 0) {
+            break;
+        }
+        nlist->n = 0;
+        memset(vm.marks, 0, marks_len);
+        for (int i = 0; i < clist->n; i++) {
+            const char *pc = clist->pcs[i];
+            const char **caps = &clist->caps[i * nsubp];
+            if (*pc == Match) {
+                // lower priority threads can't give the result, drop them
+                memcpy((char*)subp, (char*)caps, nsubp * sizeof(*caps));
+                matched = 1;
+                break;
+            }
+            if (sp >= input->end) {
+                continue;
+            }
+            switch (*pc) {
+            case Char:
+                if (*sp != pc[1]) {
+                    continue;
+                }
+                pc += 2;
+                break;
+            case Any:
+                pc++;
+                break;
+            case Class:
+            case ClassNot:
+                if (!_re1_5_classmatch(pc + 1, sp)) {
+                    continue;
+                }
+                pc += *(unsigned char*)(pc + 1) * 2 + 2;
+                break;
+            case NamedClass:
+                if (!_re1_5_namedclassmatch(pc + 1, sp)) {
+                    continue;
+                }
+                pc += 2;
+                break;
+            default:
+                re1_5_fatal("pikevm");
+            }
+            addthread(&vm, nlist, pc, sp + 1, caps);
+        }
+        if (sp >= input->end) {
+            break;
+        }
+        PikeList *t = clist;
+        clist = nlist;
+        nlist = t;
+        sp++;
+    }
+
+    re1_5_free(mem, mem_len);
+    return matched;
+}
@@ -51,6 +51,10 @@ void re1_5_fatal(char*);
 #ifndef re1_5_stack_chk
 #define re1_5_stack_chk()
 #endif
+#ifndef re1_5_alloc
+#define re1_5_alloc(n) malloc(n)
+#define re1_5_free(p, n) free(p)
+#endif
 void *mal(int);
 
 struct Prog
@@ -132,6 +136,7 @@ void decref(Sub*);
 struct Subject {
 	const char *begin;
 	const char *end;
+	const char *begin_line; // where ^ matches, may be before begin
 };
 
 
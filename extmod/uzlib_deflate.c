@@ -0,0 +1,340 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "py/mpconfig.h"
+
+#if MICROPY_PY_UZLIB && MICROPY_PY_UZLIB_COMPRESS
+
+#include "extmod/uzlib_deflate.h"
+#include "../../lib/uzlib/src/tinf.h"
+
+#define MIN_MATCH (3)
+#define MAX_MATCH (258)
+
+// The lookahead must hold a maximal match plus the bytes still waiting to be
+// coded; it's at least the window size so the window is slid in large steps.
+#define LOOKAHEAD(wsize) ((wsize) > 2 * MAX_MATCH ? (wsize) : 2 * MAX_MATCH)
+
+STATIC unsigned int deflate_window_bits(unsigned int wbits) {
+    return wbits < UZLIB_DEFLATE_MAX_WBITS ? wbits : UZLIB_DEFLATE_MAX_WBITS;
+}
+
+STATIC unsigned int deflate_hash_bits(unsigned int wbits) {
+    wbits = deflate_window_bits(wbits);
+    return wbits > 9 ? wbits - 1 : 8;
+}
+
+size_t uzlib_deflate_mem_size(unsigned int wbits) {
+    size_t wsize = 1 << deflate_window_bits(wbits);
+    return ((1 << deflate_hash_bits(wbits)) + wsize) * sizeof(uint16_t) + wsize + LOOKAHEAD(wsize);
+}
+
+/******************************************************************************/
+// bit output
+
+STATIC void deflate_out_flush(uzlib_deflate_t *d) {
+    if (d->out_len > 0) {
+        d->out(d->out_data, d->out_buf, d->out_len);
+        d->out_len = 0;
+    }
+}
+
+STATIC void deflate_out_byte(uzlib_deflate_t *d, uint8_t b) {
+    d->out_buf[d->out_len++] = b;
+    if (d->out_len == sizeof(d->out_buf)) {
+        deflate_out_flush(d);
+    }
+}
+
+// Write the low n bits of value, least significant bit first; n <= 24.
+STATIC void deflate_put_bits(uzlib_deflate_t *d, uint32_t value, unsigned int n) {
+    d->bits |= value << d->nbits;
+    d->nbits += n;
+    while (d->nbits >= 8) {
+        deflate_out_byte(d, d->bits);
+        d->bits >>= 8;
+        d->nbits -= 8;
+    }
+}
+
+STATIC void deflate_align(uzlib_deflate_t *d) {
+    if (d->nbits > 0) {
+        deflate_put_bits(d, 0, 8 - d->nbits);
+    }
+}
+
+// Huffman codes are sent most significant bit first, so reverse them.
+static inline uint32_t deflate_rev8(uint32_t b) {
+    b = (b & 0xf0) >> 4 | (b & 0x0f) << 4;
+    b = (b & 0xcc) >> 2 | (b & 0x33) << 2;
+    b = (b & 0xaa) >> 1 | (b & 0x55) << 1;
+    return b;
+}
+
+// Write a literal/length symbol using the fixed code of RFC 1951 3.2.6.
+STATIC void deflate_put_lit(uzlib_deflate_t *d, unsigned int sym) {
+    if (sym < 144) {
+        deflate_put_bits(d, deflate_rev8(0x30 + sym), 8);
+    } else if (sym < 256) {
+        sym += 0x190 - 144;
+        deflate_put_bits(d, deflate_rev8(sym >> 1) | (sym & 1) << 8, 9);
+    } else if (sym < 280) {
+        deflate_put_bits(d, deflate_rev8(sym - 256) >> 1, 7);
+    } else {
+        deflate_put_bits(d, deflate_rev8(0xc0 + sym - 280), 8);
+    }
+}
+
+STATIC unsigned int deflate_log2(unsigned int x) {
+    unsigned int n = 0;
+    while (x >>= 1) {
+        n += 1;
+    }
+    return n;
+}
+
+STATIC void deflate_put_match(uzlib_deflate_t *d, unsigned int len, unsigned int dist) {
+    // length, 3-258, as symbol 257-285 and extra bits
+    if (len == MAX_MATCH) {
+        deflate_put_lit(d, 285);
+    } else {
+        unsigned int l = len - MIN_MATCH;
+        if (l < 8) {
+            deflate_put_lit(d, 257 + l);
+        } else {
+            unsigned int e = deflate_log2(l) - 2;
+            deflate_put_lit(d, 257 + 4 * e + 4 + ((l >> e) & 3));
+            deflate_put_bits(d, l & ((1 << e) - 1), e);
+        }
+    }
+
+    // distance, 1-32768, as code 0-29 and extra bits
+    unsigned int dd = dist - 1;
+    if (dd < 4) {
+        deflate_put_bits(d, deflate_rev8(dd) >> 3, 5);
+    } else {
+        unsigned int e = deflate_log2(dd) - 1;
+        deflate_put_bits(d, deflate_rev8(2 * e + 2 + ((dd >> e) & 1)) >> 3, 5);
+        deflate_put_bits(d, dd & ((1 << e) - 1), e);
+    }
+}
+
+STATIC void deflate_start_block(uzlib_deflate_t *d, bool final) {
+    // BFINAL and BTYPE=01, fixed Huffman codes
+    deflate_put_bits(d, final | 1 << 1, 3);
+}
+
+/******************************************************************************/
+// matching
+
+STATIC unsigned int deflate_hash(uzlib_deflate_t *d, const uint8_t *p) {
+    uint32_t v = (uint32_t)p[0] << 16 | p[1] << 8 | p[2];
+    return (v * 2654435761u) >> (32 - d->hash_bits);
+}
+
+// Add the string at pos to the hash chains and return the previous
+// position+1 with the same hash, or 0 if there is none.
+STATIC unsigned int deflate_insert(uzlib_deflate_t *d, unsigned int pos) {
+    unsigned int h = deflate_hash(d, d->buf + pos);
+    unsigned int cand = d->head[h];
+    d->prev[(pos + d->slid) & (d->wsize - 1)] = cand;
+    d->head[h] = pos + 1;
+    return cand;
+}
+
+STATIC unsigned int deflate_longest_match(uzlib_deflate_t *d, unsigned int cand, unsigned int max_len, unsigned int *dist_out) {
+    const uint8_t *s = d->buf + d->pos;
+    unsigned int best_len = MIN_MATCH - 1;
+    for (unsigned int chain = UZLIB_DEFLATE_MAX_CHAIN; cand != 0 && chain > 0; --chain) {
+        unsigned int c = cand - 1;
+        if (c + d->wsize <= d->pos) {
+            // too far back, and so is the rest of the chain
+            break;
+        }
+        const uint8_t *m = d->buf + c;
+        if (m[best_len] == s[best_len] && m[0] == s[0]) {
+            unsigned int len = 1;
+            while (len < max_len && m[len] == s[len]) {
+                ++len;
+            }
+            if (len > best_len) {
+                best_len = len;
+                *dist_out = d->pos - c;
+                if (len == max_len) {
+                    break;
+                }
+            }
+        }
+        cand = d->prev[(c + d->slid) & (d->wsize - 1)];
+        if (cand > c) {
+            // slot was reused by a newer position, the chain ends here
+            break;
+        }
+    }
+    return best_len;
+}
+
+// Code buffered input.  Unless flushing, enough lookahead is kept back that
+// a maximal match can be found at every coded position.
+STATIC void deflate_process(uzlib_deflate_t *d, bool flush) {
+    while (d->pos < d->end) {
+        unsigned int avail = d->end - d->pos;
+        if (avail < MAX_MATCH && !flush) {
+            break;
+        }
+        unsigned int len = 0;
+        unsigned int dist = 0;
+        if (avail >= MIN_MATCH) {
+            unsigned int cand = deflate_insert(d, d->pos);
+            len = deflate_longest_match(d, cand, avail < MAX_MATCH ? avail : MAX_MATCH, &dist);
+        }
+        if (len >= MIN_MATCH) {
+            deflate_put_match(d, len, dist);
+            // the strings starting inside the match are candidates for later matches
+            unsigned int end = d->pos + len;
+            while (++d->pos < end) {
+                if (d->end - d->pos >= MIN_MATCH) {
+                    deflate_insert(d, d->pos);
+                }
+            }
+        } else {
+            deflate_put_lit(d, d->buf[d->pos++]);
+        }
+    }
+}
+
+// Discard the oldest data so the buffer has room for more input, keeping
+// wsize bytes of history.
+STATIC void deflate_slide(uzlib_deflate_t *d) {
+    unsigned int shift = d->pos - d->wsize;
+    memmove(d->buf, d->buf + shift, d->end - shift);
+    d->pos -= shift;
+    d->end -= shift;
+    d->slid = (d->slid + shift) & (d->wsize - 1);
+    for (size_t i = 0; i < (1u << d->hash_bits); ++i) {
+        d->head[i] = d->head[i] > shift ? d->head[i] - shift : 0;
+    }
+    for (size_t i = 0; i < d->wsize; ++i) {
+        d->prev[i] = d->prev[i] > shift ? d->prev[i] - shift : 0;
+    }
+}
+
+/******************************************************************************/
+// public API
+
+void uzlib_deflate_init(uzlib_deflate_t *d, unsigned int wbits, int format, void *mem,
+    uzlib_deflate_out_t out, void *out_data) {
+    memset(d, 0, sizeof(*d));
+    d->out = out;
+    d->out_data = out_data;
+    d->format = format;
+    d->wsize = 1 << deflate_window_bits(wbits);
+    d->buf_size = d->wsize + LOOKAHEAD(d->wsize);
+    d->hash_bits = deflate_hash_bits(wbits);
+    d->head = mem;
+    d->prev = d->head + (1 << d->hash_bits);
+    d->buf = (uint8_t*)(d->prev + d->wsize);
+    memset(d->head, 0, ((1 << d->hash_bits) + d->wsize) * sizeof(uint16_t));
+
+    if (format == UZLIB_DEFLATE_ZLIB) {
+        // CM=8 (deflate) and CINFO=log2(window size)-8, with FCHECK making
+        // the header a multiple of 31
+        uint8_t cmf = (wbits - 8) << 4 | 8;
+        deflate_out_byte(d, cmf);
+        deflate_out_byte(d, 31 - ((cmf << 8) % 31));
+        d->check = 1;
+    } else if (format == UZLIB_DEFLATE_GZIP) {
+        // magic, CM=8, no flags, no mtime, no extra flags, unknown OS
+        static const uint8_t gzip_header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+        for (size_t i = 0; i < sizeof(gzip_header); ++i) {
+            deflate_out_byte(d, gzip_header[i]);
+        }
+        d->check = 0xffffffff;
+    }
+
+    deflate_start_block(d, false);
+}
+
+void uzlib_deflate_write(uzlib_deflate_t *d, const uint8_t *data, size_t len) {
+    if (d->format == UZLIB_DEFLATE_ZLIB) {
+        d->check = uzlib_adler32(data, len, d->check);
+    } else if (d->format == UZLIB_DEFLATE_GZIP) {
+        d->check = uzlib_crc32(data, len, d->check);
+    }
+    d->in_len += len;
+
+    while (len > 0) {
+        if (d->end == d->buf_size) {
+            deflate_slide(d);
+        }
+        size_t n = d->buf_size - d->end;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(d->buf + d->end, data, n);
+        d->end += n;
+        data += n;
+        len -= n;
+        deflate_process(d, false);
+    }
+}
+
+void uzlib_deflate_flush(uzlib_deflate_t *d, bool finish) {
+    deflate_process(d, true);
+    deflate_put_lit(d, 256);
+    if (finish) {
+        // an empty final block ends the stream
+        deflate_start_block(d, true);
+        deflate_put_lit(d, 256);
+        deflate_align(d);
+        uint32_t trailer[2] = {d->check, d->in_len};
+        if (d->format == UZLIB_DEFLATE_ZLIB) {
+            for (int i = 24; i >= 0; i -= 8) {
+                deflate_out_byte(d, trailer[0] >> i);
+            }
+        } else if (d->format == UZLIB_DEFLATE_GZIP) {
+            trailer[0] ^= 0xffffffff;
+            for (int j = 0; j < 2; ++j) {
+                for (int i = 0; i < 32; i += 8) {
+                    deflate_out_byte(d, trailer[j] >> i);
+                }
+            }
+        }
+    } else {
+        // an empty stored block byte-aligns the output so the receiver can
+        // decode everything written so far, then coding continues
+        deflate_put_bits(d, 0, 3);
+        deflate_align(d);
+        deflate_put_bits(d, 0x0000, 16); // LEN
+        deflate_put_bits(d, 0xffff, 16); // NLEN
+        deflate_start_block(d, false);
+    }
+    deflate_out_flush(d);
+}
+
+#endif // MICROPY_PY_UZLIB && MICROPY_PY_UZLIB_COMPRESS
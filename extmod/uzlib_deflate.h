@@ -0,0 +1,88 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MICROPY_INCLUDED_EXTMOD_UZLIB_DEFLATE_H
+#define MICROPY_INCLUDED_EXTMOD_UZLIB_DEFLATE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A streaming DEFLATE compressor with bounded memory use.  Matches are found
+// with hash chains over a sliding window and coded with the fixed Huffman
+// codes of RFC 1951, so no per-block code tables need to be built or sent.
+
+#define UZLIB_DEFLATE_RAW (0)
+#define UZLIB_DEFLATE_ZLIB (1)
+#define UZLIB_DEFLATE_GZIP (2)
+
+// The window used for matching is capped at this many bits; a larger window
+// can still be advertised in the header because shorter distances are valid.
+#define UZLIB_DEFLATE_MAX_WBITS (14)
+
+// Number of earlier positions with the same hash tried when looking for a match.
+#ifndef UZLIB_DEFLATE_MAX_CHAIN
+#define UZLIB_DEFLATE_MAX_CHAIN (16)
+#endif
+
+typedef void (*uzlib_deflate_out_t)(void *out_data, const uint8_t *buf, size_t len);
+
+typedef struct _uzlib_deflate_t {
+    uzlib_deflate_out_t out;
+    void *out_data;
+    uint16_t *head; // most recent position+1 for each hash value
+    uint16_t *prev; // previous position+1 with the same hash, indexed by absolute position
+    uint8_t *buf; // history of wsize bytes followed by the lookahead
+    uint16_t wsize;
+    uint16_t buf_size;
+    uint16_t pos; // next byte of buf to be coded
+    uint16_t end; // end of the data in buf
+    uint16_t slid; // total bytes slid out of buf, modulo wsize
+    uint8_t hash_bits;
+    uint8_t format;
+    uint8_t nbits;
+    uint8_t out_len;
+    uint32_t bits;
+    uint32_t check; // Adler-32 or CRC-32 of the input
+    uint32_t in_len;
+    uint8_t out_buf[32];
+} uzlib_deflate_t;
+
+// Return the size of the work area needed for a window of 2**wbits bytes.
+size_t uzlib_deflate_mem_size(unsigned int wbits);
+
+// Start a stream.  wbits is 8-15 and mem is a uint16_t-aligned work area of
+// uzlib_deflate_mem_size(wbits) bytes.  The header is written out immediately.
+void uzlib_deflate_init(uzlib_deflate_t *d, unsigned int wbits, int format, void *mem,
+    uzlib_deflate_out_t out, void *out_data);
+
+void uzlib_deflate_write(uzlib_deflate_t *d, const uint8_t *data, size_t len);
+
+// Code all buffered input and write out everything produced so far.  If
+// finish is false the stream is sync flushed and can be continued, otherwise
+// it's ended and the trailer is written.
+void uzlib_deflate_flush(uzlib_deflate_t *d, bool finish);
+
+#endif // MICROPY_INCLUDED_EXTMOD_UZLIB_DEFLATE_H
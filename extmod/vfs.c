@@ -118,12 +118,11 @@ STATIC mp_obj_t mp_vfs_proxy_call(mp_vfs_mount_t *vfs, qstr meth_name, size_t n_
     return mp_call_method_n_kw(n_args, 0, meth);
 }
 
-mp_import_stat_t mp_vfs_import_stat(const char *path) {
-    const char *path_out;
-    mp_vfs_mount_t *vfs = mp_vfs_lookup_path(path, &path_out);
-    if (vfs == MP_VFS_NONE || vfs == MP_VFS_ROOT) {
-        return MP_IMPORT_STAT_NO_EXIST;
-    }
+// Ask the filesystem mounted at vfs whether path_out (a path within it) exists.
+STATIC mp_import_stat_t vfs_import_stat(mp_vfs_mount_t *vfs, const char *path_out) {
+    #if MICROPY_PY_MICROPYTHON_MEM_INFO
+    MP_STATE_VM(vfs_import_stat_count) += 1;
+    #endif
 
     // If the mounted object has the VFS protocol, call its import_stat helper
     const mp_vfs_proto_t *proto = mp_obj_get_type(vfs->obj)->protocol;
@@ -152,6 +151,160 @@ mp_import_stat_t mp_vfs_import_stat(const char *path) {
     }
 }
 
+#if MICROPY_VFS_IMPORT_STAT_CACHE
+
+// Import probes every sys.path entry for a package dir, a .py and a .mpy, so
+// instead of stat'ing each candidate the directory is listed once and the
+// names are answered from that listing.  The cache maps a directory prefix (as
+// passed to mp_vfs_import_stat) to either a dict of name -> mp_import_stat_t,
+// None if the directory doesn't exist, or False if it can't be listed.  It is
+// dropped whenever the filesystem may have changed.
+
+// Longest name that is looked up case-insensitively in the cache; longer
+// names are stat'ed instead.
+#define IMPORT_STAT_FOLD_MAX (32)
+
+void mp_vfs_import_stat_cache_clear(void) {
+    MP_STATE_VM(vfs_import_stat_cache) = MP_OBJ_NULL;
+}
+
+// FAT matches names regardless of ASCII case, so the listings of FAT mounts are
+// kept in lower case and the names looked up in them are folded to match.
+STATIC bool import_stat_fold_case(mp_vfs_mount_t *vfs) {
+    #if MICROPY_VFS_FAT
+    return mp_obj_get_type(vfs->obj) == &mp_fat_vfs_type;
+    #else
+    (void)vfs;
+    return false;
+    #endif
+}
+
+// Copy str to dest in lower case.  Returns false if a non-ASCII character
+// makes the case folding of the filesystem unknown.
+STATIC bool import_stat_fold(char *dest, const char *str, size_t len) {
+    for (size_t i = 0; i < len; ++i) {
+        if ((byte)str[i] >= 0x80) {
+            return false;
+        }
+        dest[i] = unichar_tolower(str[i]);
+    }
+    return true;
+}
+
+STATIC mp_obj_t import_stat_list_dir(mp_vfs_mount_t *vfs, const char *dir, size_t dir_len) {
+    mp_obj_t dir_o = mp_obj_new_str(dir, dir_len);
+    bool fold_case = import_stat_fold_case(vfs);
+    mp_obj_t listing = mp_obj_new_dict(0);
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        #if MICROPY_PY_MICROPYTHON_MEM_INFO
+        MP_STATE_VM(vfs_import_stat_count) += 1;
+        #endif
+        mp_obj_t iter = mp_vfs_proxy_call(vfs, MP_QSTR_ilistdir, 1, &dir_o);
+        mp_obj_t next;
+        while ((next = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
+            // entries are (name, type, inode[, size])
+            size_t len;
+            mp_obj_t *items;
+            mp_obj_get_array(next, &len, &items);
+            mp_import_stat_t stat = MP_IMPORT_STAT_FILE;
+            if (mp_obj_get_int(items[1]) & MP_S_IFDIR) {
+                stat = MP_IMPORT_STAT_DIR;
+            }
+            mp_obj_t name = items[0];
+            if (fold_case) {
+                size_t name_len;
+                const char *str = mp_obj_str_get_data(name, &name_len);
+                vstr_t vstr;
+                vstr_init_len(&vstr, name_len);
+                // names that can't be folded are never looked up
+                import_stat_fold(vstr.buf, str, name_len);
+                name = mp_obj_new_str_from_vstr(&mp_type_str, &vstr);
+            }
+            mp_obj_dict_store(listing, name, MP_OBJ_NEW_SMALL_INT(stat));
+        }
+        nlr_pop();
+        return listing;
+    }
+
+    // Only cache a missing directory as such; a directory that exists but
+    // can't be listed (eg the current dir on a filesystem that doesn't accept
+    // the empty path, or a filesystem without ilistdir) falls back to a stat
+    // per name.  The root of a mounted filesystem always exists.
+    if (dir_len > 0 && !(dir_len == 1 && dir[0] == '/')
+        && vfs_import_stat(vfs, mp_obj_str_get_str(dir_o)) == MP_IMPORT_STAT_NO_EXIST) {
+        return mp_const_none;
+    }
+    return mp_const_false;
+}
+
+// Look up a str in a dict without allocating a str object for it.
+STATIC mp_map_elem_t *import_stat_cache_lookup(mp_obj_t dict, const char *str, size_t len) {
+    mp_obj_str_t key = {{&mp_type_str}, qstr_compute_hash((const byte*)str, len), len, (const byte*)str};
+    return mp_map_lookup(mp_obj_dict_get_map(dict), MP_OBJ_FROM_PTR(&key), MP_MAP_LOOKUP);
+}
+
+#endif // MICROPY_VFS_IMPORT_STAT_CACHE
+
+mp_import_stat_t mp_vfs_import_stat(const char *path) {
+    const char *path_out;
+    mp_vfs_mount_t *vfs = mp_vfs_lookup_path(path, &path_out);
+    if (vfs == MP_VFS_NONE || vfs == MP_VFS_ROOT) {
+        return MP_IMPORT_STAT_NO_EXIST;
+    }
+
+    #if MICROPY_VFS_IMPORT_STAT_CACHE
+    // A mount point doesn't appear in the listing of its parent, so only
+    // paths strictly within a mounted filesystem are answered from the cache.
+    // Otherwise path_out is a suffix of path and the last component is shared.
+    const char *name = strrchr(path, '/');
+    name = name == NULL ? path : name + 1;
+    if (*name != '\0' && !(path_out[0] == '/' && path_out[1] == '\0')) {
+        mp_obj_t cache = MP_STATE_VM(vfs_import_stat_cache);
+        if (cache == MP_OBJ_NULL) {
+            cache = mp_obj_new_dict(0);
+            MP_STATE_VM(vfs_import_stat_cache) = cache;
+        }
+        mp_obj_t listing;
+        mp_map_elem_t *elem = import_stat_cache_lookup(cache, path, name - path);
+        if (elem != NULL) {
+            listing = elem->value;
+        } else {
+            // the directory within the vfs: "" for a bare relative name,
+            // "/" for a name at the root, else everything before the last /
+            size_t dir_len = 0;
+            if (name > path_out) {
+                dir_len = name - 1 - path_out;
+                if (dir_len == 0) {
+                    dir_len = 1;
+                }
+            }
+            listing = import_stat_list_dir(vfs, path_out, dir_len);
+            mp_obj_dict_store(cache, mp_obj_new_str(path, name - path), listing);
+        }
+        if (listing == mp_const_none) {
+            return MP_IMPORT_STAT_NO_EXIST;
+        } else if (listing != mp_const_false) {
+            size_t name_len = strlen(name);
+            char folded[IMPORT_STAT_FOLD_MAX];
+            if (import_stat_fold_case(vfs)) {
+                if (name_len > sizeof(folded) || !import_stat_fold(folded, name, name_len)) {
+                    return vfs_import_stat(vfs, path_out);
+                }
+                name = folded;
+            }
+            elem = import_stat_cache_lookup(listing, name, name_len);
+            if (elem == NULL) {
+                return MP_IMPORT_STAT_NO_EXIST;
+            }
+            return MP_OBJ_SMALL_INT_VALUE(elem->value);
+        }
+    }
+    #endif
+
+    return vfs_import_stat(vfs, path_out);
+}
+
 mp_obj_t mp_vfs_mount(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     enum { ARG_readonly, ARG_mkfs };
     static const mp_arg_t allowed_args[] = {
@@ -163,6 +316,8 @@ mp_obj_t mp_vfs_mount(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args
     mp_arg_val_t args[MP_ARRAY_SIZE(allowed_args)];
     mp_arg_parse_all(n_args - 2, pos_args + 2, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
+    mp_vfs_import_stat_cache_clear();
+
     // get the mount point
     size_t mnt_len;
     const char *mnt_str = mp_obj_str_get_data(pos_args[1], &mnt_len);
@@ -238,6 +393,8 @@ mp_obj_t mp_vfs_umount(mp_obj_t mnt_in) {
         mp_raise_OSError(MP_EINVAL);
     }
 
+    mp_vfs_import_stat_cache_clear();
+
     // if we unmounted the current device then set current to root
     if (MP_STATE_VM(vfs_cur) == vfs) {
         MP_STATE_VM(vfs_cur) = MP_VFS_ROOT;
@@ -265,6 +422,13 @@ mp_obj_t mp_vfs_open(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
     mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
     mp_vfs_mount_t *vfs = lookup_path(args[ARG_file].u_obj, &args[ARG_file].u_obj);
+    #if MICROPY_VFS_IMPORT_STAT_CACHE
+    // opening with any mode other than reading may create the file
+    const char *mode = mp_obj_str_get_str(args[ARG_mode].u_obj);
+    if (mode[strspn(mode, "rbt")] != '\0') {
+        mp_vfs_import_stat_cache_clear();
+    }
+    #endif
     return mp_vfs_proxy_call(vfs, MP_QSTR_open, 2, (mp_obj_t*)&args);
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(mp_vfs_open_obj, 0, mp_vfs_open);
@@ -272,6 +436,7 @@ MP_DEFINE_CONST_FUN_OBJ_KW(mp_vfs_open_obj, 0, mp_vfs_open);
 mp_obj_t mp_vfs_chdir(mp_obj_t path_in) {
     mp_obj_t path_out;
     mp_vfs_mount_t *vfs = lookup_path(path_in, &path_out);
+    mp_vfs_import_stat_cache_clear();
     MP_STATE_VM(vfs_cur) = vfs;
     if (vfs == MP_VFS_ROOT) {
         // If we change to the root dir and a VFS is mounted at the root then
@@ -385,6 +550,7 @@ mp_obj_t mp_vfs_mkdir(mp_obj_t path_in) {
     if (vfs == MP_VFS_ROOT || (vfs != MP_VFS_NONE && !strcmp(mp_obj_str_get_str(path_out), "/"))) {
         mp_raise_OSError(MP_EEXIST);
     }
+    mp_vfs_import_stat_cache_clear();
     return mp_vfs_proxy_call(vfs, MP_QSTR_mkdir, 1, &path_out);
 }
 MP_DEFINE_CONST_FUN_OBJ_1(mp_vfs_mkdir_obj, mp_vfs_mkdir);
@@ -392,6 +558,7 @@ MP_DEFINE_CONST_FUN_OBJ_1(mp_vfs_mkdir_obj, mp_vfs_mkdir);
 mp_obj_t mp_vfs_remove(mp_obj_t path_in) {
     mp_obj_t path_out;
     mp_vfs_mount_t *vfs = lookup_path(path_in, &path_out);
+    mp_vfs_import_stat_cache_clear();
     return mp_vfs_proxy_call(vfs, MP_QSTR_remove, 1, &path_out);
 }
 MP_DEFINE_CONST_FUN_OBJ_1(mp_vfs_remove_obj, mp_vfs_remove);
@@ -404,6 +571,7 @@ mp_obj_t mp_vfs_rename(mp_obj_t old_path_in, mp_obj_t new_path_in) {
         // can't rename across filesystems
         mp_raise_OSError(MP_EPERM);
     }
+    mp_vfs_import_stat_cache_clear();
     return mp_vfs_proxy_call(old_vfs, MP_QSTR_rename, 2, args);
 }
 MP_DEFINE_CONST_FUN_OBJ_2(mp_vfs_rename_obj, mp_vfs_rename);
@@ -411,6 +579,7 @@ MP_DEFINE_CONST_FUN_OBJ_2(mp_vfs_rename_obj, mp_vfs_rename);
 mp_obj_t mp_vfs_rmdir(mp_obj_t path_in) {
     mp_obj_t path_out;
     mp_vfs_mount_t *vfs = lookup_path(path_in, &path_out);
+    mp_vfs_import_stat_cache_clear();
     return mp_vfs_proxy_call(vfs, MP_QSTR_rmdir, 1, &path_out);
 }
 MP_DEFINE_CONST_FUN_OBJ_1(mp_vfs_rmdir_obj, mp_vfs_rmdir);
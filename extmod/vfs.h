@@ -72,6 +72,11 @@ mp_obj_t mp_vfs_ilistdir_it_iternext(mp_obj_t self_in);
 
 mp_vfs_mount_t *mp_vfs_lookup_path(const char *path, const char **path_out);
 mp_import_stat_t mp_vfs_import_stat(const char *path);
+#if MICROPY_VFS_IMPORT_STAT_CACHE
+void mp_vfs_import_stat_cache_clear(void);
+#else
+static inline void mp_vfs_import_stat_cache_clear(void) {}
+#endif
 mp_obj_t mp_vfs_mount(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args);
 mp_obj_t mp_vfs_umount(mp_obj_t mnt_in);
 mp_obj_t mp_vfs_open(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args);
@@ -114,6 +114,7 @@ STATIC mp_obj_t fat_vfs_mkfs(mp_obj_t bdev_in) {
     fs_user_mount_t *vfs = MP_OBJ_TO_PTR(fat_vfs_make_new(&mp_fat_vfs_type, 1, &bdev_in, NULL));
 
     // make the filesystem
+    mp_vfs_import_stat_cache_clear();
     uint8_t working_buf[_MAX_SS];
     FRESULT res = f_mkfs(&vfs->fatfs, FM_FAT | FM_SFD, 0, working_buf, sizeof(working_buf));
     if (res != FR_OK) {
@@ -212,6 +213,7 @@ STATIC mp_obj_t fat_vfs_remove_internal(mp_obj_t vfs_in, mp_obj_t path_in, mp_in
 
     // check if path is a file or directory
     if ((fno.fattrib & AM_DIR) == attr) {
+        mp_vfs_import_stat_cache_clear();
         res = f_unlink(&self->fatfs, path);
 
         if (res != FR_OK) {
@@ -237,6 +239,7 @@ STATIC mp_obj_t fat_vfs_rename(mp_obj_t vfs_in, mp_obj_t path_in, mp_obj_t path_
     mp_obj_fat_vfs_t *self = MP_OBJ_TO_PTR(vfs_in);
     const char *old_path = mp_obj_str_get_str(path_in);
     const char *new_path = mp_obj_str_get_str(path_out);
+    mp_vfs_import_stat_cache_clear();
     FRESULT res = f_rename(&self->fatfs, old_path, new_path);
     if (res == FR_EXIST) {
         // if new_path exists then try removing it (but only if it's a file)
@@ -256,6 +259,7 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_3(fat_vfs_rename_obj, fat_vfs_rename);
 STATIC mp_obj_t fat_vfs_mkdir(mp_obj_t vfs_in, mp_obj_t path_o) {
     mp_obj_fat_vfs_t *self = MP_OBJ_TO_PTR(vfs_in);
     const char *path = mp_obj_str_get_str(path_o);
+    mp_vfs_import_stat_cache_clear();
     FRESULT res = f_mkdir(&self->fatfs, path);
     if (res == FR_OK) {
         return mp_const_none;
@@ -271,6 +275,8 @@ STATIC mp_obj_t fat_vfs_chdir(mp_obj_t vfs_in, mp_obj_t path_in) {
     const char *path;
     path = mp_obj_str_get_str(path_in);
 
+    // relative paths cached by import now refer to another directory
+    mp_vfs_import_stat_cache_clear();
     FRESULT res = f_chdir(&self->fatfs, path);
 
     if (res != FR_OK) {
@@ -58,6 +58,10 @@ typedef struct _fs_user_mount_t {
 typedef struct _pyb_file_obj_t {
     mp_obj_base_t base;
     FIL fp;
+    #if _USE_FASTSEEK
+    // Set once building a cluster link map has failed so we don't retry.
+    bool no_link_map;
+    #endif
 } pyb_file_obj_t;
 
 extern const byte fresult_to_errno_table[20];
@@ -66,6 +70,7 @@ extern const mp_obj_type_t mp_type_vfs_fat_fileio;
 extern const mp_obj_type_t mp_type_vfs_fat_textio;
 
 mp_import_stat_t fat_vfs_import_stat(void *vfs, const char *path);
+FRESULT fat_file_seek(pyb_file_obj_t *self, FSIZE_t offset);
 
 MP_DECLARE_CONST_FUN_OBJ_3(fat_vfs_open_obj);
 
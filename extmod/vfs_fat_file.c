@@ -98,6 +98,64 @@ STATIC mp_obj_t file_obj___exit__(size_t n_args, const mp_obj_t *args) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(file_obj___exit___obj, 4, 4, file_obj___exit__);
 
+#if _USE_FASTSEEK
+// Largest number of fragments a file may have for us to map its clusters.
+#ifndef MICROPY_FATFS_MAX_LINK_MAP_FRAGMENTS
+#define MICROPY_FATFS_MAX_LINK_MAP_FRAGMENTS (32)
+#endif
+
+// Build a map of the file's cluster chain so that FatFs can seek without
+// following the chain. Only done for files that can't grow, because FatFs
+// can't extend a mapped file.
+STATIC void file_obj_create_link_map(pyb_file_obj_t *self) {
+    // Find out how big the map needs to be.
+    DWORD probe[4] = {MP_ARRAY_SIZE(probe)};
+    self->fp.cltbl = probe;
+    FRESULT res = f_lseek(&self->fp, CREATE_LINKMAP);
+    self->fp.cltbl = NULL;
+    size_t len = probe[0];
+    if ((res != FR_OK && res != FR_NOT_ENOUGH_CORE) ||
+        len > 2 + 2 * MICROPY_FATFS_MAX_LINK_MAP_FRAGMENTS) {
+        self->no_link_map = true;
+        return;
+    }
+    DWORD *map = m_new_maybe(DWORD, len);
+    if (map == NULL) {
+        self->no_link_map = true;
+        return;
+    }
+    map[0] = len;
+    self->fp.cltbl = map;
+    if (f_lseek(&self->fp, CREATE_LINKMAP) != FR_OK) {
+        self->fp.cltbl = NULL;
+        m_del(DWORD, map, len);
+        self->no_link_map = true;
+    }
+}
+#endif
+
+// Seek within the file. A seek that has to follow more than one link of the
+// FAT chain makes read-only files switch to using a cluster link map.
+FRESULT fat_file_seek(pyb_file_obj_t *self, FSIZE_t offset) {
+    #if _USE_FASTSEEK
+    FIL *fp = &self->fp;
+    if (fp->cltbl == NULL && !self->no_link_map && (fp->flag & FA_WRITE) == 0 && offset > 0) {
+        #if _MAX_SS == _MIN_SS
+        FSIZE_t cluster_size = (FSIZE_t)fp->obj.fs->csize * _MAX_SS;
+        #else
+        FSIZE_t cluster_size = (FSIZE_t)fp->obj.fs->csize * fp->obj.fs->ssize;
+        #endif
+        FSIZE_t target = (offset - 1) / cluster_size;
+        FSIZE_t current = fp->fptr > 0 ? (fp->fptr - 1) / cluster_size : 0;
+        FSIZE_t links = target >= current && fp->fptr > 0 ? target - current : target;
+        if (links > 1) {
+            file_obj_create_link_map(self);
+        }
+    }
+    #endif
+    return f_lseek(&self->fp, offset);
+}
+
 STATIC mp_uint_t file_obj_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg, int *errcode) {
     pyb_file_obj_t *self = MP_OBJ_TO_PTR(o_in);
 
@@ -106,15 +164,15 @@ STATIC mp_uint_t file_obj_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg,
 
         switch (s->whence) {
             case 0: // SEEK_SET
-                f_lseek(&self->fp, s->offset);
+                fat_file_seek(self, s->offset);
                 break;
 
             case 1: // SEEK_CUR
-                f_lseek(&self->fp, f_tell(&self->fp) + s->offset);
+                fat_file_seek(self, f_tell(&self->fp) + s->offset);
                 break;
 
             case 2: // SEEK_END
-                f_lseek(&self->fp, f_size(&self->fp) + s->offset);
+                fat_file_seek(self, f_size(&self->fp) + s->offset);
                 break;
         }
 
@@ -132,6 +190,12 @@ STATIC mp_uint_t file_obj_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg,
     } else if (request == MP_STREAM_CLOSE) {
         // if fs==NULL then the file is closed and in that case this method is a no-op
         if (self->fp.obj.fs != NULL) {
+            #if _USE_FASTSEEK
+            if (self->fp.cltbl != NULL) {
+                m_del(DWORD, self->fp.cltbl, self->fp.cltbl[0]);
+                self->fp.cltbl = NULL;
+            }
+            #endif
             FRESULT res = f_close(&self->fp);
             if (res != FR_OK) {
                 *errcode = fresult_to_errno_table[res];
@@ -189,9 +253,15 @@ STATIC mp_obj_t file_open(fs_user_mount_t *vfs, const mp_obj_type_t *type, mp_ar
 
     pyb_file_obj_t *o = m_new_obj_with_finaliser(pyb_file_obj_t);
     o->base.type = type;
+    #if _USE_FASTSEEK
+    o->no_link_map = false;
+    #endif
 
     const char *fname = mp_obj_str_get_str(args[0].u_obj);
     assert(vfs != NULL);
+    if ((mode & (FA_CREATE_ALWAYS | FA_CREATE_NEW | FA_OPEN_ALWAYS)) != 0) {
+        mp_vfs_import_stat_cache_clear();
+    }
     FRESULT res = f_open(&vfs->fatfs, &o->fp, fname, mode);
     if (res != FR_OK) {
         m_del_obj(pyb_file_obj_t, o);
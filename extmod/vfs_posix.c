@@ -65,6 +65,8 @@ STATIC mp_obj_t vfs_posix_get_path_obj(mp_obj_vfs_posix_t *self, mp_obj_t path)
 
 STATIC mp_obj_t vfs_posix_fun1_helper(mp_obj_t self_in, mp_obj_t path_in, int (*f)(const char*)) {
     mp_obj_vfs_posix_t *self = MP_OBJ_TO_PTR(self_in);
+    // all users change what import would find
+    mp_vfs_import_stat_cache_clear();
     int ret = f(vfs_posix_get_path_str(self, path_in));
     if (ret != 0) {
         mp_raise_OSError(errno);
@@ -237,6 +239,7 @@ typedef struct _mp_obj_listdir_t {
 
 STATIC mp_obj_t vfs_posix_mkdir(mp_obj_t self_in, mp_obj_t path_in) {
     mp_obj_vfs_posix_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_vfs_import_stat_cache_clear();
     int ret = mkdir(vfs_posix_get_path_str(self, path_in), 0777);
     if (ret != 0) {
         mp_raise_OSError(errno);
@@ -254,6 +257,7 @@ STATIC mp_obj_t vfs_posix_rename(mp_obj_t self_in, mp_obj_t old_path_in, mp_obj_
     mp_obj_vfs_posix_t *self = MP_OBJ_TO_PTR(self_in);
     const char *old_path = vfs_posix_get_path_str(self, old_path_in);
     const char *new_path = vfs_posix_get_path_str(self, new_path_in);
+    mp_vfs_import_stat_cache_clear();
     int ret = rename(old_path, new_path);
     if (ret != 0) {
         mp_raise_OSError(errno);
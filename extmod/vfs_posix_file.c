@@ -26,6 +26,7 @@
 
 #include "py/runtime.h"
 #include "py/stream.h"
+#include "extmod/vfs.h"
 #include "extmod/vfs_posix.h"
 #include "supervisor/shared/translate.h"
 
@@ -101,6 +102,9 @@ mp_obj_t mp_vfs_posix_file_open(const mp_obj_type_t *type, mp_obj_t file_in, mp_
     }
 
     const char *fname = mp_obj_str_get_str(fid);
+    if (mode_x & O_CREAT) {
+        mp_vfs_import_stat_cache_clear();
+    }
     int fd = open(fname, mode_x | mode_rw, 0644);
     if (fd == -1) {
         mp_raise_OSError(errno);
@@ -190,6 +194,9 @@ STATIC mp_uint_t vfs_posix_file_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_
             return 0;
         }
         case MP_STREAM_CLOSE:
+            #ifdef MICROPY_HOOK_FD_CLOSING
+            MICROPY_HOOK_FD_CLOSING(o->fd);
+            #endif
             close(o->fd);
             #ifdef MICROPY_CPYTHON_COMPAT
             o->fd = -1;
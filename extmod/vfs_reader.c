@@ -82,6 +82,7 @@ void mp_reader_new_file(mp_reader_t *reader, const char *filename) {
     reader->data = rf;
     reader->readbyte = mp_reader_vfs_readbyte;
     reader->close = mp_reader_vfs_close;
+    reader->readptr = NULL;
 }
 
 #endif // MICROPY_READER_VFS
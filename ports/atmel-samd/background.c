@@ -37,6 +37,10 @@
 #include "shared-module/displayio/__init__.h"
 #endif
 
+#ifdef EXTERNAL_FLASH_DEVICES
+#include "supervisor/shared/external_flash/external_flash.h"
+#endif
+
 volatile uint64_t last_finished_tick = 0;
 
 bool stack_ok_so_far = true;
@@ -53,6 +57,10 @@ void run_background_tasks(void) {
     #if MICROPY_PY_NETWORK
     network_module_background();
     #endif
+
+    #ifdef EXTERNAL_FLASH_DEVICES
+    external_flash_background();
+    #endif
     usb_background();
     assert_heap_ok();
 
@@ -35,3 +35,7 @@ bool common_hal_get_serial_connected(void) {
 bool common_hal_get_serial_bytes_available(void) {
     return (bool) serial_bytes_available();
 }
+
+uint32_t common_hal_get_serial_bytes_dropped(void) {
+    return serial_write_dropped();
+}
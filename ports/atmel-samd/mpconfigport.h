@@ -155,6 +155,10 @@ typedef long mp_off_t;
 #define PORT_HEAP_SIZE                              (16384 + 4096)
 #define SPI_FLASH_MAX_BAUDRATE 8000000
 #define CIRCUITPY_DEFAULT_STACK_SIZE                4096
+#define CIRCUITPY_TRANSLATE_FAST_LOOKUP             (0)
+#define CIRCUITPY_TRANSLATE_CACHE_ENTRIES           (0)
+#define CIRCUITPY_SERIAL_TX_BUFFER_SIZE             (256)
+#define CIRCUITPY_MSC_BUFFER_BLOCKS                 (0)
 #define MICROPY_CPYTHON_COMPAT                      (0)
 #define MICROPY_MODULE_WEAK_LINKS                   (0)
 #define MICROPY_PY_BUILTINS_NOTIMPLEMENTED          (0)
@@ -191,6 +195,11 @@ typedef long mp_off_t;
 #define MICROPY_PY_IO                               (1)
 #define MICROPY_PY_REVERSE_SPECIAL_METHODS          (1)
 #define MICROPY_PY_SYS_EXC_INFO                     (1)
+#define MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE (1)
+#define MICROPY_FATFS_USE_FASTSEEK                  (1)
+#define MICROPY_VFS_IMPORT_STAT_CACHE               (1)
+#define MICROPY_OPT_VM_BINARY_OP_FAST_PATH          (1)
+#define MICROPY_OSERROR_POOL_SIZE                   (4)
 //      MICROPY_PY_UERRNO_LIST - Use the default
 #endif
 
@@ -255,6 +264,10 @@ extern const struct _mp_obj_module_t pixelbuf_module;
     #define MICROPY_PY_UERRNO (1)
     #define MICROPY_PY_UERRNO_ERRORCODE (0)
     #define MICROPY_PY_URE (1)
+    #define MICROPY_PY_URE_PIKEVM (1)
+    #define MICROPY_PY_URE_MATCH_SPAN_START_END (1)
+    #define MICROPY_PY_URE_FINDITER (1)
+    #define MICROPY_PY_URE_SUB (1)
     #define MICROPY_PY_MICROPYTHON_MEM_INFO (1)
     #ifndef MICROPY_PY_FRAMEBUF
       #define MICROPY_PY_FRAMEBUF         (0)
@@ -311,6 +324,8 @@ extern const struct _mp_obj_module_t pixelbuf_module;
     #if MICROPY_PY_IO
         #define JSON_MODULE { MP_ROM_QSTR(MP_QSTR_json), MP_ROM_PTR(&mp_module_ujson) },
         #define MICROPY_PY_UJSON                         (1)
+        #define MICROPY_PY_UJSON_ITERLOAD                (1)
+        #define MICROPY_PY_UJSON_DUMPS_INTO              (1)
     #else
         #define JSON_MODULE
     #endif
@@ -32,6 +32,10 @@
 #include "shared-module/displayio/__init__.h"
 #endif
 
+#ifdef EXTERNAL_FLASH_DEVICES
+#include "supervisor/shared/external_flash/external_flash.h"
+#endif
+
 void run_background_tasks(void) {
     usb_background();
 
@@ -39,5 +43,9 @@ void run_background_tasks(void) {
     displayio_refresh_displays();
     #endif
 
+    #ifdef EXTERNAL_FLASH_DEVICES
+    external_flash_background();
+    #endif
+
     assert_heap_ok();
 }
@@ -36,3 +36,6 @@ bool common_hal_get_serial_bytes_available(void) {
   return (bool) serial_bytes_available();
 }
 
+uint32_t common_hal_get_serial_bytes_dropped(void) {
+  return serial_write_dropped();
+}
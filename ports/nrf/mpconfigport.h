@@ -50,6 +50,7 @@
 #define MICROPY_FLOAT_HIGH_QUALITY_HASH          (1)
 
 #define MICROPY_OPT_COMPUTED_GOTO                (0)
+#define MICROPY_OPT_VM_BINARY_OP_FAST_PATH       (1)
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE (0)
 #define MICROPY_OPT_MPZ_BITWISE                  (0)
 
@@ -60,11 +61,13 @@
 #define MICROPY_FATFS_RPATH                      (2)
 #define MICROPY_FATFS_MULTI_PARTITION            (1)
 #define MICROPY_FATFS_NUM_PERSISTENT             (1)
+#define MICROPY_FATFS_USE_FASTSEEK               (1)
 
 //#define MICROPY_FATFS_MAX_SS                   (4096)
 #define FILESYSTEM_BLOCK_SIZE                    (512)
 
 #define MICROPY_VFS                              (1)
+#define MICROPY_VFS_IMPORT_STAT_CACHE            (1)
 #define MICROPY_VFS_FAT                          (MICROPY_VFS)
 
 // use vfs's functions for import stat and builtin open
@@ -81,6 +84,7 @@
 #define MICROPY_USE_INTERNAL_ERRNO               (0)
 #define MICROPY_PY_FUNCTION_ATTRS                (1)
 #define MICROPY_PY_BUILTINS_STR_UNICODE          (1)
+#define MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE (1)
 #define MICROPY_PY_BUILTINS_STR_CENTER           (1)
 #define MICROPY_PY_BUILTINS_STR_PARTITION        (1)
 #define MICROPY_PY_BUILTINS_STR_SPLITLINES       (1)
@@ -113,6 +117,8 @@
 #define MICROPY_PY_UCTYPES                       (0)
 #define MICROPY_PY_UZLIB                         (0)
 #define MICROPY_PY_UJSON                         (1)
+#define MICROPY_PY_UJSON_ITERLOAD                (1)
+#define MICROPY_PY_UJSON_DUMPS_INTO              (1)
 #define MICROPY_PY_URE                           (0)
 #define MICROPY_PY_UHEAPQ                        (0)
 #define MICROPY_PY_UHASHLIB                      (1)
@@ -123,6 +129,7 @@
 
 #define MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF   (1)
 #define MICROPY_EMERGENCY_EXCEPTION_BUF_SIZE     (0)
+#define MICROPY_OSERROR_POOL_SIZE                (4)
 
 // Scan gamepad every 32ms
 #define CIRCUITPY_GAMEPAD_TICKS 0x1f
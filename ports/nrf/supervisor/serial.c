@@ -54,6 +54,10 @@ bool serial_bytes_available(void) {
     return ble_uart_stdin_any();
 }
 
+uint32_t serial_write_dropped(void) {
+    return 0;
+}
+
 void serial_write(const char *text) {
     ble_uart_stdout_tx_str(text);
 }
@@ -101,6 +105,10 @@ bool serial_bytes_available(void) {
     return nrf_uarte_event_check(serial_instance.p_reg, NRF_UARTE_EVENT_RXDRDY);
 }
 
+uint32_t serial_write_dropped(void) {
+    return 0;
+}
+
 void serial_write(const char* text) {
     serial_write_substring(text, strlen(text));
 }
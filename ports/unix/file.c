@@ -120,6 +120,9 @@ STATIC mp_uint_t fdfile_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg, i
             }
             return 0;
         case MP_STREAM_CLOSE:
+            #ifdef MICROPY_HOOK_FD_CLOSING
+            MICROPY_HOOK_FD_CLOSING(o->fd);
+            #endif
             close(o->fd);
             #ifdef MICROPY_CPYTHON_COMPAT
             o->fd = -1;
@@ -32,6 +32,15 @@
 #include <stdio.h>
 #include <errno.h>
 #include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#if MICROPY_PY_USELECT_EPOLL
+#include <stdlib.h>
+#include <sys/epoll.h>
+#if MICROPY_PY_THREAD
+#include <pthread.h>
+#endif
+#endif
 
 #include "py/runtime.h"
 #include "py/obj.h"
@@ -51,6 +60,54 @@ extern const mp_obj_type_t mp_type_socket;
 
 /// \class Poll - poll class
 
+#if MICROPY_PY_USELECT_EPOLL
+
+// fds are registered with an epoll instance once, and epoll_wait returns
+// just the ready ones.  Per-fd state is kept in arrays indexed by fd.  Fds of
+// regular files can't be added to epoll; poll() always reports them ready
+// for reading and writing, so they're kept aside and reported directly.
+// Closed fds are kept aside too and reported as POLLNVAL, as poll() does.
+// epoll drops an fd silently when it's closed, so the port tells every poll
+// object about each fd it closes.
+
+#define FD_REGISTERED (0x80000000)
+#define FD_NOT_EPOLL (0x40000000)
+#define FD_NVAL (0x20000000)
+#define FD_EVENTS (0x0000ffff)
+
+typedef struct _mp_obj_poll_t {
+    mp_obj_base_t base;
+    int epfd;
+    int len; // number of registered fds
+    int num_not_epoll; // number of those which aren't in the epoll set
+    int fd_alloc;
+    uint32_t *fd_flags; // FD_* flags and requested events for each fd
+    mp_obj_t *fd_obj; // object registered for each fd, or MP_OBJ_NULL
+    int ready_alloc;
+    int ready_len;
+    struct epoll_event *ready;
+    int iter_idx;
+    int flags;
+    // callee-owned tuple
+    mp_obj_t ret_tuple;
+} mp_obj_poll_t;
+
+// The live poll objects.  The array is outside the GC heap so that it doesn't
+// keep them alive; each one is taken out when it's finalised.
+STATIC mp_obj_poll_t **poll_list;
+STATIC size_t poll_list_len;
+STATIC size_t poll_list_alloc;
+#if MICROPY_PY_THREAD
+STATIC pthread_mutex_t poll_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define POLL_LIST_LOCK() pthread_mutex_lock(&poll_list_mutex)
+#define POLL_LIST_UNLOCK() pthread_mutex_unlock(&poll_list_mutex)
+#else
+#define POLL_LIST_LOCK()
+#define POLL_LIST_UNLOCK()
+#endif
+
+#else
+
 typedef struct _mp_obj_poll_t {
     mp_obj_base_t base;
     unsigned short alloc;
@@ -64,6 +121,8 @@ typedef struct _mp_obj_poll_t {
     mp_obj_t ret_tuple;
 } mp_obj_poll_t;
 
+#endif
+
 STATIC int get_fd(mp_obj_t fdlike) {
     int fd;
     // Shortcut for fdfile compatible types
@@ -80,6 +139,328 @@ STATIC int get_fd(mp_obj_t fdlike) {
     return fd;
 }
 
+#if MICROPY_PY_USELECT_EPOLL
+
+STATIC int poll_ctl(mp_obj_poll_t *self, int op, int fd, uint32_t events) {
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.fd = fd;
+    return epoll_ctl(self->epfd, op, fd, &ev);
+}
+
+// Put a registered fd in the epoll set with the given events, or update its
+// events there.  Fds which epoll refuses are kept aside: regular files, and
+// closed fds.  Returns -1 with errno set on other errors.
+STATIC int poll_update(mp_obj_poll_t *self, int fd, uint32_t events) {
+    uint32_t *fd_flags = &self->fd_flags[fd];
+    bool is_new = !(*fd_flags & FD_REGISTERED);
+    bool was_aside = *fd_flags & (FD_NOT_EPOLL | FD_NVAL);
+    int res = -1;
+    errno = ENOENT;
+    if (!is_new && !was_aside) {
+        res = poll_ctl(self, EPOLL_CTL_MOD, fd, events);
+    }
+    if (res == -1 && errno == ENOENT) {
+        // not in the set, or a registered fd was closed and its number reused
+        res = poll_ctl(self, EPOLL_CTL_ADD, fd, events);
+        if (res == -1 && errno == EEXIST) {
+            // still in the set through a dup of an unregistered fd
+            res = poll_ctl(self, EPOLL_CTL_MOD, fd, events);
+        }
+    }
+    uint32_t aside = 0;
+    if (res == -1) {
+        if (errno == EPERM) {
+            aside = FD_NOT_EPOLL;
+        } else if (errno == EBADF) {
+            aside = FD_NVAL;
+        } else {
+            return -1;
+        }
+    }
+    if (!is_new && was_aside) {
+        self->num_not_epoll--;
+    }
+    if (aside) {
+        self->num_not_epoll++;
+    }
+    *fd_flags = FD_REGISTERED | aside | events;
+    return 0;
+}
+
+/// \method register(obj[, eventmask])
+STATIC mp_obj_t poll_register(size_t n_args, const mp_obj_t *args) {
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(args[0]);
+    bool is_fd = MP_OBJ_IS_INT(args[1]);
+    int fd = get_fd(args[1]);
+
+    mp_uint_t flags;
+    if (n_args == 3) {
+        flags = mp_obj_get_int(args[2]);
+    } else {
+        flags = POLLIN | POLLOUT;
+    }
+    flags &= FD_EVENTS;
+
+    if (fd < 0) {
+        mp_raise_OSError(EBADF);
+    }
+    if (fd >= self->fd_alloc) {
+        int alloc = (MAX(fd + 1, self->fd_alloc * 2) + 15) & ~15;
+        self->fd_flags = m_renew(uint32_t, self->fd_flags, self->fd_alloc, alloc);
+        self->fd_obj = m_renew(mp_obj_t, self->fd_obj, self->fd_alloc, alloc);
+        memset(self->fd_flags + self->fd_alloc, 0, (alloc - self->fd_alloc) * sizeof(uint32_t));
+        memset(self->fd_obj + self->fd_alloc, 0, (alloc - self->fd_alloc) * sizeof(mp_obj_t));
+        self->fd_alloc = alloc;
+    }
+
+    bool is_new = !(self->fd_flags[fd] & FD_REGISTERED);
+    int res = poll_update(self, fd, flags);
+    RAISE_ERRNO(res, errno);
+    self->fd_obj[fd] = is_fd ? MP_OBJ_NULL : args[1];
+    if (!is_new) {
+        return mp_const_false;
+    }
+
+    // there must be room to return every registered fd, plus one so that
+    // epoll_wait always has space
+    if (++self->len >= self->ready_alloc) {
+        int alloc = self->len + self->len / 2 + 4;
+        self->ready = m_renew(struct epoll_event, self->ready, self->ready_alloc, alloc);
+        self->ready_alloc = alloc;
+    }
+    return mp_const_true;
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_register_obj, 2, 3, poll_register);
+
+/// \method unregister(obj)
+STATIC mp_obj_t poll_unregister(mp_obj_t self_in, mp_obj_t obj_in) {
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(self_in);
+    int fd = get_fd(obj_in);
+    if (fd >= 0 && fd < self->fd_alloc && (self->fd_flags[fd] & FD_REGISTERED)) {
+        if (self->fd_flags[fd] & (FD_NOT_EPOLL | FD_NVAL)) {
+            self->num_not_epoll--;
+        } else {
+            // the fd may already be closed, which removed it from the set
+            poll_ctl(self, EPOLL_CTL_DEL, fd, 0);
+        }
+        self->fd_flags[fd] = 0;
+        self->fd_obj[fd] = MP_OBJ_NULL;
+        self->len--;
+    }
+
+    // TODO raise KeyError if obj didn't exist in map
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_2(poll_unregister_obj, poll_unregister);
+
+STATIC int poll_set_events(mp_obj_poll_t *self, int fd, uint32_t events) {
+    uint32_t *fd_flags = &self->fd_flags[fd];
+    if (*fd_flags & (FD_NOT_EPOLL | FD_NVAL)) {
+        *fd_flags = (*fd_flags & ~FD_EVENTS) | events;
+        return 0;
+    }
+    return poll_update(self, fd, events);
+}
+
+/// \method modify(obj, eventmask)
+STATIC mp_obj_t poll_modify(mp_obj_t self_in, mp_obj_t obj_in, mp_obj_t eventmask_in) {
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(self_in);
+    int fd = get_fd(obj_in);
+    if (fd >= 0 && fd < self->fd_alloc && (self->fd_flags[fd] & FD_REGISTERED)) {
+        int res = poll_set_events(self, fd, mp_obj_get_int(eventmask_in) & FD_EVENTS);
+        RAISE_ERRNO(res, errno);
+    }
+
+    // TODO raise KeyError if obj didn't exist in map
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_3(poll_modify_obj, poll_modify);
+
+STATIC int poll_poll_internal(size_t n_args, const mp_obj_t *args) {
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    // work out timeout (it's given already in ms)
+    int timeout = -1;
+    int flags = 0;
+    if (n_args >= 2) {
+        if (args[1] != mp_const_none) {
+            mp_int_t timeout_i = mp_obj_get_int(args[1]);
+            if (timeout_i >= 0) {
+                timeout = timeout_i;
+            }
+        }
+        if (n_args >= 3) {
+            flags = mp_obj_get_int(args[2]);
+        }
+    }
+
+    self->flags = flags;
+
+    // A closed fd's number may be reused, so closed ones are retried on
+    // every poll.  Regular files and closed fds are always ready, so don't
+    // wait if one is polled for.
+    int n_not_epoll = 0;
+    if (self->num_not_epoll > 0) {
+        for (int fd = 0; fd < self->fd_alloc; fd++) {
+            uint32_t fd_flags = self->fd_flags[fd];
+            if (fd_flags & FD_NVAL) {
+                int res = poll_update(self, fd, fd_flags & FD_EVENTS);
+                RAISE_ERRNO(res, errno);
+                fd_flags = self->fd_flags[fd];
+            }
+            if ((fd_flags & FD_NVAL) || ((fd_flags & FD_NOT_EPOLL) && (fd_flags & (POLLIN | POLLOUT)))) {
+                n_not_epoll++;
+            }
+        }
+    }
+
+    int n_ready = epoll_wait(self->epfd, self->ready, self->ready_alloc - self->num_not_epoll,
+        n_not_epoll > 0 ? 0 : timeout);
+    RAISE_ERRNO(n_ready, errno);
+
+    if (n_not_epoll > 0) {
+        // drop events for fds kept aside, which stay in the set when a closed
+        // fd has a dup
+        int n = 0;
+        for (int i = 0; i < n_ready; i++) {
+            if (!(self->fd_flags[self->ready[i].data.fd] & (FD_NOT_EPOLL | FD_NVAL))) {
+                self->ready[n++] = self->ready[i];
+            }
+        }
+        n_ready = n;
+        for (int fd = 0; fd < self->fd_alloc; fd++) {
+            uint32_t fd_flags = self->fd_flags[fd];
+            uint32_t events = 0;
+            if (fd_flags & FD_NVAL) {
+                events = POLLNVAL;
+            } else if (fd_flags & FD_NOT_EPOLL) {
+                events = fd_flags & (POLLIN | POLLOUT);
+            }
+            if (events) {
+                self->ready[n_ready].events = events;
+                self->ready[n_ready++].data.fd = fd;
+            }
+        }
+    }
+    self->ready_len = n_ready;
+    return n_ready;
+}
+
+// Fill in the tuple for the i'th ready fd.
+STATIC void poll_ready_entry(mp_obj_poll_t *self, int i, mp_obj_tuple_t *t) {
+    int fd = self->ready[i].data.fd;
+    // If there's an object stored, return it, otherwise raw fd
+    if (self->fd_obj[fd] != MP_OBJ_NULL) {
+        t->items[0] = self->fd_obj[fd];
+    } else {
+        t->items[0] = MP_OBJ_NEW_SMALL_INT(fd);
+    }
+    t->items[1] = MP_OBJ_NEW_SMALL_INT(self->ready[i].events);
+    if (self->flags & FLAG_ONESHOT) {
+        // a closed fd is kept aside instead of failing here
+        poll_set_events(self, fd, 0);
+    }
+}
+
+/// \method poll([timeout])
+/// Timeout is in milliseconds.
+STATIC mp_obj_t poll_poll(size_t n_args, const mp_obj_t *args) {
+    int n_ready = poll_poll_internal(n_args, args);
+
+    if (n_ready == 0) {
+        return mp_const_empty_tuple;
+    }
+
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    mp_obj_list_t *ret_list = MP_OBJ_TO_PTR(mp_obj_new_list(n_ready, NULL));
+    for (int i = 0; i < n_ready; i++) {
+        mp_obj_tuple_t *t = MP_OBJ_TO_PTR(mp_obj_new_tuple(2, NULL));
+        poll_ready_entry(self, i, t);
+        ret_list->items[i] = MP_OBJ_FROM_PTR(t);
+    }
+
+    return MP_OBJ_FROM_PTR(ret_list);
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_poll_obj, 1, 3, poll_poll);
+
+STATIC mp_obj_t poll_ipoll(size_t n_args, const mp_obj_t *args) {
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(args[0]);
+
+    if (self->ret_tuple == MP_OBJ_NULL) {
+        self->ret_tuple = mp_obj_new_tuple(2, NULL);
+    }
+
+    poll_poll_internal(n_args, args);
+    self->iter_idx = 0;
+
+    return args[0];
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_ipoll_obj, 1, 3, poll_ipoll);
+
+STATIC mp_obj_t poll_iternext(mp_obj_t self_in) {
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(self_in);
+
+    if (self->iter_idx >= self->ready_len) {
+        return MP_OBJ_STOP_ITERATION;
+    }
+
+    // the ready entries are returned in place, with no allocation
+    mp_obj_tuple_t *t = MP_OBJ_TO_PTR(self->ret_tuple);
+    poll_ready_entry(self, self->iter_idx++, t);
+    return MP_OBJ_FROM_PTR(t);
+}
+
+STATIC mp_obj_t poll_del(mp_obj_t self_in) {
+    mp_obj_poll_t *self = MP_OBJ_TO_PTR(self_in);
+    if (self->epfd != -1) {
+        POLL_LIST_LOCK();
+        for (size_t i = 0; i < poll_list_len; i++) {
+            if (poll_list[i] == self) {
+                poll_list[i] = poll_list[--poll_list_len];
+                break;
+            }
+        }
+        POLL_LIST_UNLOCK();
+        close(self->epfd);
+        self->epfd = -1;
+    }
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_1(poll_del_obj, poll_del);
+
+// Called by the port just before it closes an fd.  The fd is taken out of
+// the epoll set of each poll object it's registered with and kept aside as
+// closed, so only poll objects that have the fd do any work.
+void mp_unix_fd_closing(int fd) {
+    if (fd < 0) {
+        return;
+    }
+    POLL_LIST_LOCK();
+    for (size_t i = 0; i < poll_list_len; i++) {
+        mp_obj_poll_t *self = poll_list[i];
+        if (fd >= self->fd_alloc) {
+            continue;
+        }
+        uint32_t *fd_flags = &self->fd_flags[fd];
+        if (!(*fd_flags & FD_REGISTERED) || (*fd_flags & FD_NVAL)) {
+            continue;
+        }
+        if (*fd_flags & FD_NOT_EPOLL) {
+            *fd_flags &= ~FD_NOT_EPOLL;
+        } else {
+            // remove it now, as a dup of the fd would keep it in the set
+            poll_ctl(self, EPOLL_CTL_DEL, fd, 0);
+            self->num_not_epoll++;
+        }
+        *fd_flags |= FD_NVAL;
+    }
+    POLL_LIST_UNLOCK();
+}
+
+#else
+
 /// \method register(obj[, eventmask])
 STATIC mp_obj_t poll_register(size_t n_args, const mp_obj_t *args) {
     mp_obj_poll_t *self = MP_OBJ_TO_PTR(args[0]);
@@ -298,13 +679,18 @@ STATIC mp_obj_t poll_dump(mp_obj_t self_in) {
 MP_DEFINE_CONST_FUN_OBJ_1(poll_dump_obj, poll_dump);
 #endif
 
+#endif // MICROPY_PY_USELECT_EPOLL
+
 STATIC const mp_rom_map_elem_t poll_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_register), MP_ROM_PTR(&poll_register_obj) },
     { MP_ROM_QSTR(MP_QSTR_unregister), MP_ROM_PTR(&poll_unregister_obj) },
     { MP_ROM_QSTR(MP_QSTR_modify), MP_ROM_PTR(&poll_modify_obj) },
     { MP_ROM_QSTR(MP_QSTR_poll), MP_ROM_PTR(&poll_poll_obj) },
     { MP_ROM_QSTR(MP_QSTR_ipoll), MP_ROM_PTR(&poll_ipoll_obj) },
-    #if DEBUG
+    #if MICROPY_PY_USELECT_EPOLL
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&poll_del_obj) },
+    #endif
+    #if DEBUG && !MICROPY_PY_USELECT_EPOLL
     { MP_ROM_QSTR(MP_QSTR_dump), MP_ROM_PTR(&poll_dump_obj) },
     #endif
 };
@@ -323,6 +709,38 @@ STATIC mp_obj_t select_poll(size_t n_args, const mp_obj_t *args) {
     if (n_args > 0) {
         alloc = mp_obj_get_int(args[0]);
     }
+    #if MICROPY_PY_USELECT_EPOLL
+    // allocate first, so that the epoll fd can't leak if that fails
+    struct epoll_event *ready = m_new(struct epoll_event, alloc + 1);
+    mp_obj_poll_t *poll = m_new_obj_with_finaliser(mp_obj_poll_t);
+    poll->base.type = &mp_type_poll;
+    poll->len = 0;
+    poll->num_not_epoll = 0;
+    poll->fd_alloc = 0;
+    poll->fd_flags = NULL;
+    poll->fd_obj = NULL;
+    poll->ready = ready;
+    poll->ready_alloc = alloc + 1;
+    poll->ready_len = 0;
+    poll->iter_idx = 0;
+    poll->epfd = epoll_create1(EPOLL_CLOEXEC);
+    RAISE_ERRNO(poll->epfd, errno);
+    POLL_LIST_LOCK();
+    if (poll_list_len == poll_list_alloc) {
+        size_t list_alloc = poll_list_alloc * 2 + 4;
+        mp_obj_poll_t **list = realloc(poll_list, list_alloc * sizeof(*list));
+        if (list == NULL) {
+            POLL_LIST_UNLOCK();
+            close(poll->epfd);
+            poll->epfd = -1;
+            m_malloc_fail(list_alloc * sizeof(*list));
+        }
+        poll_list = list;
+        poll_list_alloc = list_alloc;
+    }
+    poll_list[poll_list_len++] = poll;
+    POLL_LIST_UNLOCK();
+    #else
     mp_obj_poll_t *poll = m_new_obj(mp_obj_poll_t);
     poll->base.type = &mp_type_poll;
     poll->entries = m_new(struct pollfd, alloc);
@@ -330,6 +748,7 @@ STATIC mp_obj_t select_poll(size_t n_args, const mp_obj_t *args) {
     poll->len = 0;
     poll->obj_map = NULL;
     poll->iter_cnt = 0;
+    #endif
     poll->ret_tuple = MP_OBJ_NULL;
     return MP_OBJ_FROM_PTR(poll);
 }
@@ -122,6 +122,9 @@ STATIC mp_uint_t socket_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg, i
             // The rationale MicroPython follows is that close() just releases
             // file descriptor. If you're interested to catch I/O errors before
             // closing fd, fsync() it.
+            #ifdef MICROPY_HOOK_FD_CLOSING
+            MICROPY_HOOK_FD_CLOSING(self->fd);
+            #endif
             close(self->fd);
             return 0;
 
@@ -28,6 +28,7 @@
 
 #define MICROPY_ALLOC_PATH_MAX      (PATH_MAX)
 #define MICROPY_PERSISTENT_CODE_LOAD (1)
+#define MICROPY_PERSISTENT_CODE_LOAD_XIP (1)
 #if !defined(MICROPY_EMIT_X64) && defined(__x86_64__)
     #define MICROPY_EMIT_X64        (1)
 #endif
@@ -67,6 +68,7 @@
 #define MICROPY_STREAMS_NON_BLOCK   (1)
 #define MICROPY_STREAMS_POSIX_API   (1)
 #define MICROPY_OPT_COMPUTED_GOTO   (1)
+#define MICROPY_OPT_VM_BINARY_OP_FAST_PATH (1)
 #ifndef MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE (1)
 #endif
@@ -74,6 +76,7 @@
 #define MICROPY_PY_FUNCTION_ATTRS   (1)
 #define MICROPY_PY_DESCRIPTORS      (1)
 #define MICROPY_PY_BUILTINS_STR_UNICODE (1)
+#define MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE (1)
 #define MICROPY_PY_BUILTINS_STR_CENTER (1)
 #define MICROPY_PY_BUILTINS_STR_PARTITION (1)
 #define MICROPY_PY_BUILTINS_STR_SPLITLINES (1)
@@ -120,11 +123,22 @@
 #define MICROPY_PY_UERRNO           (1)
 #define MICROPY_PY_UCTYPES          (1)
 #define MICROPY_PY_UZLIB            (1)
+#define MICROPY_PY_UZLIB_COMPRESS   (1)
 #define MICROPY_PY_UJSON            (1)
+#define MICROPY_PY_UJSON_ITERLOAD   (1)
+#define MICROPY_PY_UJSON_DUMPS_INTO (1)
 #define MICROPY_PY_URE              (1)
+#define MICROPY_PY_URE_PIKEVM       (1)
+#define MICROPY_PY_URE_MATCH_SPAN_START_END (1)
+#define MICROPY_PY_URE_FINDITER     (1)
+#define MICROPY_PY_URE_SUB          (1)
 #define MICROPY_PY_UHEAPQ           (1)
 #define MICROPY_PY_UTIMEQ           (1)
+#define MICROPY_PY_UASYNCIO         (1)
+#define MICROPY_PY_UASYNCIO_POLL    (1)
 #define MICROPY_PY_UHASHLIB         (1)
+#define MICROPY_PY_UHASHLIB_HMAC    (1)
+#define MICROPY_PY_UHASHLIB_FILE_DIGEST (1)
 #if MICROPY_PY_USSL
 #define MICROPY_PY_UHASHLIB_SHA1    (1)
 #endif
@@ -134,6 +148,21 @@
 #ifndef MICROPY_PY_USELECT_POSIX
 #define MICROPY_PY_USELECT_POSIX    (1)
 #endif
+// Back uselect.poll with epoll on Linux, so fds are registered with the
+// kernel once and each poll costs only as much as the number of ready fds
+#ifndef MICROPY_PY_USELECT_EPOLL
+#ifdef __linux__
+#define MICROPY_PY_USELECT_EPOLL    (1)
+#else
+#define MICROPY_PY_USELECT_EPOLL    (0)
+#endif
+#endif
+// epoll forgets a closed fd silently, so the port tells uselect.poll about
+// each fd just before closing it.
+#if MICROPY_PY_USELECT_POSIX && MICROPY_PY_USELECT_EPOLL
+void mp_unix_fd_closing(int fd);
+#define MICROPY_HOOK_FD_CLOSING(fd) mp_unix_fd_closing(fd)
+#endif
 #define MICROPY_PY_WEBSOCKET        (1)
 #define MICROPY_PY_MACHINE          (1)
 #define MICROPY_PY_MACHINE_PULSE    (1)
@@ -144,6 +173,7 @@
 #define MICROPY_FATFS_RPATH            (2)
 #define MICROPY_FATFS_MAX_SS           (4096)
 #define MICROPY_FATFS_LFN_CODE_PAGE    (437) /* 1=SFN/ANSI 437=LFN/U.S.(OEM) */
+#define MICROPY_FATFS_USE_FASTSEEK     (1)
 #define MICROPY_VFS_FAT                (0)
 
 // Define to MICROPY_ERROR_REPORTING_DETAILED to get function, etc.
@@ -167,6 +197,7 @@ extern const struct _mp_print_t mp_stderr_print;
 
 #define MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF   (1)
 #define MICROPY_EMERGENCY_EXCEPTION_BUF_SIZE  (256)
+#define MICROPY_OSERROR_POOL_SIZE   (4) // left out when threads run without the GIL
 #define MICROPY_KBD_EXCEPTION       (1)
 #define MICROPY_ASYNC_KBD_INTR      (1)
 
@@ -45,6 +45,7 @@
 #define MICROPY_PY_IO_BUFFEREDWRITER (1)
 #define MICROPY_PY_IO_RESOURCE_STREAM (1)
 #define MICROPY_VFS_POSIX              (1)
+#define MICROPY_VFS_IMPORT_STAT_CACHE  (1)
 #undef MICROPY_VFS_FAT
 #define MICROPY_VFS_FAT                (1)
 #define MICROPY_FATFS_USE_LABEL        (1)
@@ -72,6 +72,22 @@ const byte *mp_decode_uint_skip(const byte *ptr) {
     return ptr;
 }
 
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+// XIP bytecode keeps a pointer to its module's qstr table in the constant
+// table slot directly after the argument names.
+const uint16_t *mp_bytecode_get_xip_qstr_table(const mp_obj_fun_bc_t *fun_bc) {
+    const byte *ip = fun_bc->bytecode;
+    ip = mp_decode_uint_skip(ip); // skip n_state
+    ip = mp_decode_uint_skip(ip); // skip n_exc_stack
+    size_t scope_flags = *ip++;
+    if (!(scope_flags & MP_SCOPE_FLAG_XIP)) {
+        return NULL;
+    }
+    size_t n_args = ip[0] + ip[1]; // n_pos_args + n_kwonly_args
+    return (const uint16_t*)(uintptr_t)fun_bc->const_table[n_args];
+}
+#endif
+
 STATIC NORETURN void fun_pos_args_mismatch(mp_obj_fun_bc_t *f, size_t expected, size_t given) {
 #if MICROPY_ERROR_REPORTING == MICROPY_ERROR_REPORTING_TERSE
     // generic message, used also for other argument issues
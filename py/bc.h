@@ -93,6 +93,12 @@ mp_uint_t mp_decode_uint(const byte **ptr);
 mp_uint_t mp_decode_uint_value(const byte *ptr);
 const byte *mp_decode_uint_skip(const byte *ptr);
 
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+// Returns the qstr table of a function loaded from an execute-in-place .mpy
+// file, or NULL if the function's bytecode holds qstr values directly.
+const uint16_t *mp_bytecode_get_xip_qstr_table(const mp_obj_fun_bc_t *fun_bc);
+#endif
+
 mp_vm_return_kind_t mp_execute_bytecode(mp_code_state_t *code_state, volatile mp_obj_t inject_exc);
 mp_code_state_t *mp_obj_fun_bc_prepare_codestate(mp_obj_t func, size_t n_args, size_t n_kw, const mp_obj_t *args);
 void mp_setup_code_state(mp_code_state_t *code_state, size_t n_args, size_t n_kw, const mp_obj_t *args);
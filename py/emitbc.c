@@ -226,6 +226,11 @@ STATIC void emit_write_bytecode_byte_uint(emit_t *emit, byte b, mp_uint_t val) {
 }
 
 #if MICROPY_PERSISTENT_CODE
+// Number of constant table entries before the objects: the argument names,
+// plus (for execute-in-place bytecode) the slot holding the module qstr table.
+#define EMIT_CT_NUM_PRELUDE(scope) \
+    ((scope)->num_pos_args + (scope)->num_kwonly_args + MICROPY_PERSISTENT_CODE_XIP_DYNAMIC)
+
 STATIC void emit_write_bytecode_byte_const(emit_t *emit, byte b, mp_uint_t n, mp_uint_t c) {
     if (emit->pass == MP_PASS_EMIT) {
         emit->const_table[n] = c;
@@ -249,8 +254,7 @@ STATIC void emit_write_bytecode_byte_qstr(emit_t* emit, byte b, qstr qst) {
 STATIC void emit_write_bytecode_byte_obj(emit_t *emit, byte b, mp_obj_t obj) {
     #if MICROPY_PERSISTENT_CODE
     emit_write_bytecode_byte_const(emit, b,
-        emit->scope->num_pos_args + emit->scope->num_kwonly_args
-        + emit->ct_cur_obj++, (mp_uint_t)obj);
+        EMIT_CT_NUM_PRELUDE(emit->scope) + emit->ct_cur_obj++, (mp_uint_t)obj);
     #else
     // aligns the pointer so it is friendly to GC
     emit_write_bytecode_byte(emit, b);
@@ -265,8 +269,8 @@ STATIC void emit_write_bytecode_byte_obj(emit_t *emit, byte b, mp_obj_t obj) {
 STATIC void emit_write_bytecode_byte_raw_code(emit_t *emit, byte b, mp_raw_code_t *rc) {
     #if MICROPY_PERSISTENT_CODE
     emit_write_bytecode_byte_const(emit, b,
-        emit->scope->num_pos_args + emit->scope->num_kwonly_args
-        + emit->ct_num_obj + emit->ct_cur_raw_code++, (mp_uint_t)(uintptr_t)rc);
+        EMIT_CT_NUM_PRELUDE(emit->scope) + emit->ct_num_obj + emit->ct_cur_raw_code++,
+        (mp_uint_t)(uintptr_t)rc);
     #else
     // aligns the pointer so it is friendly to GC
     emit_write_bytecode_byte(emit, b);
@@ -337,6 +341,9 @@ void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
 
     // Write scope flags and number of arguments.
     // TODO check that num args all fit in a byte
+    if (MICROPY_PERSISTENT_CODE_XIP_DYNAMIC) {
+        emit->scope->scope_flags |= MP_SCOPE_FLAG_XIP;
+    }
     emit_write_code_info_byte(emit, emit->scope->scope_flags);
     emit_write_code_info_byte(emit, emit->scope->num_pos_args);
     emit_write_code_info_byte(emit, emit->scope->num_kwonly_args);
@@ -428,8 +435,7 @@ void mp_emit_bc_end_pass(emit_t *emit) {
 
         #if MICROPY_PERSISTENT_CODE
         emit->const_table = m_new0(mp_uint_t,
-            emit->scope->num_pos_args + emit->scope->num_kwonly_args
-            + emit->ct_cur_obj + emit->ct_cur_raw_code);
+            EMIT_CT_NUM_PRELUDE(emit->scope) + emit->ct_cur_obj + emit->ct_cur_raw_code);
         #else
         emit->const_table = m_new0(mp_uint_t,
             emit->scope->num_pos_args + emit->scope->num_kwonly_args);
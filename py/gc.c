@@ -342,6 +342,13 @@ void gc_collect_start(void) {
     #endif
     MP_STATE_MEM(gc_stack_overflow) = 0;
 
+    #if MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE
+    // The str index cache isn't traced, so forget it before the str it
+    // describes or its offset table can be freed.
+    MP_STATE_VM(str_index_cache).data = NULL;
+    MP_STATE_VM(str_index_cache).alloc = 0;
+    #endif
+
     // Trace root pointers.  This relies on the root pointers being organised
     // correctly in the mp_state_ctx structure.  We scan nlr_top, dict_locals,
     // dict_globals, then the root pointer section of mp_state_vm.
@@ -27,6 +27,7 @@
 #include "py/emitglue.h"
 #include "py/gc_long_lived.h"
 #include "py/gc.h"
+#include "py/bc.h"
 
 mp_obj_fun_bc_t *make_fun_bc_long_lived(mp_obj_fun_bc_t *fun_bc, uint8_t max_depth) {
     #ifndef MICROPY_ENABLE_GC
@@ -37,11 +38,20 @@ mp_obj_fun_bc_t *make_fun_bc_long_lived(mp_obj_fun_bc_t *fun_bc, uint8_t max_dep
     }
     fun_bc->bytecode = gc_make_long_lived((byte*) fun_bc->bytecode);
     fun_bc->globals = make_dict_long_lived(fun_bc->globals, max_depth - 1);
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    // The qstr table of XIP bytecode isn't an object and is already long lived.
+    const uint16_t *xip_qstr_table = mp_bytecode_get_xip_qstr_table(fun_bc);
+    #endif
     for (uint32_t i = 0; i < gc_nbytes(fun_bc->const_table) / sizeof(mp_obj_t); i++) {
         // Skip things that aren't allocated on the heap (and hence have zero bytes.)
         if (gc_nbytes((byte *)fun_bc->const_table[i]) == 0) {
             continue;
         }
+        #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+        if (xip_qstr_table != NULL && fun_bc->const_table[i] == (mp_uint_t)(uintptr_t)xip_qstr_table) {
+            continue;
+        }
+        #endif
         // Try to detect raw code.
         mp_raw_code_t* raw_code = MP_OBJ_TO_PTR(fun_bc->const_table[i]);
         if (raw_code->kind == MP_CODE_BYTECODE) {
@@ -97,6 +97,9 @@ def translate(translation_file, i18ns):
             translations.append((original, translation))
         return translations
 
+# Number of leading bits the decoder uses to look up short codes in one step.
+FAST_LOOKUP_BITS = 8
+
 def compute_huffman_coding(translations, qstrs, compression_filename):
     all_strings = [x[1] for x in translations]
 
@@ -135,9 +138,22 @@ def compute_huffman_coding(translations, qstrs, compression_filename):
     for i in range(1, max(length_count) + 1):
         lengths.append(length_count.get(i, 0))
     print("//", values, lengths)
+    # Index the codes by their first bits so that the decoder can look up a
+    # whole short code at once. Each entry is the code length in the top byte
+    # and the value in the bottom. Zero means the code is longer than the index.
+    fast_lookup = [0] * (1 << FAST_LOOKUP_BITS)
+    for ch, code in canonical.items():
+        l = len(code)
+        if l > FAST_LOOKUP_BITS:
+            continue
+        first = int(code, 2) << (FAST_LOOKUP_BITS - l)
+        for i in range(1 << (FAST_LOOKUP_BITS - l)):
+            fast_lookup[first | i] = (l << 8) | ch
     with open(compression_filename, "w") as f:
         f.write("const uint8_t lengths[] = {{ {} }};\n".format(", ".join(map(str, lengths))))
         f.write("const uint8_t values[256] = {{ {} }};\n".format(", ".join(map(str, values))))
+        f.write("#define FAST_LOOKUP_BITS ({})\n".format(FAST_LOOKUP_BITS))
+        f.write("const uint16_t fast_lookup[{}] = {{ {} }};\n".format(len(fast_lookup), ", ".join(map(str, fast_lookup))))
     return values, lengths
 
 def decompress(encoding_table, length, encoded):
@@ -107,6 +107,13 @@ STATIC mp_obj_t mp_micropython_qstr_info(size_t n_args, const mp_obj_t *args) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_qstr_info_obj, 0, 1, mp_micropython_qstr_info);
 
+#if MICROPY_VFS
+STATIC mp_obj_t mp_micropython_import_stat_count(void) {
+    return mp_obj_new_int_from_uint(MP_STATE_VM(vfs_import_stat_count));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_import_stat_count_obj, mp_micropython_import_stat_count);
+#endif
+
 #endif // MICROPY_PY_MICROPYTHON_MEM_INFO
 
 #if MICROPY_PY_MICROPYTHON_STACK_USE
@@ -173,6 +180,9 @@ STATIC const mp_rom_map_elem_t mp_module_micropython_globals_table[] = {
 #endif
     { MP_ROM_QSTR(MP_QSTR_mem_info), MP_ROM_PTR(&mp_micropython_mem_info_obj) },
     { MP_ROM_QSTR(MP_QSTR_qstr_info), MP_ROM_PTR(&mp_micropython_qstr_info_obj) },
+#if MICROPY_VFS
+    { MP_ROM_QSTR(MP_QSTR_import_stat_count), MP_ROM_PTR(&mp_micropython_import_stat_count_obj) },
+#endif
 #endif
     #if MICROPY_PY_MICROPYTHON_STACK_USE
     { MP_ROM_QSTR(MP_QSTR_stack_use), MP_ROM_PTR(&mp_micropython_stack_use_obj) },
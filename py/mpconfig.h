@@ -252,6 +252,14 @@
 #define MICROPY_PERSISTENT_CODE_SAVE (0)
 #endif
 
+// Whether to support loading .mpy files in the execute-in-place (XIP) layout.
+// Such bytecode refers to qstrs through a per-file table so that, when the
+// reader can expose the file as memory-mapped data, bytecode and constant
+// string data are used in place rather than being copied to the heap.
+#ifndef MICROPY_PERSISTENT_CODE_LOAD_XIP
+#define MICROPY_PERSISTENT_CODE_LOAD_XIP (0)
+#endif
+
 // Whether generated code can persist independently of the VM/runtime instance
 // This is enabled automatically when needed by other features
 #ifndef MICROPY_PERSISTENT_CODE
@@ -326,9 +334,11 @@
 #if MICROPY_DYNAMIC_COMPILER
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC (mp_dynamic_compiler.opt_cache_map_lookup_in_bytecode)
 #define MICROPY_PY_BUILTINS_STR_UNICODE_DYNAMIC (mp_dynamic_compiler.py_builtins_str_unicode)
+#define MICROPY_PERSISTENT_CODE_XIP_DYNAMIC (mp_dynamic_compiler.persistent_code_xip)
 #else
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
 #define MICROPY_PY_BUILTINS_STR_UNICODE_DYNAMIC MICROPY_PY_BUILTINS_STR_UNICODE
+#define MICROPY_PERSISTENT_CODE_XIP_DYNAMIC (0)
 #endif
 
 // Whether to enable constant folding; eg 1+2 rewritten as 3
@@ -402,6 +412,13 @@
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE (0)
 #endif
 
+// Whether the VM handles the common binary ops on small ints and floats
+// inline instead of calling mp_binary_op.  Speeds up arithmetic loops at the
+// cost of some VM code size.
+#ifndef MICROPY_OPT_VM_BINARY_OP_FAST_PATH
+#define MICROPY_OPT_VM_BINARY_OP_FAST_PATH (0)
+#endif
+
 // Whether to use fast versions of bitwise operations (and, or, xor) when the
 // arguments are both positive.  Increases Thumb2 code size by about 250 bytes.
 #ifndef MICROPY_OPT_MPZ_BITWISE
@@ -491,6 +508,16 @@
 #   endif
 #endif
 
+// Number of errno values to keep a preallocated OSError for, so that raising
+// them with mp_raise_OSError doesn't allocate. Each one has room for
+// MICROPY_OSERROR_POOL_TRACEBACK_LEN traceback entries.
+#ifndef MICROPY_OSERROR_POOL_SIZE
+#define MICROPY_OSERROR_POOL_SIZE (0)
+#endif
+#ifndef MICROPY_OSERROR_POOL_TRACEBACK_LEN
+#define MICROPY_OSERROR_POOL_TRACEBACK_LEN (4)
+#endif
+
 // Whether to provide the mp_kbd_exception object, and micropython.kbd_intr function
 #ifndef MICROPY_KBD_EXCEPTION
 #define MICROPY_KBD_EXCEPTION (0)
@@ -697,6 +724,13 @@ typedef double mp_float_t;
 #define MICROPY_VFS (0)
 #endif
 
+// Whether mp_vfs_import_stat answers from a cache of directory listings
+// rather than asking the filesystem for every candidate path; costs heap for
+// the listings of the directories searched by import
+#ifndef MICROPY_VFS_IMPORT_STAT_CACHE
+#define MICROPY_VFS_IMPORT_STAT_CACHE (0)
+#endif
+
 // Support for VFS POSIX component, to mount a POSIX filesystem within VFS
 #ifndef MICROPY_VFS
 #define MICROPY_VFS_POSIX (0)
@@ -765,6 +799,14 @@ typedef double mp_float_t;
 #define MICROPY_PY_BUILTINS_STR_UNICODE_CHECK (MICROPY_PY_BUILTINS_STR_UNICODE)
 #endif
 
+// Whether to cache the byte offset of every 32nd char of the most recently
+// indexed unicode str, making indexing and slicing of long non-ASCII strings
+// O(1) rather than a walk from the start of the UTF-8 data; the table is
+// allocated on the heap and dropped at each garbage collection
+#ifndef MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE
+#define MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE (0)
+#endif
+
 // Whether str.center() method provided
 #ifndef MICROPY_PY_BUILTINS_STR_CENTER
 #define MICROPY_PY_BUILTINS_STR_CENTER (0)
@@ -1146,6 +1188,13 @@ typedef double mp_float_t;
 #define MICROPY_PY_THREAD_GIL_VM_DIVISOR (32)
 #endif
 
+// The preallocated OSErrors are shared by all threads, so they can only be
+// used when the GIL serialises raising them
+#if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+#undef MICROPY_OSERROR_POOL_SIZE
+#define MICROPY_OSERROR_POOL_SIZE (0)
+#endif
+
 // Extended modules
 
 #ifndef MICROPY_PY_UCTYPES
@@ -1156,14 +1205,76 @@ typedef double mp_float_t;
 #define MICROPY_PY_UZLIB (0)
 #endif
 
+// Size of the buffer uzlib.DecompIO reads compressed input into, so the
+// source stream is read in blocks rather than one byte per call
+#ifndef MICROPY_PY_UZLIB_DECOMPIO_BUF_SIZE
+#define MICROPY_PY_UZLIB_DECOMPIO_BUF_SIZE (128)
+#endif
+
+// Whether to provide uzlib.compress and uzlib.CompIO
+#ifndef MICROPY_PY_UZLIB_COMPRESS
+#define MICROPY_PY_UZLIB_COMPRESS (0)
+#endif
+
+// Default wbits for compression, which sets the window size and so the memory
+// used, about 5 * 2**wbits bytes
+#ifndef MICROPY_PY_UZLIB_COMPRESS_WBITS
+#define MICROPY_PY_UZLIB_COMPRESS_WBITS (10)
+#endif
+
 #ifndef MICROPY_PY_UJSON
 #define MICROPY_PY_UJSON (0)
 #endif
 
+// Size of the read-ahead buffer ujson.load uses, so the stream is read in
+// chunks rather than one byte per call
+#ifndef MICROPY_PY_UJSON_LOAD_BUF_SIZE
+#define MICROPY_PY_UJSON_LOAD_BUF_SIZE (128)
+#endif
+
+// Whether to provide ujson.iterload, which parses the elements of a top-level
+// array one at a time
+#ifndef MICROPY_PY_UJSON_ITERLOAD
+#define MICROPY_PY_UJSON_ITERLOAD (0)
+#endif
+
+// Size of the buffer ujson.dump collects output in, so the stream is written
+// in chunks rather than once per token
+#ifndef MICROPY_PY_UJSON_DUMP_BUF_SIZE
+#define MICROPY_PY_UJSON_DUMP_BUF_SIZE (128)
+#endif
+
+// Whether to provide ujson.dumps_into, which serialises into a given buffer
+#ifndef MICROPY_PY_UJSON_DUMPS_INTO
+#define MICROPY_PY_UJSON_DUMPS_INTO (0)
+#endif
+
 #ifndef MICROPY_PY_URE
 #define MICROPY_PY_URE (0)
 #endif
 
+// Whether to provide the ure.LINEAR compile flag, which matches the pattern
+// with a Pike VM: time linear in the input size and no C recursion, at the
+// cost of some heap memory per match
+#ifndef MICROPY_PY_URE_PIKEVM
+#define MICROPY_PY_URE_PIKEVM (0)
+#endif
+
+// Whether to provide the span, start and end methods of ure match objects
+#ifndef MICROPY_PY_URE_MATCH_SPAN_START_END
+#define MICROPY_PY_URE_MATCH_SPAN_START_END (0)
+#endif
+
+// Whether to provide ure.finditer and the finditer method of regex objects
+#ifndef MICROPY_PY_URE_FINDITER
+#define MICROPY_PY_URE_FINDITER (0)
+#endif
+
+// Whether to provide ure.sub and the sub method of regex objects
+#ifndef MICROPY_PY_URE_SUB
+#define MICROPY_PY_URE_SUB (0)
+#endif
+
 #ifndef MICROPY_PY_UHEAPQ
 #define MICROPY_PY_UHEAPQ (0)
 #endif
@@ -1173,6 +1284,16 @@ typedef double mp_float_t;
 #define MICROPY_PY_UTIMEQ (0)
 #endif
 
+// Whether to provide the "uasyncio" event loop, which needs MICROPY_PY_UTIMEQ
+#ifndef MICROPY_PY_UASYNCIO
+#define MICROPY_PY_UASYNCIO (0)
+#endif
+
+// Whether uasyncio can wait for streams using uselect.poll
+#ifndef MICROPY_PY_UASYNCIO_POLL
+#define MICROPY_PY_UASYNCIO_POLL (MICROPY_PY_USELECT)
+#endif
+
 #ifndef MICROPY_PY_UHASHLIB
 #define MICROPY_PY_UHASHLIB (0)
 #endif
@@ -1185,6 +1306,19 @@ typedef double mp_float_t;
 #define MICROPY_PY_UHASHLIB_SHA256 (1)
 #endif
 
+// Whether to provide uhashlib.hmac_sha256
+#ifndef MICROPY_PY_UHASHLIB_HMAC
+#define MICROPY_PY_UHASHLIB_HMAC (0)
+#endif
+
+// Whether to provide uhashlib.file_digest, and the size of its read buffer
+#ifndef MICROPY_PY_UHASHLIB_FILE_DIGEST
+#define MICROPY_PY_UHASHLIB_FILE_DIGEST (0)
+#endif
+#ifndef MICROPY_PY_UHASHLIB_FILE_DIGEST_BUF_SIZE
+#define MICROPY_PY_UHASHLIB_FILE_DIGEST_BUF_SIZE (4096)
+#endif
+
 #ifndef MICROPY_PY_UBINASCII
 #define MICROPY_PY_UBINASCII (0)
 #endif
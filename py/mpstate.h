@@ -46,6 +46,7 @@ typedef struct mp_dynamic_compiler_t {
     uint8_t small_int_bits; // must be <= host small_int_bits
     bool opt_cache_map_lookup_in_bytecode;
     bool py_builtins_str_unicode;
+    bool persistent_code_xip; // emit bytecode for the execute-in-place .mpy layout
 } mp_dynamic_compiler_t;
 extern mp_dynamic_compiler_t mp_dynamic_compiler;
 #endif
@@ -60,6 +61,17 @@ typedef struct _mp_sched_item_t {
     mp_obj_t arg;
 } mp_sched_item_t;
 
+#if MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE
+// Character offsets of the most recently indexed str, see objstrunicode.c.
+typedef struct _mp_str_index_cache_t {
+    const byte *data; // data of the str described, NULL if none
+    size_t len; // length of the str in bytes
+    size_t charlen; // length of the str in chars, equal to len if it's ASCII
+    size_t *offsets; // byte offset of every 32nd char, unused if ASCII
+    size_t alloc; // number of offsets allocated
+} mp_str_index_cache_t;
+#endif
+
 // This structure hold information about the memory allocation system.
 typedef struct _mp_state_mem_t {
     #if MICROPY_MEM_STATS
@@ -120,6 +132,11 @@ typedef struct _mp_state_vm_t {
     // non-heap memory for creating an exception if we can't allocate RAM
     mp_obj_exception_t mp_emergency_exception_obj;
 
+    #if MICROPY_OSERROR_POOL_SIZE > 0
+    // non-heap OSErrors handed out by mp_obj_new_exception_errno
+    mp_obj_exception_pool_entry_t mp_oserror_pool[MICROPY_OSERROR_POOL_SIZE];
+    #endif
+
     // memory for exception arguments if we can't allocate RAM
     #if MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF
     #if MICROPY_EMERGENCY_EXCEPTION_BUF_SIZE > 0
@@ -180,6 +197,10 @@ typedef struct _mp_state_vm_t {
     mp_obj_t dupterm_arr_obj;
     #endif
 
+    #if MICROPY_PY_UASYNCIO
+    struct _uasyncio_loop_t *uasyncio_loop;
+    #endif
+
     #if MICROPY_PY_LWIP_SLIP
     mp_obj_t lwip_slip_stream;
     #endif
@@ -187,6 +208,9 @@ typedef struct _mp_state_vm_t {
     #if MICROPY_VFS
     struct _mp_vfs_mount_t *vfs_cur;
     struct _mp_vfs_mount_t *vfs_mount_table;
+    #if MICROPY_VFS_IMPORT_STAT_CACHE
+    mp_obj_t vfs_import_stat_cache;
+    #endif
     #endif
 
     //
@@ -218,6 +242,16 @@ typedef struct _mp_state_vm_t {
     uint16_t sched_sp;
     #endif
 
+    #if MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE
+    // not traced, so it doesn't keep a str alive; the GC drops it instead
+    mp_str_index_cache_t str_index_cache;
+    #endif
+
+    #if MICROPY_VFS && MICROPY_PY_MICROPYTHON_MEM_INFO
+    // number of filesystem queries (stats and listings) made by mp_vfs_import_stat
+    size_t vfs_import_stat_count;
+    #endif
+
     #if MICROPY_PY_THREAD_GIL
     // This is a global mutex used to make the VM/runtime thread-safe.
     mp_thread_mutex_t gil_mutex;
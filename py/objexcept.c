@@ -339,6 +339,44 @@ mp_obj_t mp_obj_new_exception_args(const mp_obj_type_t *exc_type, size_t n_args,
     return exc_type->make_new(exc_type, n_args, args, NULL);
 }
 
+#if MICROPY_OSERROR_POOL_SIZE > 0
+// Return the pool entry that the given exception is, if any.
+STATIC mp_obj_exception_pool_entry_t *oserror_pool_entry(mp_obj_exception_t *self) {
+    mp_obj_exception_pool_entry_t *pool = MP_STATE_VM(mp_oserror_pool);
+    if ((void*)self < (void*)pool || (void*)self >= (void*)(pool + MICROPY_OSERROR_POOL_SIZE)) {
+        return NULL;
+    }
+    return (mp_obj_exception_pool_entry_t*)self;
+}
+#endif
+
+// Raising the same errno again returns the same instance when it is in the
+// pool, so polling loops that catch it don't create garbage. Its args never
+// change but a reference kept from an earlier raise sees the latest traceback.
+mp_obj_t mp_obj_new_exception_errno(int errno_) {
+    mp_obj_t errno_obj = MP_OBJ_NEW_SMALL_INT(errno_);
+    #if MICROPY_OSERROR_POOL_SIZE > 0
+    for (size_t i = 0; i < MICROPY_OSERROR_POOL_SIZE; i++) {
+        mp_obj_exception_pool_entry_t *entry = &MP_STATE_VM(mp_oserror_pool)[i];
+        if (entry->exc.base.type == NULL) {
+            // Entries are never given back so that the args stay the same.
+            entry->exc.base.type = &mp_type_OSError;
+            entry->args.base.type = &mp_type_tuple;
+            entry->args.len = 1;
+            entry->args.items[0] = errno_obj;
+            entry->exc.args = (mp_obj_tuple_t*)&entry->args;
+        } else if (entry->args.items[0] != errno_obj) {
+            continue;
+        }
+        entry->exc.traceback_data = entry->traceback;
+        entry->exc.traceback_alloc = MP_ARRAY_SIZE(entry->traceback);
+        entry->exc.traceback_len = 0;
+        return MP_OBJ_FROM_PTR(&entry->exc);
+    }
+    #endif
+    return mp_obj_new_exception_arg1(&mp_type_OSError, errno_obj);
+}
+
 mp_obj_t mp_obj_new_exception_msg(const mp_obj_type_t *exc_type, const compressed_string_t *msg) {
     return mp_obj_new_exception_msg_varg(exc_type, msg);
 }
@@ -494,6 +532,16 @@ void mp_obj_exception_add_traceback(mp_obj_t self_in, qstr file, size_t line, qs
     // append this traceback info to traceback data
     // if memory allocation fails (eg because gc is locked), just return
 
+    #if MICROPY_OSERROR_POOL_SIZE > 0
+    mp_obj_exception_pool_entry_t *entry = oserror_pool_entry(self);
+    if (entry != NULL && self->traceback_data == NULL) {
+        // The traceback was cleared so start again in the fixed storage.
+        self->traceback_data = entry->traceback;
+        self->traceback_alloc = MP_ARRAY_SIZE(entry->traceback);
+        self->traceback_len = 0;
+    }
+    #endif
+
     if (self->traceback_data == NULL) {
         self->traceback_data = m_new_maybe(size_t, TRACEBACK_ENTRY_LEN);
         if (self->traceback_data == NULL) {
@@ -517,6 +565,12 @@ void mp_obj_exception_add_traceback(mp_obj_t self_in, qstr file, size_t line, qs
         }
         self->traceback_len = 0;
     } else if (self->traceback_len + TRACEBACK_ENTRY_LEN > self->traceback_alloc) {
+        #if MICROPY_OSERROR_POOL_SIZE > 0
+        if (entry != NULL) {
+            // Can't resize the fixed storage so keep the innermost entries
+            return;
+        }
+        #endif
         #if MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF
         if (self->traceback_data == (size_t*)MP_STATE_VM(mp_emergency_exception_buf)) {
             // Can't resize the emergency buffer
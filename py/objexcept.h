@@ -37,6 +37,21 @@ typedef struct _mp_obj_exception_t {
     mp_obj_tuple_t *args;
 } mp_obj_exception_t;
 
+#if MICROPY_OSERROR_POOL_SIZE > 0
+// A preallocated OSError for a single errno value, along with its args tuple
+// and traceback storage.
+typedef struct _mp_obj_exception_pool_entry_t {
+    mp_obj_exception_t exc;
+    struct {
+        mp_obj_base_t base;
+        size_t len;
+        mp_obj_t items[1];
+    } args;
+    // file, line and block of each entry
+    size_t traceback[MICROPY_OSERROR_POOL_TRACEBACK_LEN * 3];
+} mp_obj_exception_pool_entry_t;
+#endif
+
 void mp_obj_exception_print(const mp_print_t *print, mp_obj_t o_in, mp_print_kind_t kind);
 void mp_obj_exception_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest);
 
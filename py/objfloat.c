@@ -30,6 +30,7 @@
 #include <assert.h>
 
 #include "py/parsenum.h"
+#include "py/smallint.h"
 #include "py/runtime.h"
 
 #include "supervisor/shared/translate.h"
@@ -125,6 +126,33 @@ STATIC void float_print(const mp_print_t *print, mp_obj_t o_in, mp_print_kind_t
     char buf[32];
     const int precision = 16;
 #endif
+    // Whole numbers below this bound are printed by 'g' formatting as their
+    // exact integer digits, so format them directly without mp_format_float.
+    #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT
+    const mp_float_t int_bound = precision == 6 ? MICROPY_FLOAT_CONST(1e6) : MICROPY_FLOAT_CONST(1e7);
+    #else
+    const mp_float_t int_bound = (mp_float_t)MP_SMALL_INT_MAX < 1e15 ? (mp_float_t)MP_SMALL_INT_MAX : 1e15;
+    #endif
+    if (-int_bound < o_val && o_val < int_bound) {
+        mp_int_t i = (mp_int_t)o_val;
+        if ((mp_float_t)i == o_val) {
+            // build the digits backwards from the end of buf
+            char *s = buf + sizeof(buf);
+            *--s = '0';
+            *--s = '.';
+            mp_uint_t u = i < 0 ? -(mp_uint_t)i : (mp_uint_t)i;
+            do {
+                *--s = '0' + u % 10;
+                u /= 10;
+            } while (u != 0);
+            if (MICROPY_FLOAT_C_FUN(copysign)(1, o_val) < 0) {
+                // includes -0.0
+                *--s = '-';
+            }
+            print->print_strn(print->data, s, buf + sizeof(buf) - s);
+            return;
+        }
+    }
     mp_format_float(o_val, buf, sizeof(buf), 'g', precision, '\0');
     mp_print_str(print, buf);
     if (strchr(buf, '.') == NULL && strchr(buf, 'e') == NULL && strchr(buf, 'n') == NULL) {
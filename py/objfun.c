@@ -167,7 +167,14 @@ qstr mp_obj_fun_get_name(mp_const_obj_t fun_in) {
     bc++; // skip n_pos_args
     bc++; // skip n_kwonly_args
     bc++; // skip n_def_pos_args
-    return mp_obj_code_get_name(bc);
+    qstr name = mp_obj_code_get_name(bc);
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    const uint16_t *xip_qstr_table = mp_bytecode_get_xip_qstr_table(fun);
+    if (xip_qstr_table != NULL) {
+        name = xip_qstr_table[name];
+    }
+    #endif
+    return name;
 }
 
 #if MICROPY_CPYTHON_COMPAT
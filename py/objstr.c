@@ -938,7 +938,8 @@ STATIC NORETURN void terse_str_format_value_error(void) {
 STATIC vstr_t mp_obj_str_format_helper(const char *str, const char *top, int *arg_i, size_t n_args, const mp_obj_t *args, mp_map_t *kwargs) {
     vstr_t vstr;
     mp_print_t print;
-    vstr_init_print(&vstr, 16, &print);
+    // the result is usually at least as long as the format string
+    vstr_init_print(&vstr, top - str + 16, &print);
 
     for (; str < top; str++) {
         if (*str == '}') {
@@ -1096,11 +1097,14 @@ STATIC vstr_t mp_obj_str_format_helper(const char *str, const char *top, int *ar
                 assert(conversion == 'r');
                 print_kind = PRINT_REPR;
             }
-            vstr_t arg_vstr;
-            mp_print_t arg_print;
-            vstr_init_print(&arg_vstr, 16, &arg_print);
-            mp_obj_print_helper(&arg_print, arg, print_kind);
-            arg = mp_obj_new_str_from_vstr(&mp_type_str, &arg_vstr);
+            // str(arg) is arg itself for an exact str, so only convert other objects
+            if (print_kind == PRINT_REPR || !MP_OBJ_IS_STR(arg)) {
+                vstr_t arg_vstr;
+                mp_print_t arg_print;
+                vstr_init_print(&arg_vstr, 16, &arg_print);
+                mp_obj_print_helper(&arg_print, arg, print_kind);
+                arg = mp_obj_new_str_from_vstr(&mp_type_str, &arg_vstr);
+            }
         }
 
         char fill = '\0';
@@ -1393,7 +1397,8 @@ STATIC mp_obj_t str_modulo_format(mp_obj_t pattern, size_t n_args, const mp_obj_
     size_t arg_i = 0;
     vstr_t vstr;
     mp_print_t print;
-    vstr_init_print(&vstr, 16, &print);
+    // the result is usually at least as long as the format string
+    vstr_init_print(&vstr, len + 16, &print);
 
     for (const byte *top = str + len; str < top; str++) {
         mp_obj_t arg = MP_OBJ_NULL;
@@ -1536,24 +1541,37 @@ not_enough_args:
             case 's':
             {
                 vstr_t arg_vstr;
-                mp_print_t arg_print;
-                vstr_init_print(&arg_vstr, 16, &arg_print);
-                mp_print_kind_t print_kind = (*str == 'r' ? PRINT_REPR : PRINT_STR);
-                if (print_kind == PRINT_STR && is_bytes && MP_OBJ_IS_TYPE(arg, &mp_type_bytes)) {
-                    // If we have something like b"%s" % b"1", bytes arg should be
-                    // printed undecorated.
-                    print_kind = PRINT_RAW;
+                const char *arg_data;
+                uint vlen;
+                bool arg_is_str = *str == 's' && !is_bytes && MP_OBJ_IS_STR(arg);
+                if (arg_is_str) {
+                    // str(arg) is arg itself, so use its data without a copy
+                    GET_STR_DATA_LEN(arg, arg_str_data, arg_str_len);
+                    arg_data = (const char*)arg_str_data;
+                    vlen = arg_str_len;
+                } else {
+                    mp_print_t arg_print;
+                    vstr_init_print(&arg_vstr, 16, &arg_print);
+                    mp_print_kind_t print_kind = (*str == 'r' ? PRINT_REPR : PRINT_STR);
+                    if (print_kind == PRINT_STR && is_bytes && MP_OBJ_IS_TYPE(arg, &mp_type_bytes)) {
+                        // If we have something like b"%s" % b"1", bytes arg should be
+                        // printed undecorated.
+                        print_kind = PRINT_RAW;
+                    }
+                    mp_obj_print_helper(&arg_print, arg, print_kind);
+                    arg_data = arg_vstr.buf;
+                    vlen = arg_vstr.len;
                 }
-                mp_obj_print_helper(&arg_print, arg, print_kind);
-                uint vlen = arg_vstr.len;
                 if (prec < 0) {
                     prec = vlen;
                 }
                 if (vlen > (uint)prec) {
                     vlen = prec;
                 }
-                mp_print_strn(&print, arg_vstr.buf, vlen, flags, ' ', width);
-                vstr_clear(&arg_vstr);
+                mp_print_strn(&print, arg_data, vlen, flags, ' ', width);
+                if (!arg_is_str) {
+                    vstr_clear(&arg_vstr);
+                }
                 break;
             }
 
@@ -100,12 +100,66 @@ STATIC void uni_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t
     }
 }
 
+#if MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE
+
+// The byte offset of every (1 << STR_INDEX_CACHE_STRIDE_LOG2)'th char is
+// cached.  Strings shorter than one stride are cheap enough to walk.
+#define STR_INDEX_CACHE_STRIDE_LOG2 (5)
+
+// Return the index cache for the given str data, building it if the cache
+// currently describes a different str.  Strings are immutable and the cache is
+// dropped whenever the GC could free them, so the data pointer identifies the
+// str.  Returns NULL if there isn't enough memory for the offset table.
+STATIC mp_str_index_cache_t *str_index_cache_get(const byte *self_data, size_t self_len) {
+    mp_str_index_cache_t *cache = &MP_STATE_VM(str_index_cache);
+    if (cache->data == self_data && cache->len == self_len) {
+        return cache;
+    }
+
+    size_t charlen = utf8_charlen(self_data, self_len);
+    if (charlen != self_len) {
+        size_t n = ((charlen - 1) >> STR_INDEX_CACHE_STRIDE_LOG2) + 1;
+        if (n > cache->alloc) {
+            // The old table is garbage by now; allocating may collect it and
+            // reset the cache, so only fill the cache in afterwards.
+            cache->data = NULL;
+            size_t *offsets = m_new_maybe(size_t, n);
+            if (offsets == NULL) {
+                return NULL;
+            }
+            cache->offsets = offsets;
+            cache->alloc = n;
+        }
+        size_t i = 0;
+        for (const byte *s = self_data, *top = self_data + self_len; s < top; ++s) {
+            if (!UTF8_IS_CONT(*s)) {
+                if ((i & ((1 << STR_INDEX_CACHE_STRIDE_LOG2) - 1)) == 0) {
+                    cache->offsets[i >> STR_INDEX_CACHE_STRIDE_LOG2] = s - self_data;
+                }
+                ++i;
+            }
+        }
+    }
+
+    cache->data = self_data;
+    cache->len = self_len;
+    cache->charlen = charlen;
+    return cache;
+}
+
+#endif
+
 STATIC mp_obj_t uni_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
     GET_STR_DATA_LEN(self_in, str_data, str_len);
     switch (op) {
         case MP_UNARY_OP_BOOL:
             return mp_obj_new_bool(str_len != 0);
         case MP_UNARY_OP_LEN:
+            #if MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE
+            if (MP_STATE_VM(str_index_cache).data == str_data && MP_STATE_VM(str_index_cache).len == str_len) {
+                return MP_OBJ_NEW_SMALL_INT(MP_STATE_VM(str_index_cache).charlen);
+            }
+            #endif
             return MP_OBJ_NEW_SMALL_INT(utf8_charlen(str_data, str_len));
         default:
             return MP_OBJ_NULL; // op not supported
@@ -134,6 +188,42 @@ const byte *str_index_to_ptr(const mp_obj_type_t *type, const byte *self_data, s
         mp_raise_TypeError_varg(translate("string indices must be integers, not %s"), mp_obj_get_type_str(index));
     }
     const byte *s, *top = self_data + self_len;
+
+    #if MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE
+    mp_str_index_cache_t *cache;
+    if (self_len >= (1 << STR_INDEX_CACHE_STRIDE_LOG2)
+        && (cache = str_index_cache_get(self_data, self_len)) != NULL) {
+        if (i < 0) {
+            i += cache->charlen;
+            if (i < 0) {
+                if (is_slice) {
+                    return self_data;
+                }
+                mp_raise_IndexError(translate("string index out of range"));
+            }
+        }
+        if ((size_t)i >= cache->charlen) {
+            if (is_slice) {
+                return top;
+            }
+            mp_raise_IndexError(translate("string index out of range"));
+        }
+        if (cache->charlen == self_len) {
+            // ASCII, so chars and bytes coincide
+            return self_data + i;
+        }
+        // Start at the preceding checkpoint and skip the remaining chars
+        s = self_data + cache->offsets[i >> STR_INDEX_CACHE_STRIDE_LOG2];
+        for (i &= (1 << STR_INDEX_CACHE_STRIDE_LOG2) - 1; i > 0; --i) {
+            ++s;
+            while (UTF8_IS_CONT(*s)) {
+                ++s;
+            }
+        }
+        return s;
+    }
+    #endif
+
     if (i < 0)
     {
         // Negative indexing is performed by counting from the end of the string.
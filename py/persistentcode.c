@@ -55,6 +55,14 @@
     | ((MICROPY_PY_BUILTINS_STR_UNICODE_DYNAMIC) << 1) \
     )
 
+// Set in the feature flags byte when the file uses the execute-in-place
+// layout.  Such a file starts with a table of all the qstrs it uses, and its
+// bytecode (including the simple_name and source_file entries of the code
+// info) refers to qstrs by their index in that table.  Argument names are
+// saved as table indices, and str/bytes constants are stored with a trailing
+// null byte so that they can be referenced in place.
+#define MPY_FEATURE_XIP (0x80)
+
 #if MICROPY_PERSISTENT_CODE_LOAD || (MICROPY_PERSISTENT_CODE_SAVE && !MICROPY_DYNAMIC_COMPILER)
 // The bytecode will depend on the number of bits in a small-int, and
 // this function computes that (could make it a fixed constant, but it
@@ -132,8 +140,7 @@ STATIC qstr load_qstr(mp_reader_t *reader) {
     return qst;
 }
 
-STATIC mp_obj_t load_obj(mp_reader_t *reader) {
-    byte obj_type = read_byte(reader);
+STATIC mp_obj_t load_obj_of_type(mp_reader_t *reader, byte obj_type) {
     if (obj_type == 'e') {
         return MP_OBJ_FROM_PTR(&mp_const_ellipsis_obj);
     } else {
@@ -152,6 +159,66 @@ STATIC mp_obj_t load_obj(mp_reader_t *reader) {
     }
 }
 
+STATIC mp_obj_t load_obj(mp_reader_t *reader) {
+    return load_obj_of_type(reader, read_byte(reader));
+}
+
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+
+#include "py/objstr.h"
+
+// Returns a pointer to the next len bytes if the reader can provide them in
+// place for the lifetime of the program, otherwise NULL.
+STATIC const byte *read_ptr(mp_reader_t *reader, size_t len) {
+    if (reader->readptr == NULL) {
+        return NULL;
+    }
+    return reader->readptr(reader->data, len);
+}
+
+STATIC const uint16_t *load_xip_qstr_table(mp_reader_t *reader) {
+    size_t n_qstr = read_uint(reader);
+    // the table lives as long as the module's functions so allocate it long lived
+    uint16_t *qstr_table = m_new_ll(uint16_t, n_qstr);
+    for (size_t i = 0; i < n_qstr; ++i) {
+        qstr_table[i] = load_qstr(reader);
+    }
+    return qstr_table;
+}
+
+STATIC mp_obj_t load_xip_obj(mp_reader_t *reader) {
+    byte obj_type = read_byte(reader);
+    if (obj_type == 's' || obj_type == 'b') {
+        size_t len = read_uint(reader);
+        // data is followed by a null byte, like heap allocated str/bytes
+        const byte *data = read_ptr(reader, len + 1);
+        if (data == NULL) {
+            vstr_t vstr;
+            vstr_init_len(&vstr, len);
+            read_bytes(reader, (byte*)vstr.buf, len);
+            read_byte(reader);
+            return mp_obj_new_str_from_vstr(obj_type == 's' ? &mp_type_str : &mp_type_bytes, &vstr);
+        }
+        if (obj_type == 's') {
+            qstr q = qstr_find_strn((const char*)data, len);
+            if (q != MP_QSTR_NULL) {
+                return MP_OBJ_NEW_QSTR(q);
+            }
+        }
+        // only the object header goes on the heap, the data stays in place
+        mp_obj_str_t *o = m_new_obj(mp_obj_str_t);
+        o->base.type = obj_type == 's' ? &mp_type_str : &mp_type_bytes;
+        o->hash = qstr_compute_hash(data, len);
+        o->len = len;
+        o->data = data;
+        return MP_OBJ_FROM_PTR(o);
+    }
+    // remaining object types are encoded as in the regular layout
+    return load_obj_of_type(reader, obj_type);
+}
+
+#endif
+
 STATIC void load_bytecode_qstrs(mp_reader_t *reader, byte *ip, byte *ip_top) {
     while (ip < ip_top) {
         size_t sz;
@@ -165,11 +232,21 @@ STATIC void load_bytecode_qstrs(mp_reader_t *reader, byte *ip, byte *ip_top) {
     }
 }
 
-STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
+// xip_qstr_table is non-NULL when loading a file in the execute-in-place layout
+STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader, const uint16_t *xip_qstr_table) {
     // load bytecode
     size_t bc_len = read_uint(reader);
-    byte *bytecode = m_new(byte, bc_len);
-    read_bytes(reader, bytecode, bc_len);
+    byte *bytecode = NULL;
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    if (xip_qstr_table != NULL) {
+        // XIP bytecode needs no linking so it can be used in place if possible
+        bytecode = (byte*)read_ptr(reader, bc_len);
+    }
+    #endif
+    if (bytecode == NULL) {
+        bytecode = m_new(byte, bc_len);
+        read_bytes(reader, bytecode, bc_len);
+    }
 
     // extract prelude
     const byte *ip = bytecode;
@@ -177,26 +254,48 @@ STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
     bytecode_prelude_t prelude;
     extract_prelude(&ip, &ip2, &prelude);
 
-    // load qstrs and link global qstr ids into bytecode
-    qstr simple_name = load_qstr(reader);
-    qstr source_file = load_qstr(reader);
-    ((byte*)ip2)[0] = simple_name; ((byte*)ip2)[1] = simple_name >> 8;
-    ((byte*)ip2)[2] = source_file; ((byte*)ip2)[3] = source_file >> 8;
-    load_bytecode_qstrs(reader, (byte*)ip, bytecode + bc_len);
+    size_t n_ct_prelude = prelude.n_pos_args + prelude.n_kwonly_args;
+    if (xip_qstr_table == NULL) {
+        // load qstrs and link global qstr ids into bytecode
+        qstr simple_name = load_qstr(reader);
+        qstr source_file = load_qstr(reader);
+        ((byte*)ip2)[0] = simple_name; ((byte*)ip2)[1] = simple_name >> 8;
+        ((byte*)ip2)[2] = source_file; ((byte*)ip2)[3] = source_file >> 8;
+        load_bytecode_qstrs(reader, (byte*)ip, bytecode + bc_len);
+    } else {
+        // XIP bytecode reserves a slot for the qstr table after the argument names
+        n_ct_prelude += 1;
+    }
 
     // load constant table
     size_t n_obj = read_uint(reader);
     size_t n_raw_code = read_uint(reader);
-    mp_uint_t *const_table = m_new(mp_uint_t, prelude.n_pos_args + prelude.n_kwonly_args + n_obj + n_raw_code);
+    mp_uint_t *const_table = m_new(mp_uint_t, n_ct_prelude + n_obj + n_raw_code);
     mp_uint_t *ct = const_table;
     for (size_t i = 0; i < prelude.n_pos_args + prelude.n_kwonly_args; ++i) {
+        #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+        if (xip_qstr_table != NULL) {
+            *ct++ = (mp_uint_t)MP_OBJ_NEW_QSTR(xip_qstr_table[read_uint(reader)]);
+            continue;
+        }
+        #endif
         *ct++ = (mp_uint_t)MP_OBJ_NEW_QSTR(load_qstr(reader));
     }
-    for (size_t i = 0; i < n_obj; ++i) {
-        *ct++ = (mp_uint_t)load_obj(reader);
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    if (xip_qstr_table != NULL) {
+        *ct++ = (mp_uint_t)(uintptr_t)xip_qstr_table;
+        for (size_t i = 0; i < n_obj; ++i) {
+            *ct++ = (mp_uint_t)load_xip_obj(reader);
+        }
+    } else
+    #endif
+    {
+        for (size_t i = 0; i < n_obj; ++i) {
+            *ct++ = (mp_uint_t)load_obj(reader);
+        }
     }
     for (size_t i = 0; i < n_raw_code; ++i) {
-        *ct++ = (mp_uint_t)(uintptr_t)load_raw_code(reader);
+        *ct++ = (mp_uint_t)(uintptr_t)load_raw_code(reader, xip_qstr_table);
     }
 
     // create raw_code and return it
@@ -216,13 +315,24 @@ STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
 mp_raw_code_t *mp_raw_code_load(mp_reader_t *reader) {
     byte header[4];
     read_bytes(reader, header, sizeof(header));
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    byte feature_flags = header[2] & ~MPY_FEATURE_XIP;
+    #else
+    byte feature_flags = header[2];
+    #endif
     if (header[0] != 'M'
         || header[1] != MPY_VERSION
-        || header[2] != MPY_FEATURE_FLAGS
+        || feature_flags != MPY_FEATURE_FLAGS
         || header[3] > mp_small_int_bits()) {
         mp_raise_ValueError(translate("Incompatible .mpy file. Please update all .mpy files. See http://adafru.it/mpy-update for more info."));
     }
-    mp_raw_code_t *rc = load_raw_code(reader);
+    const uint16_t *xip_qstr_table = NULL;
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    if (header[2] & MPY_FEATURE_XIP) {
+        xip_qstr_table = load_xip_qstr_table(reader);
+    }
+    #endif
+    mp_raw_code_t *rc = load_raw_code(reader, xip_qstr_table);
     reader->close(reader->data);
     return rc;
 }
@@ -321,25 +431,72 @@ STATIC void save_bytecode_qstrs(mp_print_t *print, const byte *ip, const byte *i
     }
 }
 
-STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc) {
+// Returns the index of qst in the qstr table of an XIP file, adding it if needed
+STATIC size_t xip_qstr_index(mp_map_t *qstr_map, qstr qst) {
+    mp_map_elem_t *elem = mp_map_lookup(qstr_map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+    if (elem->value == MP_OBJ_NULL) {
+        elem->value = MP_OBJ_NEW_SMALL_INT(qstr_map->used - 1);
+    }
+    return MP_OBJ_SMALL_INT_VALUE(elem->value);
+}
+
+STATIC void xip_link_qstr(byte *ip, mp_map_t *qstr_map) {
+    size_t idx = xip_qstr_index(qstr_map, ip[0] | (ip[1] << 8));
+    assert(idx <= 0xffff);
+    ip[0] = idx;
+    ip[1] = idx >> 8;
+}
+
+// Saves the bytecode with each qstr replaced by its index in the XIP qstr table
+STATIC void save_xip_bytecode(mp_print_t *print, mp_raw_code_t *rc, mp_map_t *qstr_map) {
+    size_t bc_len = rc->data.u_byte.bc_len;
+    byte *bytecode = m_new(byte, bc_len);
+    memcpy(bytecode, rc->data.u_byte.bytecode, bc_len);
+
+    const byte *ip = bytecode;
+    const byte *ip2;
+    bytecode_prelude_t prelude;
+    extract_prelude(&ip, &ip2, &prelude);
+    xip_link_qstr((byte*)ip2, qstr_map); // simple_name
+    xip_link_qstr((byte*)ip2 + 2, qstr_map); // source_file
+    while (ip < bytecode + bc_len) {
+        size_t sz;
+        uint f = mp_opcode_format(ip, &sz);
+        if (f == MP_OPCODE_QSTR) {
+            xip_link_qstr((byte*)ip + 1, qstr_map);
+        }
+        ip += sz;
+    }
+
+    mp_print_uint(print, bc_len);
+    mp_print_bytes(print, bytecode, bc_len);
+    m_del(byte, bytecode, bc_len);
+}
+
+// qstr_map is non-NULL when saving in the execute-in-place layout
+STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc, mp_map_t *qstr_map) {
     if (rc->kind != MP_CODE_BYTECODE) {
         mp_raise_ValueError(translate("can only save bytecode"));
     }
 
-    // save bytecode
-    mp_print_uint(print, rc->data.u_byte.bc_len);
-    mp_print_bytes(print, rc->data.u_byte.bytecode, rc->data.u_byte.bc_len);
-
     // extract prelude
     const byte *ip = rc->data.u_byte.bytecode;
     const byte *ip2;
     bytecode_prelude_t prelude;
     extract_prelude(&ip, &ip2, &prelude);
 
-    // save qstrs
-    save_qstr(print, ip2[0] | (ip2[1] << 8)); // simple_name
-    save_qstr(print, ip2[2] | (ip2[3] << 8)); // source_file
-    save_bytecode_qstrs(print, ip, rc->data.u_byte.bytecode + rc->data.u_byte.bc_len);
+    if (qstr_map != NULL) {
+        save_xip_bytecode(print, rc, qstr_map);
+    } else {
+        // save bytecode
+        mp_print_uint(print, rc->data.u_byte.bc_len);
+        mp_print_bytes(print, rc->data.u_byte.bytecode, rc->data.u_byte.bc_len);
+
+        // save qstrs
+        save_qstr(print, ip2[0] | (ip2[1] << 8)); // simple_name
+        save_qstr(print, ip2[2] | (ip2[3] << 8)); // source_file
+        save_bytecode_qstrs(print, ip, rc->data.u_byte.bytecode + rc->data.u_byte.bc_len);
+    }
 
     // save constant table
     mp_print_uint(print, rc->data.u_byte.n_obj);
@@ -347,13 +504,27 @@ STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc) {
     const mp_uint_t *const_table = rc->data.u_byte.const_table;
     for (uint i = 0; i < prelude.n_pos_args + prelude.n_kwonly_args; ++i) {
         mp_obj_t o = (mp_obj_t)*const_table++;
-        save_qstr(print, MP_OBJ_QSTR_VALUE(o));
+        if (qstr_map != NULL) {
+            mp_print_uint(print, xip_qstr_index(qstr_map, MP_OBJ_QSTR_VALUE(o)));
+        } else {
+            save_qstr(print, MP_OBJ_QSTR_VALUE(o));
+        }
+    }
+    if (qstr_map != NULL) {
+        // skip the slot reserved for the qstr table, it is filled in at load time
+        const_table++;
     }
     for (uint i = 0; i < rc->data.u_byte.n_obj; ++i) {
-        save_obj(print, (mp_obj_t)*const_table++);
+        mp_obj_t o = (mp_obj_t)*const_table++;
+        save_obj(print, o);
+        if (qstr_map != NULL && MP_OBJ_IS_STR_OR_BYTES(o)) {
+            // null terminate so the data can be referenced in place
+            byte nul = 0;
+            mp_print_bytes(print, &nul, 1);
+        }
     }
     for (uint i = 0; i < rc->data.u_byte.n_raw_code; ++i) {
-        save_raw_code(print, (mp_raw_code_t*)(uintptr_t)*const_table++);
+        save_raw_code(print, (mp_raw_code_t*)(uintptr_t)*const_table++, qstr_map);
     }
 }
 
@@ -370,9 +541,41 @@ void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print) {
         mp_small_int_bits(),
         #endif
     };
+
+    if (!MICROPY_PERSISTENT_CODE_XIP_DYNAMIC) {
+        mp_print_bytes(print, header, sizeof(header));
+        save_raw_code(print, rc, NULL);
+        return;
+    }
+
+    // The qstr table of an XIP file comes before the code, but it is only
+    // known once all the code is saved, so the code is buffered first.
+    header[2] |= MPY_FEATURE_XIP;
+    mp_map_t qstr_map;
+    mp_map_init(&qstr_map, 0);
+    vstr_t code;
+    mp_print_t code_print;
+    vstr_init_print(&code, 256, &code_print);
+    save_raw_code(&code_print, rc, &qstr_map);
+
+    size_t n_qstr = qstr_map.used;
+    qstr *qstr_table = m_new(qstr, n_qstr);
+    for (size_t i = 0; i < qstr_map.alloc; ++i) {
+        if (MP_MAP_SLOT_IS_FILLED(&qstr_map, i)) {
+            qstr_table[MP_OBJ_SMALL_INT_VALUE(qstr_map.table[i].value)] = MP_OBJ_QSTR_VALUE(qstr_map.table[i].key);
+        }
+    }
+
     mp_print_bytes(print, header, sizeof(header));
+    mp_print_uint(print, n_qstr);
+    for (size_t i = 0; i < n_qstr; ++i) {
+        save_qstr(print, qstr_table[i]);
+    }
+    mp_print_bytes(print, (const byte*)code.buf, code.len);
 
-    save_raw_code(print, rc);
+    m_del(qstr, qstr_table, n_qstr);
+    vstr_clear(&code);
+    mp_map_deinit(&qstr_map);
 }
 
 // here we define mp_raw_code_save_file depending on the port
@@ -81,7 +81,7 @@ ifeq ($(MICROPY_PY_BTREE),1)
 BTREE_DIR = lib/berkeley-db-1.xx
 BTREE_DEFS = -D__DBINTERFACE_PRIVATE=1 -Dmpool_error=printf -Dabort=abort_ -Dvirt_fd_t=mp_obj_t "-DVIRT_FD_T_HEADER=<py/obj.h>" $(BTREE_DEFS_EXTRA)
 INC += -I$(TOP)/$(BTREE_DIR)/PORT/include
-SRC_MOD += extmod/modbtree.c
+SRC_MOD += extmod/modbtree.c extmod/btree_mpool.c
 SRC_MOD += $(addprefix $(BTREE_DIR)/,\
 btree/bt_close.c \
 btree/bt_conv.c \
@@ -96,13 +96,12 @@ btree/bt_search.c \
 btree/bt_seq.c \
 btree/bt_split.c \
 btree/bt_utils.c \
-mpool/mpool.c \
 	)
 CFLAGS_MOD += -DMICROPY_PY_BTREE=1
 # we need to suppress certain warnings to get berkeley-db to compile cleanly
 # and we have separate BTREE_DEFS so the definitions don't interfere with other source code
 $(BUILD)/$(BTREE_DIR)/%.o: CFLAGS += -Wno-old-style-definition -Wno-sign-compare -Wno-unused-parameter $(BTREE_DEFS)
-$(BUILD)/extmod/modbtree.o: CFLAGS += $(BTREE_DEFS)
+$(BUILD)/extmod/modbtree.o $(BUILD)/extmod/btree_mpool.o: CFLAGS += $(BTREE_DEFS)
 endif
 
 # py object files
@@ -228,8 +227,10 @@ PY_EXTMOD_O_BASENAME = \
 	extmod/modujson.o \
 	extmod/modure.o \
 	extmod/moduzlib.o \
+	extmod/uzlib_deflate.o \
 	extmod/moduheapq.o \
 	extmod/modutimeq.o \
+	extmod/moduasyncio.o \
 	extmod/moduhashlib.o \
 	extmod/modubinascii.o \
 	extmod/virtpin.o \
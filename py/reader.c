@@ -47,6 +47,17 @@ STATIC mp_uint_t mp_reader_mem_readbyte(void *data) {
     }
 }
 
+STATIC const byte *mp_reader_mem_readptr(void *data, size_t len) {
+    mp_reader_mem_t *reader = (mp_reader_mem_t*)data;
+    // memory that is freed on close can't be referenced in place
+    if (reader->free_len > 0 || len > (size_t)(reader->end - reader->cur)) {
+        return NULL;
+    }
+    const byte *ptr = reader->cur;
+    reader->cur += len;
+    return ptr;
+}
+
 STATIC void mp_reader_mem_close(void *data) {
     mp_reader_mem_t *reader = (mp_reader_mem_t*)data;
     if (reader->free_len > 0) {
@@ -64,6 +75,7 @@ void mp_reader_new_mem(mp_reader_t *reader, const byte *buf, size_t len, size_t
     reader->data = rm;
     reader->readbyte = mp_reader_mem_readbyte;
     reader->close = mp_reader_mem_close;
+    reader->readptr = mp_reader_mem_readptr;
 }
 
 #if MICROPY_READER_POSIX
@@ -122,8 +134,73 @@ void mp_reader_new_file_from_fd(mp_reader_t *reader, int fd, bool close_fd) {
     reader->data = rp;
     reader->readbyte = mp_reader_posix_readbyte;
     reader->close = mp_reader_posix_close;
+    reader->readptr = NULL;
 }
 
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP && !MICROPY_VFS_POSIX
+
+#include <sys/mman.h>
+
+// Reads a whole file through a read-only memory mapping, so that execute-in-place
+// .mpy files can be loaded without copying their bytecode.
+typedef struct _mp_reader_mmap_t {
+    bool pinned; // set once data is referenced in place, the mapping is then kept
+    const byte *beg;
+    const byte *cur;
+    const byte *end;
+} mp_reader_mmap_t;
+
+STATIC mp_uint_t mp_reader_mmap_readbyte(void *data) {
+    mp_reader_mmap_t *reader = (mp_reader_mmap_t*)data;
+    if (reader->cur < reader->end) {
+        return *reader->cur++;
+    } else {
+        return MP_READER_EOF;
+    }
+}
+
+STATIC const byte *mp_reader_mmap_readptr(void *data, size_t len) {
+    mp_reader_mmap_t *reader = (mp_reader_mmap_t*)data;
+    if (len > (size_t)(reader->end - reader->cur)) {
+        return NULL;
+    }
+    const byte *ptr = reader->cur;
+    reader->cur += len;
+    reader->pinned = true;
+    return ptr;
+}
+
+STATIC void mp_reader_mmap_close(void *data) {
+    mp_reader_mmap_t *reader = (mp_reader_mmap_t*)data;
+    if (!reader->pinned) {
+        munmap((void*)reader->beg, reader->end - reader->beg);
+    }
+    m_del_obj(mp_reader_mmap_t, reader);
+}
+
+STATIC bool mp_reader_new_file_mmap(mp_reader_t *reader, int fd) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        return false;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+    mp_reader_mmap_t *rm = m_new_obj(mp_reader_mmap_t);
+    rm->pinned = false;
+    rm->beg = map;
+    rm->cur = map;
+    rm->end = rm->beg + st.st_size;
+    reader->data = rm;
+    reader->readbyte = mp_reader_mmap_readbyte;
+    reader->close = mp_reader_mmap_close;
+    reader->readptr = mp_reader_mmap_readptr;
+    return true;
+}
+
+#endif
+
 #if !MICROPY_VFS_POSIX
 // If MICROPY_VFS_POSIX is defined then this function is provided by the VFS layer
 void mp_reader_new_file(mp_reader_t *reader, const char *filename) {
@@ -131,6 +208,13 @@ void mp_reader_new_file(mp_reader_t *reader, const char *filename) {
     if (fd < 0) {
         mp_raise_OSError(errno);
     }
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    if (mp_reader_new_file_mmap(reader, fd)) {
+        // the mapping stays valid after the descriptor is closed
+        close(fd);
+        return;
+    }
+    #endif
     mp_reader_new_file_from_fd(reader, fd, true);
 }
 #endif
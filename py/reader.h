@@ -33,10 +33,14 @@
 // it can be called again after returning MP_READER_EOF, and in that case must return MP_READER_EOF
 #define MP_READER_EOF ((mp_uint_t)(-1))
 
+// the optional readptr function is for sources that are mapped into memory: it
+// must return a pointer to the next len bytes and advance past them, or return
+// NULL if it can't; the returned data must stay valid after the reader is closed
 typedef struct _mp_reader_t {
     void *data;
     mp_uint_t (*readbyte)(void *data);
     void (*close)(void *data);
+    const byte *(*readptr)(void *data, size_t len);
 } mp_reader_t;
 
 void mp_reader_new_mem(mp_reader_t *reader, const byte *buf, size_t len, size_t free_len);
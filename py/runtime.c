@@ -125,6 +125,10 @@ void mp_init(void) {
     MP_STATE_VM(dupterm_arr_obj) = MP_OBJ_NULL;
     #endif
 
+    #if MICROPY_PY_UASYNCIO
+    MP_STATE_VM(uasyncio_loop) = NULL;
+    #endif
+
     #ifdef MICROPY_FSUSERMOUNT
     // zero out the pointers to the user-mounted devices
     memset(MP_STATE_VM(fs_user_mount) + MICROPY_FATFS_NUM_PERSISTENT, 0,
@@ -156,6 +160,18 @@ void mp_init(void) {
     #endif
     #endif
 
+    #if MICROPY_VFS_IMPORT_STAT_CACHE
+    MP_STATE_VM(vfs_import_stat_cache) = MP_OBJ_NULL;
+    #endif
+
+    #if MICROPY_PY_BUILTINS_STR_UNICODE_INDEX_CACHE
+    MP_STATE_VM(str_index_cache).data = NULL;
+    MP_STATE_VM(str_index_cache).alloc = 0;
+    #endif
+    #if MICROPY_VFS && MICROPY_PY_MICROPYTHON_MEM_INFO
+    MP_STATE_VM(vfs_import_stat_count) = 0;
+    #endif
+
     #if MICROPY_PY_THREAD_GIL
     mp_thread_mutex_init(&MP_STATE_VM(gil_mutex));
     #endif
@@ -1596,7 +1612,7 @@ NORETURN void mp_raise_TypeError_varg(const compressed_string_t *fmt, ...) {
 }
 
 NORETURN void mp_raise_OSError(int errno_) {
-    nlr_raise(mp_obj_new_exception_arg1(&mp_type_OSError, MP_OBJ_NEW_SMALL_INT(errno_)));
+    nlr_raise(mp_obj_new_exception_errno(errno_));
 }
 
 NORETURN void mp_raise_OSError_msg(const compressed_string_t *msg) {
@@ -34,6 +34,7 @@
 #include "py/runtime.h"
 #include "py/bc0.h"
 #include "py/bc.h"
+#include "py/smallint.h"
 
 #if 0
 #define TRACE(ip) printf("sp=%d ", (int)(sp - &code_state->state[0] + 1)); mp_bytecode_print2(ip, 1, code_state->fun_bc->const_table);
@@ -41,6 +42,75 @@
 #define TRACE(ip)
 #endif
 
+#if MICROPY_OPT_VM_BINARY_OP_FAST_PATH
+// Inline versions of the most common binary ops on two small ints or two
+// floats, so they don't go through the full dispatch in mp_binary_op.
+// Returns MP_OBJ_NULL if the generic path must be taken, which includes any
+// small-int result that doesn't fit in a small int.
+static inline mp_obj_t vm_binary_op_fast(mp_uint_t op, mp_obj_t lhs, mp_obj_t rhs) {
+    if (MP_OBJ_IS_SMALL_INT(lhs) && MP_OBJ_IS_SMALL_INT(rhs)) {
+        mp_int_t lhs_val = MP_OBJ_SMALL_INT_VALUE(lhs);
+        mp_int_t rhs_val = MP_OBJ_SMALL_INT_VALUE(rhs);
+        switch (op) {
+            case MP_BINARY_OP_LESS: return mp_obj_new_bool(lhs_val < rhs_val);
+            case MP_BINARY_OP_MORE: return mp_obj_new_bool(lhs_val > rhs_val);
+            case MP_BINARY_OP_EQUAL: return mp_obj_new_bool(lhs_val == rhs_val);
+            case MP_BINARY_OP_LESS_EQUAL: return mp_obj_new_bool(lhs_val <= rhs_val);
+            case MP_BINARY_OP_MORE_EQUAL: return mp_obj_new_bool(lhs_val >= rhs_val);
+            case MP_BINARY_OP_NOT_EQUAL: return mp_obj_new_bool(lhs_val != rhs_val);
+            case MP_BINARY_OP_OR:
+            case MP_BINARY_OP_INPLACE_OR: return MP_OBJ_NEW_SMALL_INT(lhs_val | rhs_val);
+            case MP_BINARY_OP_XOR:
+            case MP_BINARY_OP_INPLACE_XOR: return MP_OBJ_NEW_SMALL_INT(lhs_val ^ rhs_val);
+            case MP_BINARY_OP_AND:
+            case MP_BINARY_OP_INPLACE_AND: return MP_OBJ_NEW_SMALL_INT(lhs_val & rhs_val);
+            case MP_BINARY_OP_LSHIFT:
+            case MP_BINARY_OP_INPLACE_LSHIFT:
+                if (rhs_val < 0 || rhs_val >= (mp_int_t)BITS_PER_WORD
+                    || lhs_val > (MP_SMALL_INT_MAX >> rhs_val) || lhs_val < (MP_SMALL_INT_MIN >> rhs_val)) {
+                    return MP_OBJ_NULL;
+                }
+                return MP_OBJ_NEW_SMALL_INT(lhs_val << rhs_val);
+            case MP_BINARY_OP_RSHIFT:
+            case MP_BINARY_OP_INPLACE_RSHIFT:
+                if (rhs_val < 0 || rhs_val >= (mp_int_t)BITS_PER_WORD) {
+                    return MP_OBJ_NULL;
+                }
+                return MP_OBJ_NEW_SMALL_INT(lhs_val >> rhs_val);
+            case MP_BINARY_OP_ADD:
+            case MP_BINARY_OP_INPLACE_ADD: lhs_val += rhs_val; break;
+            case MP_BINARY_OP_SUBTRACT:
+            case MP_BINARY_OP_INPLACE_SUBTRACT: lhs_val -= rhs_val; break;
+            default: return MP_OBJ_NULL;
+        }
+        if (!MP_SMALL_INT_FITS(lhs_val)) {
+            return MP_OBJ_NULL;
+        }
+        return MP_OBJ_NEW_SMALL_INT(lhs_val);
+    }
+    #if MICROPY_PY_BUILTINS_FLOAT
+    if (mp_obj_is_float(lhs) && mp_obj_is_float(rhs)) {
+        mp_float_t lhs_val = mp_obj_float_get(lhs);
+        mp_float_t rhs_val = mp_obj_float_get(rhs);
+        switch (op) {
+            case MP_BINARY_OP_LESS: return mp_obj_new_bool(lhs_val < rhs_val);
+            case MP_BINARY_OP_MORE: return mp_obj_new_bool(lhs_val > rhs_val);
+            case MP_BINARY_OP_LESS_EQUAL: return mp_obj_new_bool(lhs_val <= rhs_val);
+            case MP_BINARY_OP_MORE_EQUAL: return mp_obj_new_bool(lhs_val >= rhs_val);
+            case MP_BINARY_OP_ADD:
+            case MP_BINARY_OP_INPLACE_ADD: return mp_obj_new_float(lhs_val + rhs_val);
+            case MP_BINARY_OP_SUBTRACT:
+            case MP_BINARY_OP_INPLACE_SUBTRACT: return mp_obj_new_float(lhs_val - rhs_val);
+            case MP_BINARY_OP_MULTIPLY:
+            case MP_BINARY_OP_INPLACE_MULTIPLY: return mp_obj_new_float(lhs_val * rhs_val);
+            default: return MP_OBJ_NULL;
+        }
+    }
+    #endif
+    return MP_OBJ_NULL;
+}
+#endif
+
 // Value stack grows up (this makes it incompatible with native C stack, but
 // makes sure that arguments to functions are in natural order arg1..argN
 // (Python semantics mandates left-to-right evaluation order, including for
@@ -58,9 +128,24 @@
 
 #if MICROPY_PERSISTENT_CODE
 
+#if MICROPY_PERSISTENT_CODE_LOAD_XIP
+#define DECODE_QSTR \
+    qstr qst = ip[0] | ip[1] << 8; \
+    if (xip_qstr_table != NULL) { \
+        qst = xip_qstr_table[qst]; \
+    } \
+    ip += 2;
+// XIP bytecode may live in read-only memory so its map lookup cache is not updated
+#define STORE_MAP_CACHE_INDEX(idx) \
+    if (xip_qstr_table == NULL) { \
+        *(byte*)ip = (idx); \
+    }
+#else
 #define DECODE_QSTR \
     qstr qst = ip[0] | ip[1] << 8; \
     ip += 2;
+#define STORE_MAP_CACHE_INDEX(idx) *(byte*)ip = (idx)
+#endif
 #define DECODE_PTR \
     DECODE_UINT; \
     void *ptr = (void*)(uintptr_t)code_state->fun_bc->const_table[unum]
@@ -159,6 +244,9 @@ run_code_state: ;
         fastn = &code_state->state[n_state - 1];
         exc_stack = (mp_exc_stack_t*)(code_state->state + n_state);
     }
+    #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+    const uint16_t *xip_qstr_table = mp_bytecode_get_xip_qstr_table(code_state->fun_bc);
+    #endif
 
     // variables that are visible to the exception handler (declared volatile)
     volatile bool currently_in_except_block = MP_TAGPTR_TAG0(code_state->exc_sp); // 0 or 1, to detect nested exceptions
@@ -284,7 +372,7 @@ dispatch_loop:
                     } else {
                         mp_map_elem_t *elem = mp_map_lookup(&mp_locals_get()->map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
                         if (elem != NULL) {
-                            *(byte*)ip = (elem - &mp_locals_get()->map.table[0]) & 0xff;
+                            STORE_MAP_CACHE_INDEX((elem - &mp_locals_get()->map.table[0]) & 0xff);
                             PUSH(elem->value);
                         } else {
                             PUSH(mp_load_name(MP_OBJ_QSTR_VALUE(key)));
@@ -313,7 +401,7 @@ dispatch_loop:
                     } else {
                         mp_map_elem_t *elem = mp_map_lookup(&mp_globals_get()->map, MP_OBJ_NEW_QSTR(qst), MP_MAP_LOOKUP);
                         if (elem != NULL) {
-                            *(byte*)ip = (elem - &mp_globals_get()->map.table[0]) & 0xff;
+                            STORE_MAP_CACHE_INDEX((elem - &mp_globals_get()->map.table[0]) & 0xff);
                             PUSH(elem->value);
                         } else {
                             PUSH(mp_load_global(MP_OBJ_QSTR_VALUE(key)));
@@ -346,7 +434,7 @@ dispatch_loop:
                         } else {
                             elem = mp_map_lookup(&self->members, key, MP_MAP_LOOKUP);
                             if (elem != NULL) {
-                                *(byte*)ip = elem - &self->members.table[0];
+                                STORE_MAP_CACHE_INDEX(elem - &self->members.table[0]);
                             } else {
                                 goto load_attr_cache_fail;
                             }
@@ -444,7 +532,7 @@ dispatch_loop:
                         } else {
                             elem = mp_map_lookup(&self->members, key, MP_MAP_LOOKUP);
                             if (elem != NULL) {
-                                *(byte*)ip = elem - &self->members.table[0];
+                                STORE_MAP_CACHE_INDEX(elem - &self->members.table[0]);
                             } else {
                                 goto store_attr_cache_fail;
                             }
@@ -1253,7 +1341,15 @@ yield:
                     MARK_EXC_IP_SELECTIVE();
                     mp_obj_t rhs = POP();
                     mp_obj_t lhs = TOP();
+                    #if MICROPY_OPT_VM_BINARY_OP_FAST_PATH
+                    mp_obj_t res = vm_binary_op_fast(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs);
+                    if (res == MP_OBJ_NULL) {
+                        res = mp_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs);
+                    }
+                    SET_TOP(res);
+                    #else
                     SET_TOP(mp_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs));
+                    #endif
                     DISPATCH();
                 }
 
@@ -1276,7 +1372,15 @@ yield:
                     } else if (ip[-1] < MP_BC_BINARY_OP_MULTI + MP_BINARY_OP_NUM_BYTECODE) {
                         mp_obj_t rhs = POP();
                         mp_obj_t lhs = TOP();
+                        #if MICROPY_OPT_VM_BINARY_OP_FAST_PATH
+                        mp_obj_t res = vm_binary_op_fast(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs);
+                        if (res == MP_OBJ_NULL) {
+                            res = mp_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs);
+                        }
+                        SET_TOP(res);
+                        #else
                         SET_TOP(mp_binary_op(ip[-1] - MP_BC_BINARY_OP_MULTI, lhs, rhs));
+                        #endif
                         DISPATCH();
                     } else
 #endif
@@ -1396,6 +1500,12 @@ unwind_loop:
                 qstr block_name = ip[0] | (ip[1] << 8);
                 qstr source_file = ip[2] | (ip[3] << 8);
                 ip += 4;
+                #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+                if (xip_qstr_table != NULL) {
+                    block_name = xip_qstr_table[block_name];
+                    source_file = xip_qstr_table[source_file];
+                }
+                #endif
                 #else
                 qstr block_name = mp_decode_uint_value(ip);
                 ip = mp_decode_uint_skip(ip);
@@ -1468,6 +1578,9 @@ unwind_loop:
                 size_t n_state = mp_decode_uint_value(code_state->fun_bc->bytecode);
                 fastn = &code_state->state[n_state - 1];
                 exc_stack = (mp_exc_stack_t*)(code_state->state + n_state);
+                #if MICROPY_PERSISTENT_CODE_LOAD_XIP
+                xip_qstr_table = mp_bytecode_get_xip_qstr_table(code_state->fun_bc);
+                #endif
                 // variables that are visible to the exception handler (declared volatile)
                 currently_in_except_block = MP_TAGPTR_TAG0(code_state->exc_sp); // 0 or 1, to detect nested exceptions
                 exc_sp = MP_TAGPTR_PTR(code_state->exc_sp); // stack grows up, exc_sp points to top of stack
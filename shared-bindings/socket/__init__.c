@@ -270,6 +270,45 @@ STATIC mp_obj_t socket_recv(mp_obj_t self_in, mp_obj_t len_in) {
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(socket_recv_obj, socket_recv);
 
+//| .. method:: recv_into(buffer, bufsize=0)
+//|
+//|   Reads some bytes from the connected remote address into ``buffer``
+//|   without allocating. Suits sockets of type SOCK_STREAM
+//|   Returns the number of bytes read
+//|
+//|   :param bytearray buffer: buffer to receive into
+//|   :param int bufsize: maximum number of bytes to receive, or 0 for ``len(buffer)``
+
+STATIC mp_obj_t socket_recv_into(size_t n_args, const mp_obj_t *args) {
+    mod_network_socket_obj_t *self = MP_OBJ_TO_PTR(args[0]);
+    if (self->nic == MP_OBJ_NULL) {
+        // not connected
+        mp_raise_OSError(MP_ENOTCONN);
+    }
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(args[1], &bufinfo, MP_BUFFER_WRITE);
+    mp_int_t len = bufinfo.len;
+    if (n_args > 2) {
+        mp_int_t given_len = mp_obj_get_int(args[2]);
+        if (given_len < 0) {
+            mp_raise_ValueError(NULL);
+        }
+        if (given_len > 0 && given_len < len) {
+            len = given_len;
+        }
+    }
+    if (len == 0) {
+        return MP_OBJ_NEW_SMALL_INT(0);
+    }
+    int _errno;
+    mp_int_t ret = self->nic_type->recv(self, (byte*)bufinfo.buf, len, &_errno);
+    if (ret == -1) {
+        mp_raise_OSError(_errno);
+    }
+    return MP_OBJ_NEW_SMALL_INT(ret);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(socket_recv_into_obj, 2, 3, socket_recv_into);
+
 //| .. method:: sendto(bytes, address)
 //|
 //|   Send some bytes to a specific address.
@@ -434,6 +473,7 @@ STATIC const mp_rom_map_elem_t socket_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_connect), MP_ROM_PTR(&socket_connect_obj) },
     { MP_ROM_QSTR(MP_QSTR_send), MP_ROM_PTR(&socket_send_obj) },
     { MP_ROM_QSTR(MP_QSTR_recv), MP_ROM_PTR(&socket_recv_obj) },
+    { MP_ROM_QSTR(MP_QSTR_recv_into), MP_ROM_PTR(&socket_recv_into_obj) },
     { MP_ROM_QSTR(MP_QSTR_sendto), MP_ROM_PTR(&socket_sendto_obj) },
     { MP_ROM_QSTR(MP_QSTR_recvfrom), MP_ROM_PTR(&socket_recvfrom_obj) },
     { MP_ROM_QSTR(MP_QSTR_setsockopt), MP_ROM_PTR(&socket_setsockopt_obj) },
@@ -101,10 +101,29 @@ const mp_obj_property_t supervisor_serial_bytes_available_obj = {
               (mp_obj_t)&mp_const_none_obj},
 };
 
+//|     .. attribute:: runtime.serial_bytes_dropped
+//|
+//|         Returns the number of bytes of serial output that were dropped
+//|         because the host stopped reading while the output buffer was
+//|         full. (read-only)
+//|
+STATIC mp_obj_t supervisor_get_serial_bytes_dropped(mp_obj_t self){
+    return mp_obj_new_int_from_uint(common_hal_get_serial_bytes_dropped());
+}
+MP_DEFINE_CONST_FUN_OBJ_1(supervisor_get_serial_bytes_dropped_obj, supervisor_get_serial_bytes_dropped);
+
+const mp_obj_property_t supervisor_serial_bytes_dropped_obj = {
+    .base.type = &mp_type_property,
+    .proxy = {(mp_obj_t)&supervisor_get_serial_bytes_dropped_obj,
+              (mp_obj_t)&mp_const_none_obj,
+              (mp_obj_t)&mp_const_none_obj},
+};
+
 
 STATIC const mp_rom_map_elem_t supervisor_runtime_locals_dict_table[] = {
     { MP_ROM_QSTR(MP_QSTR_serial_connected), MP_ROM_PTR(&supervisor_serial_connected_obj) },
     { MP_ROM_QSTR(MP_QSTR_serial_bytes_available), MP_ROM_PTR(&supervisor_serial_bytes_available_obj) },
+    { MP_ROM_QSTR(MP_QSTR_serial_bytes_dropped), MP_ROM_PTR(&supervisor_serial_bytes_dropped_obj) },
 };
 
 STATIC MP_DEFINE_CONST_DICT(supervisor_runtime_locals_dict, supervisor_runtime_locals_dict_table);
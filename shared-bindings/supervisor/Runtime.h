@@ -37,6 +37,8 @@ bool common_hal_get_serial_connected(void);
 
 bool common_hal_get_serial_bytes_available(void);
 
+uint32_t common_hal_get_serial_bytes_dropped(void);
+
 //TODO: placeholders for future functions
 //bool common_hal_get_repl_active(void);
 //bool common_hal_get_usb_enumerated(void);
@@ -166,7 +166,7 @@ void audioio_wavefile_reset_buffer(audioio_wavefile_obj_t* self,
     // We don't reset the buffer index in case we're looping and we have an odd number of buffer
     // loads
     self->bytes_remaining = self->file_length;
-    f_lseek(&self->file->fp, self->data_start);
+    fat_file_seek(self->file, self->data_start);
     self->read_count = 0;
     self->left_read_count = 0;
     self->right_read_count = 0;
@@ -82,7 +82,7 @@ uint32_t common_hal_displayio_ondiskbitmap_get_pixel(displayio_ondiskbitmap_t *s
     }
     uint32_t location = self->data_offset + (self->height - y) * self->stride + x * self->bytes_per_pixel;
     // We don't cache here because the underlying FS caches sectors.
-    f_lseek(&self->file->fp, location);
+    fat_file_seek(self->file, location);
     UINT bytes_read;
     uint32_t pixel = 0;
     uint32_t result = f_read(&self->file->fp, &pixel, self->bytes_per_pixel, &bytes_read);
@@ -50,6 +50,12 @@ supervisor_allocation* allocate_remaining_memory(void);
 // statically allocated memory.
 supervisor_allocation* allocate_memory(uint32_t length, bool high_address);
 
+typedef void (*allocation_moved_cb_t)(supervisor_allocation* allocation);
+
+// Allocate a piece that may be moved to make room for other allocations. After a move its contents
+// are at the new allocation->ptr and moved is called so the owner can update any pointers into it.
+supervisor_allocation* allocate_movable_memory(uint32_t length, allocation_moved_cb_t moved);
+
 static inline uint16_t align32_size(uint16_t size) {
     if (size % 4 != 0) {
         return (size & 0xfffc) + 0x4;
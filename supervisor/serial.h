@@ -45,5 +45,9 @@ void serial_write_substring(const char* text, uint32_t length);
 char serial_read(void);
 bool serial_bytes_available(void);
 bool serial_connected(void);
+// Number of output bytes dropped because the host wasn't reading.
+uint32_t serial_write_dropped(void);
+// Hands buffered output to USB. Called by usb_background.
+void serial_write_background(void);
 
 #endif  // MICROPY_INCLUDED_SUPERVISOR_SERIAL_H
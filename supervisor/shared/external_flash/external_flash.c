@@ -34,27 +34,60 @@
 #include "extmod/vfs_fat.h"
 #include "py/misc.h"
 #include "py/obj.h"
+#include "py/mphal.h"
 #include "py/runtime.h"
 #include "lib/oofatfs/ff.h"
 #include "shared-bindings/microcontroller/__init__.h"
 #include "supervisor/memory.h"
 #include "supervisor/shared/rgb_led_status.h"
 
+#ifdef EXTERNAL_FLASH_FTL
+#include "supervisor/shared/external_flash/ftl.h"
+#endif
+
 #define NO_SECTOR_LOADED 0xFFFFFFFF
 
-// The currently cached sector in the cache, ram or flash based.
-static uint32_t current_sector;
+#define BLOCKS_PER_SECTOR (SPI_FLASH_ERASE_SIZE / FILESYSTEM_BLOCK_SIZE)
+#define PAGES_PER_BLOCK (FILESYSTEM_BLOCK_SIZE / SPI_FLASH_PAGE_SIZE)
+#define PAGES_PER_SECTOR (SPI_FLASH_ERASE_SIZE / SPI_FLASH_PAGE_SIZE)
+#define ALL_BLOCKS_MASK ((uint32_t) ((1ULL << BLOCKS_PER_SECTOR) - 1))
+
+// An erase sector held in the cache. When the cache is in ram the pages of line
+// i are MP_STATE_VM(flash_ram_cache)[i * PAGES_PER_SECTOR] onwards. When ram is
+// tight only line 0 is used, and its dirty blocks are staged in the scratch
+// sector at the end of the flash instead.
+typedef struct {
+    // Address of the cached sector, or NO_SECTOR_LOADED.
+    uint32_t sector;
+    // Blocks (up to 32) written since the sector was last flushed.
+    uint32_t dirty_mask;
+    // Blocks whose copy in ram is up to date, including the dirty ones.
+    uint32_t valid_mask;
+    // Value of use_counter when the line was last used, for LRU replacement.
+    uint32_t last_used;
+} cache_line_t;
+
+static cache_line_t cache_lines[EXTERNAL_FLASH_CACHE_SECTORS];
+
+// Number of lines the current ram cache has room for.
+static uint8_t cache_line_count;
+static uint32_t use_counter;
+static uint32_t last_write_ms;
+
+static external_flash_stats_t stats;
 
 const external_flash_device possible_devices[EXTERNAL_FLASH_DEVICE_COUNT] = {EXTERNAL_FLASH_DEVICES};
 
 static const external_flash_device* flash_device = NULL;
 
-// Track which blocks (up to 32) in the current sector currently live in the
-// cache.
-static uint32_t dirty_mask;
-
 static supervisor_allocation* supervisor_cache = NULL;
 
+#ifdef EXTERNAL_FLASH_FTL
+// False when the translation layer couldn't start, in which case blocks are
+// mapped directly as without it rather than presenting an empty disk.
+static bool use_ftl = false;
+#endif
+
 // Wait until both the write enable and write in progress bits have cleared.
 static bool wait_for_flash_ready(void) {
     uint8_t read_status_response[1] = {0x00};
@@ -113,6 +146,7 @@ static bool write_flash(uint32_t address, const uint8_t* data, uint32_t data_len
                                   SPI_FLASH_PAGE_SIZE)) {
             return false;
         }
+        stats.page_writes++;
     }
     return true;
 }
@@ -135,7 +169,7 @@ static bool page_erased(uint32_t sector_address) {
     uint8_t full_buffer[FILESYSTEM_BLOCK_SIZE];
     if (read_flash(sector_address, full_buffer, FILESYSTEM_BLOCK_SIZE)) {
         for (uint16_t i = 0; i < FILESYSTEM_BLOCK_SIZE; i++) {
-            if (short_buffer[i] != 0xff) {
+            if (full_buffer[i] != 0xff) {
                 return false;
             }
         }
@@ -155,6 +189,7 @@ static bool erase_sector(uint32_t sector_address) {
     }
 
     spi_flash_sector_command(CMD_SECTOR_ERASE, sector_address);
+    stats.erases++;
     return true;
 }
 
@@ -252,9 +287,15 @@ void supervisor_flash_init(void) {
 
     wait_for_flash_ready();
 
-    current_sector = NO_SECTOR_LOADED;
-    dirty_mask = 0;
+    for (uint8_t i = 0; i < EXTERNAL_FLASH_CACHE_SECTORS; i++) {
+        cache_lines[i].sector = NO_SECTOR_LOADED;
+    }
+    cache_line_count = 0;
     MP_STATE_VM(flash_ram_cache) = NULL;
+
+#ifdef EXTERNAL_FLASH_FTL
+    use_ftl = ftl_init(flash_device->total_size);
+#endif
 }
 
 // The size of each individual block.
@@ -264,6 +305,11 @@ uint32_t supervisor_flash_get_block_size(void) {
 
 // The total number of available blocks.
 uint32_t supervisor_flash_get_block_count(void) {
+#ifdef EXTERNAL_FLASH_FTL
+    if (use_ftl) {
+        return ftl_get_block_count();
+    }
+#endif
     // We subtract one erase sector size because we may use it as a staging area
     // for writes.
     return (flash_device->total_size - SPI_FLASH_ERASE_SIZE) / FILESYSTEM_BLOCK_SIZE;
@@ -272,14 +318,15 @@ uint32_t supervisor_flash_get_block_count(void) {
 // Flush the cache that was written to the scratch portion of flash. Only used
 // when ram is tight.
 static bool flush_scratch_flash(void) {
+    cache_line_t* line = &cache_lines[0];
     // First, copy out any blocks that we haven't touched from the sector we've
     // cached.
     bool copy_to_scratch_ok = true;
     uint32_t scratch_sector = flash_device->total_size - SPI_FLASH_ERASE_SIZE;
-    for (uint8_t i = 0; i < SPI_FLASH_ERASE_SIZE / FILESYSTEM_BLOCK_SIZE; i++) {
-        if ((dirty_mask & (1 << i)) == 0) {
+    for (uint8_t i = 0; i < BLOCKS_PER_SECTOR; i++) {
+        if ((line->dirty_mask & (1 << i)) == 0) {
             copy_to_scratch_ok = copy_to_scratch_ok &&
-                copy_block(current_sector + i * FILESYSTEM_BLOCK_SIZE,
+                copy_block(line->sector + i * FILESYSTEM_BLOCK_SIZE,
                            scratch_sector + i * FILESYSTEM_BLOCK_SIZE);
         }
     }
@@ -289,151 +336,236 @@ static bool flush_scratch_flash(void) {
         return false;
     }
     // Second, erase the current sector.
-    erase_sector(current_sector);
+    erase_sector(line->sector);
     // Finally, copy the new version into it.
-    for (uint8_t i = 0; i < SPI_FLASH_ERASE_SIZE / FILESYSTEM_BLOCK_SIZE; i++) {
+    for (uint8_t i = 0; i < BLOCKS_PER_SECTOR; i++) {
         copy_block(scratch_sector + i * FILESYSTEM_BLOCK_SIZE,
-                   current_sector + i * FILESYSTEM_BLOCK_SIZE);
+                   line->sector + i * FILESYSTEM_BLOCK_SIZE);
     }
     return true;
 }
 
-// Attempts to allocate a new set of page buffers for caching a full sector in
-// ram. Each page is allocated separately so that the GC doesn't need to provide
-// one huge block. We can free it as we write if we want to also.
-static bool allocate_ram_cache(void) {
-    uint8_t blocks_per_sector = SPI_FLASH_ERASE_SIZE / FILESYSTEM_BLOCK_SIZE;
-    uint8_t pages_per_block = FILESYSTEM_BLOCK_SIZE / SPI_FLASH_PAGE_SIZE;
+// Attempts to allocate page buffers for caching sectors in ram. Outside the
+// heap we take as many of the EXTERNAL_FLASH_CACHE_SECTORS sectors as fit. On
+// the heap we only take one sector, and each page is allocated separately so
+// that the GC doesn't need to provide one huge block.
+// Point the page table at the pages that follow it in the supervisor cache.
+// Also called when the supervisor moves the cache.
+static void place_supervisor_cache(supervisor_allocation* allocation) {
+    uint32_t table_size = cache_line_count * PAGES_PER_SECTOR * sizeof(uint8_t*);
+    MP_STATE_VM(flash_ram_cache) = (uint8_t **) allocation->ptr;
+    uint8_t* page_start = (uint8_t *) allocation->ptr + table_size;
+    for (uint32_t i = 0; i < cache_line_count * PAGES_PER_SECTOR; i++) {
+        MP_STATE_VM(flash_ram_cache)[i] = page_start + i * SPI_FLASH_PAGE_SIZE;
+    }
+}
 
-    uint32_t table_size = blocks_per_sector * pages_per_block * sizeof(uint32_t);
-    // Attempt to allocate outside the heap first.
-    supervisor_cache = allocate_memory(table_size + SPI_FLASH_ERASE_SIZE, false);
-    if (supervisor_cache != NULL) {
-        MP_STATE_VM(flash_ram_cache) = (uint8_t **) supervisor_cache->ptr;
-        uint8_t* page_start = (uint8_t *) supervisor_cache->ptr + table_size;
+// Mark every line of a new ram cache empty.
+static void clear_cache_lines(void) {
+    for (uint8_t i = 0; i < cache_line_count; i++) {
+        cache_lines[i].sector = NO_SECTOR_LOADED;
+        cache_lines[i].dirty_mask = 0;
+        cache_lines[i].valid_mask = 0;
+    }
+}
 
-        for (uint8_t i = 0; i < blocks_per_sector; i++) {
-            for (uint8_t j = 0; j < pages_per_block; j++) {
-                uint32_t offset = i * pages_per_block + j;
-                MP_STATE_VM(flash_ram_cache)[offset] = page_start + offset * SPI_FLASH_PAGE_SIZE;
-            }
+static bool allocate_ram_cache(void) {
+    for (uint8_t lines = EXTERNAL_FLASH_CACHE_SECTORS; lines > 0; lines--) {
+        uint32_t table_size = lines * PAGES_PER_SECTOR * sizeof(uint8_t*);
+        supervisor_cache = allocate_movable_memory(table_size + lines * SPI_FLASH_ERASE_SIZE,
+                                                   place_supervisor_cache);
+        if (supervisor_cache != NULL) {
+            cache_line_count = lines;
+            place_supervisor_cache(supervisor_cache);
+            clear_cache_lines();
+            return true;
         }
-        return true;
     }
 
-    MP_STATE_VM(flash_ram_cache) = m_malloc_maybe(blocks_per_sector * pages_per_block * sizeof(uint32_t), false);
+    MP_STATE_VM(flash_ram_cache) = m_malloc_maybe(PAGES_PER_SECTOR * sizeof(uint8_t*), false);
     if (MP_STATE_VM(flash_ram_cache) == NULL) {
         return false;
     }
-    // Declare i and j outside the loops in case we fail to allocate everything
-    // we need. In that case we'll give it back.
+    // Declare i outside the loop in case we fail to allocate everything we
+    // need. In that case we'll give it back.
     uint8_t i = 0;
-    uint8_t j = 0;
-    bool success = true;
-    for (i = 0; i < blocks_per_sector; i++) {
-        for (j = 0; j < pages_per_block; j++) {
-            uint8_t *page_cache = m_malloc_maybe(SPI_FLASH_PAGE_SIZE, false);
-            if (page_cache == NULL) {
-                success = false;
-                break;
-            }
-            MP_STATE_VM(flash_ram_cache)[i * pages_per_block + j] = page_cache;
-        }
-        if (!success) {
+    for (i = 0; i < PAGES_PER_SECTOR; i++) {
+        uint8_t *page_cache = m_malloc_maybe(SPI_FLASH_PAGE_SIZE, false);
+        if (page_cache == NULL) {
             break;
         }
+        MP_STATE_VM(flash_ram_cache)[i] = page_cache;
     }
     // We couldn't allocate enough so give back what we got.
-    if (!success) {
-        // We add 1 so that we delete 0 when i is 1. Going to zero (i >= 0)
-        // would never stop because i is unsigned.
-        i++;
+    if (i < PAGES_PER_SECTOR) {
         for (; i > 0; i--) {
-            for (; j > 0; j--) {
-                m_free(MP_STATE_VM(flash_ram_cache)[(i - 1) * pages_per_block + (j - 1)]);
-            }
-            j = pages_per_block;
+            m_free(MP_STATE_VM(flash_ram_cache)[i - 1]);
         }
         m_free(MP_STATE_VM(flash_ram_cache));
         MP_STATE_VM(flash_ram_cache) = NULL;
+        return false;
     }
-    return success;
-}
-
-// Flush the cached sector from ram onto the flash. We'll free the cache unless
-// keep_cache is true.
-static bool flush_ram_cache(bool keep_cache) {
-    // First, copy out any blocks that we haven't touched from the sector
-    // we've cached. If we don't do this we'll erase the data during the sector
-    // erase below.
-    bool copy_to_ram_ok = true;
-    uint8_t pages_per_block = FILESYSTEM_BLOCK_SIZE / SPI_FLASH_PAGE_SIZE;
-    for (uint8_t i = 0; i < SPI_FLASH_ERASE_SIZE / FILESYSTEM_BLOCK_SIZE; i++) {
-        if ((dirty_mask & (1 << i)) == 0) {
-            for (uint8_t j = 0; j < pages_per_block; j++) {
-                copy_to_ram_ok = read_flash(
-                    current_sector + (i * pages_per_block + j) * SPI_FLASH_PAGE_SIZE,
-                    MP_STATE_VM(flash_ram_cache)[i * pages_per_block + j],
-                    SPI_FLASH_PAGE_SIZE);
-                if (!copy_to_ram_ok) {
-                    break;
-                }
-            }
+    cache_line_count = 1;
+    clear_cache_lines();
+    return true;
+}
+
+static void free_ram_cache(void) {
+    if (supervisor_cache != NULL) {
+        free_memory(supervisor_cache);
+        supervisor_cache = NULL;
+    } else {
+        for (uint8_t i = 0; i < PAGES_PER_SECTOR; i++) {
+            m_free(MP_STATE_VM(flash_ram_cache)[i]);
         }
-        if (!copy_to_ram_ok) {
-            break;
+        m_free(MP_STATE_VM(flash_ram_cache));
+    }
+    MP_STATE_VM(flash_ram_cache) = NULL;
+    for (uint8_t i = 0; i < cache_line_count; i++) {
+        cache_lines[i].sector = NO_SECTOR_LOADED;
+    }
+    cache_line_count = 0;
+}
+
+static inline uint8_t* cache_page(uint8_t line, uint8_t page) {
+    return MP_STATE_VM(flash_ram_cache)[line * PAGES_PER_SECTOR + page];
+}
+
+// Returns the ram cache line holding sector, or -1.
+static int8_t find_line(uint32_t sector) {
+    for (uint8_t i = 0; i < cache_line_count; i++) {
+        if (cache_lines[i].sector == sector) {
+            cache_lines[i].last_used = ++use_counter;
+            return i;
         }
     }
+    return -1;
+}
 
-    if (!copy_to_ram_ok) {
-        return false;
+static void show_write_activity(bool active) {
+    #ifdef MICROPY_HW_LED_MSC
+        port_pin_set_output_level(MICROPY_HW_LED_MSC, active);
+    #endif
+    if (active) {
+        temp_status_color(ACTIVE_WRITE);
+    } else {
+        clear_temp_status();
     }
-    // Second, erase the current sector.
-    erase_sector(current_sector);
-    // Lastly, write all the data in ram that we've cached.
-    for (uint8_t i = 0; i < SPI_FLASH_ERASE_SIZE / FILESYSTEM_BLOCK_SIZE; i++) {
-        for (uint8_t j = 0; j < pages_per_block; j++) {
-            write_flash(current_sector + (i * pages_per_block + j) * SPI_FLASH_PAGE_SIZE,
-                        MP_STATE_VM(flash_ram_cache)[i * pages_per_block + j],
-                        SPI_FLASH_PAGE_SIZE);
-            if (!keep_cache && supervisor_cache == NULL) {
-                m_free(MP_STATE_VM(flash_ram_cache)[i * pages_per_block + j]);
+}
+
+// Read the blocks of a cached sector that aren't in ram yet.
+static bool fill_line(uint8_t line) {
+    cache_line_t* l = &cache_lines[line];
+    for (uint8_t page = 0; page < PAGES_PER_SECTOR; page++) {
+        if ((l->valid_mask & (1 << (page / PAGES_PER_BLOCK))) == 0 &&
+            !read_flash(l->sector + page * SPI_FLASH_PAGE_SIZE, cache_page(line, page), SPI_FLASH_PAGE_SIZE)) {
+            return false;
+        }
+    }
+    l->valid_mask = ALL_BLOCKS_MASK;
+    return true;
+}
+
+// Write the dirty blocks of a cached sector back to the flash. Programming can
+// only clear bits, so the sector is only erased when a changed page needs a bit
+// set. Otherwise just the changed pages are programmed, which saves an erase
+// whenever data lands on erased flash or a block is rewritten unchanged.
+static bool flush_line(uint8_t line) {
+    cache_line_t* l = &cache_lines[line];
+    if (l->dirty_mask == 0) {
+        return true;
+    }
+    uint32_t changed_pages = 0;
+    bool needs_erase = false;
+    uint8_t buffer[SPI_FLASH_PAGE_SIZE];
+    for (uint8_t page = 0; page < PAGES_PER_SECTOR && !needs_erase; page++) {
+        if ((l->dirty_mask & (1 << (page / PAGES_PER_BLOCK))) == 0) {
+            continue;
+        }
+        if (!read_flash(l->sector + page * SPI_FLASH_PAGE_SIZE, buffer, SPI_FLASH_PAGE_SIZE)) {
+            return false;
+        }
+        const uint8_t* cached = cache_page(line, page);
+        if (memcmp(buffer, cached, SPI_FLASH_PAGE_SIZE) == 0) {
+            continue;
+        }
+        changed_pages |= 1 << page;
+        for (uint16_t i = 0; i < SPI_FLASH_PAGE_SIZE; i++) {
+            if ((buffer[i] & cached[i]) != cached[i]) {
+                needs_erase = true;
+                break;
             }
         }
     }
-    // We're done with the cache for now so give it back.
-    if (!keep_cache) {
-        if (supervisor_cache != NULL) {
-            free_memory(supervisor_cache);
-            supervisor_cache = NULL;
-        } else {
-            m_free(MP_STATE_VM(flash_ram_cache));
+
+    if (needs_erase) {
+        // Copy out any blocks that we haven't touched from the sector. If we
+        // don't do this we'll erase the data during the sector erase below.
+        if (!fill_line(line)) {
+            return false;
+        }
+        erase_sector(l->sector);
+        // write_flash skips pages that are all 1s.
+        changed_pages = (uint32_t) ((1ULL << PAGES_PER_SECTOR) - 1);
+    }
+    for (uint8_t page = 0; page < PAGES_PER_SECTOR; page++) {
+        if ((changed_pages & (1 << page)) != 0) {
+            write_flash(l->sector + page * SPI_FLASH_PAGE_SIZE, cache_page(line, page), SPI_FLASH_PAGE_SIZE);
         }
-        MP_STATE_VM(flash_ram_cache) = NULL;
     }
+    l->dirty_mask = 0;
     return true;
 }
 
-// Delegates to the correct flash flush method depending on the existing cache.
+// Pick a ram cache line for sector, writing back the least recently used one
+// if every line is taken.
+static uint8_t claim_line(uint32_t sector) {
+    uint8_t victim = 0;
+    for (uint8_t i = 0; i < cache_line_count; i++) {
+        if (cache_lines[i].sector == NO_SECTOR_LOADED) {
+            victim = i;
+            break;
+        }
+        if (cache_lines[i].last_used < cache_lines[victim].last_used) {
+            victim = i;
+        }
+    }
+    if (cache_lines[victim].sector != NO_SECTOR_LOADED && cache_lines[victim].dirty_mask != 0) {
+        show_write_activity(true);
+        flush_line(victim);
+        show_write_activity(false);
+    }
+    cache_lines[victim].sector = sector;
+    cache_lines[victim].dirty_mask = 0;
+    cache_lines[victim].valid_mask = 0;
+    cache_lines[victim].last_used = ++use_counter;
+    return victim;
+}
+
+// Write back every dirty sector, from the scratch sector or ram depending on
+// the cache in use. The ram cache is freed unless keep_cache is true.
 static void spi_flash_flush_keep_cache(bool keep_cache) {
-    if (current_sector == NO_SECTOR_LOADED) {
-        return;
+    bool dirty = false;
+    for (uint8_t i = 0; i < EXTERNAL_FLASH_CACHE_SECTORS; i++) {
+        if (cache_lines[i].sector != NO_SECTOR_LOADED && cache_lines[i].dirty_mask != 0) {
+            dirty = true;
+        }
     }
-    #ifdef MICROPY_HW_LED_MSC
-        port_pin_set_output_level(MICROPY_HW_LED_MSC, true);
-    #endif
-    temp_status_color(ACTIVE_WRITE);
-    // If we've cached to the flash itself flush from there.
-    if (MP_STATE_VM(flash_ram_cache) == NULL) {
-        flush_scratch_flash();
-    } else {
-        flush_ram_cache(keep_cache);
+    if (dirty) {
+        show_write_activity(true);
+        if (MP_STATE_VM(flash_ram_cache) == NULL) {
+            flush_scratch_flash();
+            cache_lines[0].sector = NO_SECTOR_LOADED;
+        } else {
+            for (uint8_t i = 0; i < cache_line_count; i++) {
+                flush_line(i);
+            }
+        }
+        show_write_activity(false);
+    }
+    if (!keep_cache && MP_STATE_VM(flash_ram_cache) != NULL) {
+        free_ram_cache();
     }
-    current_sector = NO_SECTOR_LOADED;
-    clear_temp_status();
-    #ifdef MICROPY_HW_LED_MSC
-        port_pin_set_output_level(MICROPY_HW_LED_MSC, false);
-    #endif
 }
 
 // External flash function used. If called externally we assume we won't need
@@ -442,6 +574,54 @@ void supervisor_flash_flush(void) {
     spi_flash_flush_keep_cache(false);
 }
 
+// Write back dirty sectors once writes have stopped for a while, keeping them
+// cached for reads.
+void external_flash_background(void) {
+    if ((uint32_t) (mp_hal_ticks_ms() - last_write_ms) >= EXTERNAL_FLASH_IDLE_FLUSH_MS) {
+        spi_flash_flush_keep_cache(true);
+    }
+}
+
+external_flash_stats_t external_flash_get_stats(void) {
+    return stats;
+}
+
+#ifdef EXTERNAL_FLASH_FTL
+// Raw access for the flash translation layer, which bypasses the sector cache.
+bool external_flash_read(uint32_t address, uint8_t* data, uint32_t data_length) {
+    return read_flash(address, data, data_length);
+}
+
+// Program already erased flash. Unlike write_flash, the data doesn't need to
+// be page sized or aligned.
+bool external_flash_program(uint32_t address, const uint8_t* data, uint32_t data_length) {
+    if (flash_device == NULL) {
+        return false;
+    }
+    while (data_length > 0) {
+        uint32_t chunk = SPI_FLASH_PAGE_SIZE - address % SPI_FLASH_PAGE_SIZE;
+        if (chunk > data_length) {
+            chunk = data_length;
+        }
+        if (!wait_for_flash_ready() || !write_enable()) {
+            return false;
+        }
+        if (!spi_flash_write_data(address, (uint8_t*) data, chunk)) {
+            return false;
+        }
+        stats.page_writes++;
+        address += chunk;
+        data += chunk;
+        data_length -= chunk;
+    }
+    return true;
+}
+
+bool external_flash_erase_sector(uint32_t sector_address) {
+    return erase_sector(sector_address);
+}
+#endif
+
 static int32_t convert_block_to_flash_addr(uint32_t block) {
     if (0 <= block && block < supervisor_flash_get_block_count()) {
         // a block in partition 1
@@ -452,6 +632,11 @@ static int32_t convert_block_to_flash_addr(uint32_t block) {
 }
 
 bool external_flash_read_block(uint8_t *dest, uint32_t block) {
+#ifdef EXTERNAL_FLASH_FTL
+    if (use_ftl) {
+        return ftl_read_block(dest, block);
+    }
+#endif
     int32_t address = convert_block_to_flash_addr(block);
     if (address == -1) {
         // bad block number
@@ -460,71 +645,93 @@ bool external_flash_read_block(uint8_t *dest, uint32_t block) {
 
     // Mask out the lower bits that designate the address within the sector.
     uint32_t this_sector = address & (~(SPI_FLASH_ERASE_SIZE - 1));
-    uint8_t block_index = (address / FILESYSTEM_BLOCK_SIZE) % (SPI_FLASH_ERASE_SIZE / FILESYSTEM_BLOCK_SIZE);
-    uint8_t mask = 1 << (block_index);
-    // We're reading from the currently cached sector.
-    if (current_sector == this_sector && (mask & dirty_mask) > 0) {
-        if (MP_STATE_VM(flash_ram_cache) != NULL) {
-            uint8_t pages_per_block = FILESYSTEM_BLOCK_SIZE / SPI_FLASH_PAGE_SIZE;
-            for (int i = 0; i < pages_per_block; i++) {
+    uint8_t block_index = (address / FILESYSTEM_BLOCK_SIZE) % BLOCKS_PER_SECTOR;
+    uint32_t mask = 1 << (block_index);
+    if (MP_STATE_VM(flash_ram_cache) != NULL) {
+        int8_t line = find_line(this_sector);
+        if (line >= 0 && (cache_lines[line].valid_mask & mask) != 0) {
+            for (int i = 0; i < PAGES_PER_BLOCK; i++) {
                 memcpy(dest + i * SPI_FLASH_PAGE_SIZE,
-                       MP_STATE_VM(flash_ram_cache)[block_index * pages_per_block + i],
+                       cache_page(line, block_index * PAGES_PER_BLOCK + i),
                        SPI_FLASH_PAGE_SIZE);
             }
             return true;
-        } else {
-            uint32_t scratch_address = flash_device->total_size - SPI_FLASH_ERASE_SIZE + block_index * FILESYSTEM_BLOCK_SIZE;
-            return read_flash(scratch_address, dest, FILESYSTEM_BLOCK_SIZE);
         }
+    } else if (cache_lines[0].sector == this_sector && (mask & cache_lines[0].dirty_mask) != 0) {
+        uint32_t scratch_address = flash_device->total_size - SPI_FLASH_ERASE_SIZE + block_index * FILESYSTEM_BLOCK_SIZE;
+        return read_flash(scratch_address, dest, FILESYSTEM_BLOCK_SIZE);
     }
     return read_flash(address, dest, FILESYSTEM_BLOCK_SIZE);
 }
 
 bool external_flash_write_block(const uint8_t *data, uint32_t block) {
+#ifdef EXTERNAL_FLASH_FTL
+    if (use_ftl) {
+        return ftl_write_block(data, block);
+    }
+#endif
     // Non-MBR block, copy to cache
     int32_t address = convert_block_to_flash_addr(block);
     if (address == -1) {
         // bad block number
         return false;
     }
+    stats.block_writes++;
+    last_write_ms = mp_hal_ticks_ms();
     // Wait for any previous writes to finish.
     wait_for_flash_ready();
     // Mask out the lower bits that designate the address within the sector.
     uint32_t this_sector = address & (~(SPI_FLASH_ERASE_SIZE - 1));
-    uint8_t block_index = (address / FILESYSTEM_BLOCK_SIZE) % (SPI_FLASH_ERASE_SIZE / FILESYSTEM_BLOCK_SIZE);
-    uint8_t mask = 1 << (block_index);
-    // Flush the cache if we're moving onto a sector or we're writing the
-    // same block again.
-    if (current_sector != this_sector || (mask & dirty_mask) > 0) {
+    uint8_t block_index = (address / FILESYSTEM_BLOCK_SIZE) % BLOCKS_PER_SECTOR;
+    uint32_t mask = 1 << (block_index);
+    uint32_t scratch_address = flash_device->total_size - SPI_FLASH_ERASE_SIZE + block_index * FILESYSTEM_BLOCK_SIZE;
+
+    int8_t line = -1;
+    if (MP_STATE_VM(flash_ram_cache) != NULL) {
+        line = find_line(this_sector);
+    } else if (cache_lines[0].sector == this_sector) {
+        // The scratch sector can take each block only once before a flush.
+        if ((mask & cache_lines[0].dirty_mask) == 0) {
+            cache_lines[0].dirty_mask |= mask;
+            return write_flash(scratch_address, data, FILESYSTEM_BLOCK_SIZE);
+        }
+        spi_flash_flush_keep_cache(true);
+    }
+
+    if (line < 0) {
         // Check to see if we'd write to an erased page. In that case we
         // can write directly.
         if (page_erased(address)) {
             return write_flash(address, data, FILESYSTEM_BLOCK_SIZE);
         }
-        if (current_sector != NO_SECTOR_LOADED) {
-            spi_flash_flush_keep_cache(true);
-        }
-        if (MP_STATE_VM(flash_ram_cache) == NULL && !allocate_ram_cache()) {
-            erase_sector(flash_device->total_size - SPI_FLASH_ERASE_SIZE);
-            wait_for_flash_ready();
+        if (MP_STATE_VM(flash_ram_cache) == NULL) {
+            // Blocks staged in the scratch sector exist only there, so write
+            // them back before line 0 is reused by either kind of cache.
+            if (cache_lines[0].sector != NO_SECTOR_LOADED) {
+                spi_flash_flush_keep_cache(true);
+            }
+            if (!allocate_ram_cache()) {
+                // Stage the sector's blocks in the scratch sector instead.
+                erase_sector(flash_device->total_size - SPI_FLASH_ERASE_SIZE);
+                wait_for_flash_ready();
+                cache_lines[0].sector = this_sector;
+                cache_lines[0].dirty_mask = mask;
+                return write_flash(scratch_address, data, FILESYSTEM_BLOCK_SIZE);
+            }
         }
-        current_sector = this_sector;
-        dirty_mask = 0;
+        line = claim_line(this_sector);
     }
-    dirty_mask |= mask;
-    // Copy the block to the appropriate cache.
-    if (MP_STATE_VM(flash_ram_cache) != NULL) {
-        uint8_t pages_per_block = FILESYSTEM_BLOCK_SIZE / SPI_FLASH_PAGE_SIZE;
-        for (int i = 0; i < pages_per_block; i++) {
-            memcpy(MP_STATE_VM(flash_ram_cache)[block_index * pages_per_block + i],
-                   data + i * SPI_FLASH_PAGE_SIZE,
-                   SPI_FLASH_PAGE_SIZE);
-        }
-        return true;
-    } else {
-        uint32_t scratch_address = flash_device->total_size - SPI_FLASH_ERASE_SIZE + block_index * FILESYSTEM_BLOCK_SIZE;
-        return write_flash(scratch_address, data, FILESYSTEM_BLOCK_SIZE);
+
+    // Copy the block into the ram cache. Rewrites of a cached block just
+    // replace it, so they don't cost an erase.
+    for (int i = 0; i < PAGES_PER_BLOCK; i++) {
+        memcpy(cache_page(line, block_index * PAGES_PER_BLOCK + i),
+               data + i * SPI_FLASH_PAGE_SIZE,
+               SPI_FLASH_PAGE_SIZE);
     }
+    cache_lines[line].dirty_mask |= mask;
+    cache_lines[line].valid_mask |= mask;
+    return true;
 }
 
 mp_uint_t supervisor_flash_read_blocks(uint8_t *dest, uint32_t block_num, uint32_t num_blocks) {
@@ -45,4 +45,25 @@
 #define SPI_FLASH_MAX_BAUDRATE 8000000
 #endif
 
+// Number of erase sectors to cache in ram when writing. Only one is taken from
+// the VM heap when there isn't room for the cache outside it.
+#ifndef EXTERNAL_FLASH_CACHE_SECTORS
+#define EXTERNAL_FLASH_CACHE_SECTORS (4)
+#endif
+
+// Dirty cached sectors are written back once there have been no writes for
+// this long.
+#ifndef EXTERNAL_FLASH_IDLE_FLUSH_MS
+#define EXTERNAL_FLASH_IDLE_FLUSH_MS (1000)
+#endif
+
+typedef struct {
+    uint32_t block_writes; // blocks written by the filesystem or USB
+    uint32_t page_writes;  // pages programmed on the flash
+    uint32_t erases;       // sectors erased
+} external_flash_stats_t;
+
+void external_flash_background(void);
+external_flash_stats_t external_flash_get_stats(void);
+
 #endif  // MICROPY_INCLUDED_SUPERVISOR_SHARED_EXTERNAL_FLASH_EXTERNAL_FLASH_H
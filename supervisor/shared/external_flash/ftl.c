@@ -0,0 +1,338 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "supervisor/shared/external_flash/ftl.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "py/mpconfig.h"
+#include "supervisor/memory.h"
+#include "supervisor/shared/external_flash/external_flash.h"
+
+#define FTL_MAGIC 0x4c544643 // "CFTL"
+
+#define SLOTS_PER_SECTOR (SPI_FLASH_ERASE_SIZE / FILESYSTEM_BLOCK_SIZE - 1)
+#define NO_SECTOR 0xffffffff
+#define UNMAPPED 0xffff
+#define UNWRITTEN 0xffffffff
+
+typedef struct {
+    uint32_t magic;
+    uint32_t erase_count;
+    // Order in which sectors were filled, UNWRITTEN until the sector is used.
+    uint32_t sequence;
+    // Filesystem block held by each slot, UNWRITTEN while the slot is free.
+    uint32_t blocks[SLOTS_PER_SECTOR];
+} ftl_header_t;
+
+// Sectors without a valid header are free but must be erased before use.
+enum {
+    SECTOR_UNFORMATTED,
+    SECTOR_FREE,
+    SECTOR_USED,
+};
+
+static uint32_t sector_count;
+static uint32_t block_count;
+
+// Slot (sector * SLOTS_PER_SECTOR + index) holding the latest copy of each
+// block, or UNMAPPED if it has never been written.
+static uint16_t* block_map;
+static uint32_t* erase_counts;
+static uint8_t* valid_counts;
+static uint8_t* sector_states;
+
+// Number of sectors that aren't SECTOR_USED.
+static uint32_t free_sectors;
+static uint32_t active_sector = NO_SECTOR;
+static uint8_t active_slot;
+static uint32_t next_sequence;
+static uint32_t collections;
+
+static inline uint32_t align4(uint32_t size) {
+    return (size + 3) & ~3;
+}
+
+static inline uint32_t slot_address(uint32_t slot) {
+    return (slot / SLOTS_PER_SECTOR) * SPI_FLASH_ERASE_SIZE +
+        (slot % SLOTS_PER_SECTOR + 1) * FILESYSTEM_BLOCK_SIZE;
+}
+
+static inline uint32_t erase_counts_size(void) {
+    return sector_count * sizeof(uint32_t);
+}
+
+static inline uint32_t map_size(void) {
+    return align4(block_count * sizeof(uint16_t));
+}
+
+static inline uint32_t counts_size(void) {
+    return align4(sector_count);
+}
+
+// Carve the tables out of one supervisor allocation. Also called when the
+// supervisor moves it.
+static void place_tables(supervisor_allocation* allocation) {
+    uint8_t* memory = (uint8_t*) allocation->ptr;
+    erase_counts = (uint32_t*) memory;
+    block_map = (uint16_t*) (memory + erase_counts_size());
+    valid_counts = memory + erase_counts_size() + map_size();
+    sector_states = valid_counts + counts_size();
+}
+
+static uint32_t read_sequence(uint32_t sector) {
+    uint32_t sequence = UNWRITTEN;
+    external_flash_read(sector * SPI_FLASH_ERASE_SIZE + offsetof(ftl_header_t, sequence),
+                        (uint8_t*) &sequence, sizeof(sequence));
+    return sequence;
+}
+
+// Rebuild the block map from the sector headers. Sectors are filled in
+// sequence order and slots in index order, so the newest copy of a block wins.
+bool ftl_init(uint32_t flash_size) {
+    if (block_map != NULL) {
+        return true;
+    }
+    sector_count = flash_size / SPI_FLASH_ERASE_SIZE;
+    // Slot numbers must fit in the 16 bit map.
+    if (sector_count * SLOTS_PER_SECTOR >= UNMAPPED) {
+        sector_count = (UNMAPPED - 1) / SLOTS_PER_SECTOR;
+    }
+    uint32_t spare = FTL_RESERVED_SECTORS + sector_count / FTL_SPARE_SECTOR_DIVISOR;
+    if (sector_count <= spare) {
+        return false;
+    }
+    block_count = (sector_count - spare) * SLOTS_PER_SECTOR;
+
+    supervisor_allocation* allocation = allocate_movable_memory(erase_counts_size() + map_size() +
+                                                                2 * counts_size(), place_tables);
+    if (allocation == NULL) {
+        block_count = 0;
+        return false;
+    }
+    place_tables(allocation);
+    memset(block_map, 0xff, block_count * sizeof(uint16_t));
+    memset(valid_counts, 0, sector_count);
+
+    free_sectors = 0;
+    next_sequence = 0;
+    for (uint32_t sector = 0; sector < sector_count; sector++) {
+        ftl_header_t header;
+        external_flash_read(sector * SPI_FLASH_ERASE_SIZE, (uint8_t*) &header, sizeof(header));
+        if (header.magic != FTL_MAGIC) {
+            sector_states[sector] = SECTOR_UNFORMATTED;
+            erase_counts[sector] = 0;
+            free_sectors++;
+            continue;
+        }
+        erase_counts[sector] = header.erase_count;
+        if (header.sequence == UNWRITTEN) {
+            sector_states[sector] = SECTOR_FREE;
+            free_sectors++;
+            continue;
+        }
+        sector_states[sector] = SECTOR_USED;
+        if (header.sequence >= next_sequence) {
+            next_sequence = header.sequence + 1;
+        }
+        for (uint8_t i = 0; i < SLOTS_PER_SECTOR; i++) {
+            uint32_t block = header.blocks[i];
+            if (block >= block_count) {
+                continue;
+            }
+            uint16_t current = block_map[block];
+            if (current == UNMAPPED || current / SLOTS_PER_SECTOR == sector ||
+                read_sequence(current / SLOTS_PER_SECTOR) < header.sequence) {
+                block_map[block] = sector * SLOTS_PER_SECTOR + i;
+            }
+        }
+    }
+    for (uint32_t block = 0; block < block_count; block++) {
+        if (block_map[block] != UNMAPPED) {
+            valid_counts[block_map[block] / SLOTS_PER_SECTOR]++;
+        }
+    }
+    // A partly filled sector from before isn't resumed because a slot may
+    // have been programmed without its header entry.
+    active_sector = NO_SECTOR;
+    return true;
+}
+
+uint32_t ftl_get_block_count(void) {
+    return block_count;
+}
+
+bool ftl_read_block(uint8_t* dest, uint32_t block) {
+    if (block >= block_count) {
+        return false;
+    }
+    uint16_t slot = block_map[block];
+    if (slot == UNMAPPED) {
+        memset(dest, 0xff, FILESYSTEM_BLOCK_SIZE);
+        return true;
+    }
+    return external_flash_read(slot_address(slot), dest, FILESYSTEM_BLOCK_SIZE);
+}
+
+// Erase a sector and write a header carrying its erase count.
+static bool format_sector(uint32_t sector) {
+    erase_counts[sector]++;
+    if (!external_flash_erase_sector(sector * SPI_FLASH_ERASE_SIZE)) {
+        return false;
+    }
+    uint32_t header[2] = {FTL_MAGIC, erase_counts[sector]};
+    if (!external_flash_program(sector * SPI_FLASH_ERASE_SIZE, (uint8_t*) header, sizeof(header))) {
+        return false;
+    }
+    sector_states[sector] = SECTOR_FREE;
+    return true;
+}
+
+// Start filling the least erased free sector.
+static bool open_sector(void) {
+    uint32_t best = NO_SECTOR;
+    for (uint32_t sector = 0; sector < sector_count; sector++) {
+        if (sector_states[sector] != SECTOR_USED &&
+            (best == NO_SECTOR || erase_counts[sector] < erase_counts[best])) {
+            best = sector;
+        }
+    }
+    if (best == NO_SECTOR) {
+        return false;
+    }
+    if (sector_states[best] == SECTOR_UNFORMATTED && !format_sector(best)) {
+        return false;
+    }
+    uint32_t sequence = next_sequence++;
+    if (!external_flash_program(best * SPI_FLASH_ERASE_SIZE + offsetof(ftl_header_t, sequence),
+                                (uint8_t*) &sequence, sizeof(sequence))) {
+        return false;
+    }
+    sector_states[best] = SECTOR_USED;
+    free_sectors--;
+    active_sector = best;
+    active_slot = 0;
+    return true;
+}
+
+// Write a block to the next free slot. The data goes first so that a slot is
+// only claimed by the header once its contents are complete.
+static bool append_block(const uint8_t* data, uint32_t block) {
+    if (active_sector == NO_SECTOR || active_slot == SLOTS_PER_SECTOR) {
+        if (!open_sector()) {
+            return false;
+        }
+    }
+    uint16_t slot = active_sector * SLOTS_PER_SECTOR + active_slot;
+    uint32_t header_address = active_sector * SPI_FLASH_ERASE_SIZE +
+        offsetof(ftl_header_t, blocks) + active_slot * sizeof(uint32_t);
+    active_slot++;
+    if (!external_flash_program(slot_address(slot), data, FILESYSTEM_BLOCK_SIZE) ||
+        !external_flash_program(header_address, (uint8_t*) &block, sizeof(block))) {
+        return false;
+    }
+    if (block_map[block] != UNMAPPED) {
+        valid_counts[block_map[block] / SLOTS_PER_SECTOR]--;
+    }
+    block_map[block] = slot;
+    valid_counts[active_sector]++;
+    return true;
+}
+
+// Free up a sector by moving its live blocks to the active sector. The victim
+// is normally the sector with the fewest live blocks. buffer must hold a block.
+static bool collect_sector(uint8_t* buffer) {
+    uint32_t victim = NO_SECTOR;
+    uint32_t coldest = NO_SECTOR;
+    uint32_t max_erase_count = 0;
+    for (uint32_t sector = 0; sector < sector_count; sector++) {
+        if (erase_counts[sector] > max_erase_count) {
+            max_erase_count = erase_counts[sector];
+        }
+        if (sector_states[sector] != SECTOR_USED || sector == active_sector) {
+            continue;
+        }
+        if (victim == NO_SECTOR || valid_counts[sector] < valid_counts[victim] ||
+            (valid_counts[sector] == valid_counts[victim] && erase_counts[sector] < erase_counts[victim])) {
+            victim = sector;
+        }
+        if (coldest == NO_SECTOR || erase_counts[sector] < erase_counts[coldest]) {
+            coldest = sector;
+        }
+    }
+    if (victim == NO_SECTOR) {
+        return false;
+    }
+    collections++;
+    if (collections % FTL_WEAR_LEVEL_INTERVAL == 0 &&
+        max_erase_count - erase_counts[coldest] > FTL_WEAR_LEVEL_THRESHOLD) {
+        victim = coldest;
+    } else if (valid_counts[victim] == SLOTS_PER_SECTOR) {
+        // Nothing to gain.
+        return false;
+    }
+
+    ftl_header_t header;
+    if (!external_flash_read(victim * SPI_FLASH_ERASE_SIZE, (uint8_t*) &header, sizeof(header))) {
+        return false;
+    }
+    for (uint8_t i = 0; i < SLOTS_PER_SECTOR && valid_counts[victim] > 0; i++) {
+        uint32_t block = header.blocks[i];
+        if (block >= block_count || block_map[block] != victim * SLOTS_PER_SECTOR + i) {
+            continue;
+        }
+        if (!external_flash_read(slot_address(block_map[block]), buffer, FILESYSTEM_BLOCK_SIZE) ||
+            !append_block(buffer, block)) {
+            return false;
+        }
+    }
+    if (!format_sector(victim)) {
+        return false;
+    }
+    free_sectors++;
+    return true;
+}
+
+bool ftl_write_block(const uint8_t* data, uint32_t block) {
+    uint8_t buffer[FILESYSTEM_BLOCK_SIZE];
+    // FatFs rewrites FAT and directory blocks unchanged fairly often. Those
+    // writes don't need a new slot.
+    if (!ftl_read_block(buffer, block)) {
+        return false;
+    }
+    if (memcmp(buffer, data, FILESYSTEM_BLOCK_SIZE) == 0) {
+        return true;
+    }
+    if (active_sector == NO_SECTOR || active_slot == SLOTS_PER_SECTOR) {
+        while (free_sectors <= FTL_RESERVED_SECTORS) {
+            if (!collect_sector(buffer)) {
+                return false;
+            }
+        }
+    }
+    return append_block(data, block);
+}
@@ -0,0 +1,83 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2026 agent
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MICROPY_INCLUDED_SUPERVISOR_SHARED_EXTERNAL_FLASH_FTL_H
+#define MICROPY_INCLUDED_SUPERVISOR_SHARED_EXTERNAL_FLASH_FTL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A flash translation layer for the external flash filesystem. Blocks are
+// never rewritten in place. Each write is appended to the sector currently
+// being filled, and a table in ram maps filesystem blocks to where their
+// latest copy lives. Sectors whose blocks have mostly been superseded are
+// garbage collected, and sectors are picked so that erases are spread evenly.
+//
+// Each erase sector has a header in its first block, followed by
+// SPI_FLASH_ERASE_SIZE / FILESYSTEM_BLOCK_SIZE - 1 block slots. The header
+// records which filesystem block each slot holds, so the map can be rebuilt
+// when the flash is initialized.
+//
+// A board opts in with EXTERNAL_FLASH_FTL = 1 in mpconfigboard.mk, which
+// changes the on-flash layout and so needs the filesystem reformatted. No
+// board does yet; tests/supervisor/external_flash runs it on the host.
+
+// Erased sectors kept back so garbage collection always has room to move
+// blocks into.
+#ifndef FTL_RESERVED_SECTORS
+#define FTL_RESERVED_SECTORS (2)
+#endif
+
+// One in this many sectors is held back as spare space in addition to the
+// reserved ones. More spare space means less copying during garbage
+// collection.
+#ifndef FTL_SPARE_SECTOR_DIVISOR
+#define FTL_SPARE_SECTOR_DIVISOR (16)
+#endif
+
+// Every FTL_WEAR_LEVEL_INTERVAL garbage collections, the least erased sector
+// holding data is collected instead when its erase count is more than
+// FTL_WEAR_LEVEL_THRESHOLD below the most erased sector. This moves data that
+// is never rewritten off sectors that would otherwise never be erased.
+#ifndef FTL_WEAR_LEVEL_INTERVAL
+#define FTL_WEAR_LEVEL_INTERVAL (32)
+#endif
+#ifndef FTL_WEAR_LEVEL_THRESHOLD
+#define FTL_WEAR_LEVEL_THRESHOLD (16)
+#endif
+
+// Returns false if the flash is too small or there's no memory for the tables,
+// in which case the flash is used without the translation layer.
+bool ftl_init(uint32_t flash_size);
+uint32_t ftl_get_block_count(void);
+bool ftl_read_block(uint8_t* dest, uint32_t block);
+bool ftl_write_block(const uint8_t* data, uint32_t block);
+
+// Raw flash access, provided by external_flash.c.
+bool external_flash_read(uint32_t address, uint8_t* data, uint32_t data_length);
+bool external_flash_program(uint32_t address, const uint8_t* data, uint32_t data_length);
+bool external_flash_erase_sector(uint32_t sector_address);
+
+#endif  // MICROPY_INCLUDED_SUPERVISOR_SHARED_EXTERNAL_FLASH_FTL_H
@@ -27,11 +27,19 @@
 #include "supervisor/memory.h"
 
 #include <stddef.h>
+#include <string.h>
 
+#ifndef CIRCUITPY_SUPERVISOR_ALLOC_COUNT
 #define CIRCUITPY_SUPERVISOR_ALLOC_COUNT 8
+#endif
 
+// Free memory is every gap between the live allocations, so neighbouring free
+// pieces are always merged and a freed allocation can be reused right away
+// wherever it was.
 static supervisor_allocation allocations[CIRCUITPY_SUPERVISOR_ALLOC_COUNT];
-// We use uint32_t* to ensure word (4 byte) alignment.
+// NULL for allocations that must stay where they are.
+static allocation_moved_cb_t moved_callbacks[CIRCUITPY_SUPERVISOR_ALLOC_COUNT];
+// Bounds of the memory we manage. We use uint32_t* to ensure word (4 byte) alignment.
 uint32_t* low_address;
 uint32_t* high_address;
 extern uint32_t _ebss;
@@ -43,59 +51,103 @@ void memory_init(void) {
 }
 
 void free_memory(supervisor_allocation* allocation) {
-    int32_t index = 0;
-    bool found = false;
-    for (index = 0; index < CIRCUITPY_SUPERVISOR_ALLOC_COUNT; index++) {
-        found = allocation == &allocations[index];
-        if (found) {
-            break;
-        }
-    }
-    if (!found) {
+    int32_t index = allocation - allocations;
+    if (index < 0 || index >= CIRCUITPY_SUPERVISOR_ALLOC_COUNT) {
         // Bad!
         // TODO(tannewt): Add a way to escape into safe mode on error.
+        return;
     }
-    if (allocation->ptr == high_address) {
-        high_address += allocation->length / 4;
-        for (index++; index < CIRCUITPY_SUPERVISOR_ALLOC_COUNT; index++) {
-            if (allocations[index].ptr != NULL) {
-                break;
-            }
-            high_address += allocations[index].length / 4;
+    allocation->ptr = NULL;
+    moved_callbacks[index] = NULL;
+}
+
+// Fill order with the live allocations sorted by address and return how many there are.
+static uint8_t sort_allocations(supervisor_allocation** order) {
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < CIRCUITPY_SUPERVISOR_ALLOC_COUNT; i++) {
+        if (allocations[i].ptr == NULL) {
+            continue;
         }
-    } else if (allocation->ptr + allocation->length / 4 == low_address) {
-        low_address = allocation->ptr;
-        for (index--; index >= 0; index--) {
-            if (allocations[index].ptr != NULL) {
-                break;
-            }
-            low_address -= allocations[index].length / 4;
+        uint8_t j = count;
+        while (j > 0 && order[j - 1]->ptr > allocations[i].ptr) {
+            order[j] = order[j - 1];
+            j--;
         }
-    } else {
-        // Freed memory isn't in the middle so skip updating bounds. The memory will be added to the
-        // middle when the memory to the inside is freed.
+        order[j] = &allocations[i];
+        count++;
     }
-    allocation->ptr = NULL;
+    return count;
 }
 
-supervisor_allocation* allocate_remaining_memory(void) {
-    if (low_address == high_address) {
-        return NULL;
+// Slide movable allocations down against their lower neighbour so that free
+// space gathers into fewer, larger gaps.
+static void compact(void) {
+    supervisor_allocation* order[CIRCUITPY_SUPERVISOR_ALLOC_COUNT];
+    uint8_t count = sort_allocations(order);
+    uint32_t* free_start = low_address;
+    for (uint8_t i = 0; i < count; i++) {
+        supervisor_allocation* alloc = order[i];
+        allocation_moved_cb_t moved = moved_callbacks[alloc - allocations];
+        if (moved != NULL && alloc->ptr != free_start) {
+            memmove(free_start, alloc->ptr, alloc->length);
+            alloc->ptr = free_start;
+            moved(alloc);
+        }
+        free_start = alloc->ptr + alloc->length / 4;
     }
-    return allocate_memory((high_address - low_address) * 4, false);
 }
 
-supervisor_allocation* allocate_memory(uint32_t length, bool high) {
-    if ((high_address - low_address) * 4 < (int32_t) length || length % 4 != 0) {
-        return NULL;
+// Find room for length bytes. Low allocations take the smallest gap that fits
+// to keep large gaps intact. High allocations are stacked down from the end of
+// ram, so the stack stays against it, and only fit in the gap just below the
+// allocations already there. A length of 0 picks the largest gap and sets
+// length to its size.
+static uint32_t* find_gap(uint32_t* length, bool high) {
+    supervisor_allocation* order[CIRCUITPY_SUPERVISOR_ALLOC_COUNT];
+    uint8_t count = sort_allocations(order);
+    if (high && *length != 0) {
+        uint32_t* gap_end = high_address;
+        while (count > 0 && order[count - 1]->ptr + order[count - 1]->length / 4 == gap_end) {
+            count--;
+            gap_end = order[count]->ptr;
+        }
+        uint32_t* gap_start = count > 0 ? order[count - 1]->ptr + order[count - 1]->length / 4 : low_address;
+        if ((uint32_t) (gap_end - gap_start) * 4 < *length) {
+            return NULL;
+        }
+        return gap_end - *length / 4;
+    }
+    uint32_t* best = NULL;
+    uint32_t best_size = 0;
+    uint32_t* gap_start = low_address;
+    for (uint8_t i = 0; i <= count; i++) {
+        uint32_t* gap_end = i < count ? order[i]->ptr : high_address;
+        uint32_t gap_size = (gap_end - gap_start) * 4;
+        if (*length == 0) {
+            if (gap_size > best_size) {
+                best = gap_start;
+                best_size = gap_size;
+            }
+        } else if (gap_size >= *length && (best == NULL || gap_size < best_size)) {
+            best = gap_start;
+            best_size = gap_size;
+        }
+        if (i < count) {
+            gap_start = order[i]->ptr + order[i]->length / 4;
+        }
     }
-    uint8_t index = 0;
-    int8_t direction = 1;
-    if (high) {
-        index = CIRCUITPY_SUPERVISOR_ALLOC_COUNT - 1;
-        direction = -1;
+    if (*length == 0) {
+        *length = best_size;
     }
-    for (; index < CIRCUITPY_SUPERVISOR_ALLOC_COUNT; index += direction) {
+    return best;
+}
+
+static supervisor_allocation* allocate(uint32_t length, bool high, allocation_moved_cb_t moved) {
+    if (length % 4 != 0) {
+        return NULL;
+    }
+    uint8_t index;
+    for (index = 0; index < CIRCUITPY_SUPERVISOR_ALLOC_COUNT; index++) {
         if (allocations[index].ptr == NULL) {
             break;
         }
@@ -103,14 +155,37 @@ supervisor_allocation* allocate_memory(uint32_t length, bool high) {
     if (index >= CIRCUITPY_SUPERVISOR_ALLOC_COUNT) {
         return NULL;
     }
-    supervisor_allocation* alloc = &allocations[index];
-    if (high) {
-        high_address -= length / 4;
-        alloc->ptr = high_address;
-    } else {
-        alloc->ptr = low_address;
-        low_address += length / 4;
+    uint32_t* ptr = find_gap(&length, high);
+    if (ptr == NULL) {
+        // The space may be there but split up.
+        compact();
+        ptr = find_gap(&length, high);
     }
+    if (ptr == NULL || length == 0) {
+        return NULL;
+    }
+    supervisor_allocation* alloc = &allocations[index];
+    alloc->ptr = ptr;
     alloc->length = length;
+    moved_callbacks[index] = moved;
     return alloc;
 }
+
+supervisor_allocation* allocate_remaining_memory(void) {
+    compact();
+    return allocate(0, false, NULL);
+}
+
+supervisor_allocation* allocate_memory(uint32_t length, bool high) {
+    if (length == 0) {
+        return NULL;
+    }
+    return allocate(length, high, NULL);
+}
+
+supervisor_allocation* allocate_movable_memory(uint32_t length, allocation_moved_cb_t moved) {
+    if (length == 0) {
+        return NULL;
+    }
+    return allocate(length, false, moved);
+}
@@ -29,9 +29,39 @@
 #include "supervisor/serial.h"
 #include "supervisor/usb.h"
 
+#include "tick.h"
 #include "tusb.h"
 
+// Serial output is collected here and handed to USB from the background task
+// so that print() doesn't wait for the host unless this is full.
+#ifndef CIRCUITPY_SERIAL_TX_BUFFER_SIZE
+#define CIRCUITPY_SERIAL_TX_BUFFER_SIZE (1024)
+#endif
+
+// How long a write waits for the host to make room in a full buffer. After
+// that output is dropped without waiting until the host reads again.
+#ifndef CIRCUITPY_SERIAL_TX_TIMEOUT_MS
+#define CIRCUITPY_SERIAL_TX_TIMEOUT_MS (100)
+#endif
+
+// Whether to drop the oldest buffered output to make room for new output
+// rather than dropping the new output.
+#ifndef CIRCUITPY_SERIAL_TX_DROP_OLDEST
+#define CIRCUITPY_SERIAL_TX_DROP_OLDEST (0)
+#endif
+
+static uint8_t tx_buffer[CIRCUITPY_SERIAL_TX_BUFFER_SIZE];
+static uint32_t tx_start;
+static uint32_t tx_count;
+static uint32_t tx_dropped;
+// True once the host has stopped reading and writes no longer wait.
+static bool tx_stalled;
+static uint64_t tx_flushed_ms;
+
 void serial_init(void) {
+    tx_start = 0;
+    tx_count = 0;
+    tx_stalled = false;
     usb_init();
 }
 
@@ -47,15 +77,95 @@ bool serial_bytes_available(void) {
     return tud_cdc_available() > 0;
 }
 
+// Move as much buffered output as USB will take. Returns true if the USB
+// buffer is full.
+static bool move_to_usb(void) {
+    while (tx_count > 0) {
+        uint32_t length = tx_count;
+        if (tx_start + length > CIRCUITPY_SERIAL_TX_BUFFER_SIZE) {
+            length = CIRCUITPY_SERIAL_TX_BUFFER_SIZE - tx_start;
+        }
+        uint32_t written = tud_cdc_write(tx_buffer + tx_start, length);
+        tx_start = (tx_start + written) % CIRCUITPY_SERIAL_TX_BUFFER_SIZE;
+        tx_count -= written;
+        if (written > 0) {
+            tx_stalled = false;
+        }
+        if (written < length) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void serial_write_background(void) {
+    bool usb_full = move_to_usb();
+    // Send once per USB frame so short writes are batched into full packets,
+    // unless there is more waiting than fits.
+    uint64_t ms;
+    uint32_t us_until_ms;
+    current_tick(&ms, &us_until_ms);
+    if (usb_full || ms != tx_flushed_ms) {
+        tud_cdc_write_flush();
+        tx_flushed_ms = ms;
+    }
+}
+
+// Wait for the host to make room in the buffer. Returns false if it doesn't.
+static bool wait_for_room(void) {
+    uint64_t start_ms;
+    uint32_t us_until_ms;
+    current_tick(&start_ms, &us_until_ms);
+    uint64_t now_ms = start_ms;
+    while (now_ms - start_ms < CIRCUITPY_SERIAL_TX_TIMEOUT_MS) {
+        usb_background();
+        if (tx_count < CIRCUITPY_SERIAL_TX_BUFFER_SIZE) {
+            return true;
+        }
+        current_tick(&now_ms, &us_until_ms);
+    }
+    return false;
+}
+
 void serial_write_substring(const char* text, uint32_t length) {
     if (!tud_cdc_connected()) {
         return;
     }
-    uint32_t count = 0;
-    while (count < length) {
-        count += tud_cdc_write(text + count, length - count);
-        usb_background();
+    while (length > 0) {
+        if (tx_count == CIRCUITPY_SERIAL_TX_BUFFER_SIZE) {
+            if (!tx_stalled && !wait_for_room()) {
+                tx_stalled = true;
+            }
+            if (tx_stalled) {
+                #if CIRCUITPY_SERIAL_TX_DROP_OLDEST
+                uint32_t drop = length < tx_count ? length : tx_count;
+                tx_start = (tx_start + drop) % CIRCUITPY_SERIAL_TX_BUFFER_SIZE;
+                tx_count -= drop;
+                tx_dropped += drop;
+                #else
+                tx_dropped += length;
+                return;
+                #endif
+            }
+        }
+        uint32_t end = (tx_start + tx_count) % CIRCUITPY_SERIAL_TX_BUFFER_SIZE;
+        uint32_t copy = CIRCUITPY_SERIAL_TX_BUFFER_SIZE - tx_count;
+        if (end + copy > CIRCUITPY_SERIAL_TX_BUFFER_SIZE) {
+            copy = CIRCUITPY_SERIAL_TX_BUFFER_SIZE - end;
+        }
+        if (copy > length) {
+            copy = length;
+        }
+        memcpy(tx_buffer + end, text, copy);
+        tx_count += copy;
+        text += copy;
+        length -= copy;
     }
+    move_to_usb();
+}
+
+uint32_t serial_write_dropped(void) {
+    return tx_dropped;
 }
 
 void serial_write(const char* text) {
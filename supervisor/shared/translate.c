@@ -34,8 +34,82 @@
 #include "genhdr/compression.generated.h"
 #endif
 
+#include "py/mpconfig.h"
 #include "supervisor/serial.h"
 
+// Decode short codes with one table lookup instead of a bit at a time. The
+// table costs 512 bytes of flash.
+#ifndef CIRCUITPY_TRANSLATE_FAST_LOOKUP
+#define CIRCUITPY_TRANSLATE_FAST_LOOKUP (1)
+#endif
+
+// Number of recently decompressed messages kept in RAM so that code raising
+// the same error repeatedly doesn't decode it every time. Messages longer
+// than CIRCUITPY_TRANSLATE_CACHE_LENGTH, including the NULL, aren't kept.
+#ifndef CIRCUITPY_TRANSLATE_CACHE_ENTRIES
+#define CIRCUITPY_TRANSLATE_CACHE_ENTRIES (4)
+#endif
+
+#ifndef CIRCUITPY_TRANSLATE_CACHE_LENGTH
+#define CIRCUITPY_TRANSLATE_CACHE_LENGTH (48)
+#endif
+
+// The cache is shared by all threads, so it can only be used when the GIL
+// serialises decompressing messages.
+#if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+#undef CIRCUITPY_TRANSLATE_CACHE_ENTRIES
+#define CIRCUITPY_TRANSLATE_CACHE_ENTRIES (0)
+#endif
+
+#if CIRCUITPY_TRANSLATE_CACHE_ENTRIES > 0
+typedef struct {
+    const compressed_string_t* compressed;
+    char decompressed[CIRCUITPY_TRANSLATE_CACHE_LENGTH];
+} translate_cache_entry_t;
+
+static translate_cache_entry_t cache[CIRCUITPY_TRANSLATE_CACHE_ENTRIES];
+// Indices into cache from the most to the least recently used.
+static uint8_t cache_order[CIRCUITPY_TRANSLATE_CACHE_ENTRIES];
+static bool cache_order_set;
+
+static void cache_use(uint8_t position) {
+    uint8_t index = cache_order[position];
+    memmove(cache_order + 1, cache_order, position);
+    cache_order[0] = index;
+}
+
+static bool cache_lookup(const compressed_string_t* compressed, char* decompressed) {
+    if (!cache_order_set) {
+        for (uint8_t i = 0; i < CIRCUITPY_TRANSLATE_CACHE_ENTRIES; i++) {
+            cache_order[i] = i;
+        }
+        cache_order_set = true;
+    }
+    for (uint8_t i = 0; i < CIRCUITPY_TRANSLATE_CACHE_ENTRIES; i++) {
+        translate_cache_entry_t* entry = &cache[cache_order[i]];
+        if (entry->compressed == compressed) {
+            memcpy(decompressed, entry->decompressed, compressed->length);
+            cache_use(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void cache_add(const compressed_string_t* compressed, const char* decompressed) {
+    if (compressed->length > CIRCUITPY_TRANSLATE_CACHE_LENGTH) {
+        return;
+    }
+    // Replace the least recently used entry.
+    cache_use(CIRCUITPY_TRANSLATE_CACHE_ENTRIES - 1);
+    translate_cache_entry_t* entry = &cache[cache_order[0]];
+    // Write the text before the entry can be found with it.
+    entry->compressed = NULL;
+    memcpy(entry->decompressed, decompressed, compressed->length);
+    entry->compressed = compressed;
+}
+#endif
+
 void serial_write_compressed(const compressed_string_t* compressed) {
     char decompressed[compressed->length];
     decompress(compressed, decompressed);
@@ -43,39 +117,61 @@ void serial_write_compressed(const compressed_string_t* compressed) {
 }
 
 char* decompress(const compressed_string_t* compressed, char* decompressed) {
-    uint8_t this_byte = 0;
-    uint8_t this_bit = 7;
-    uint8_t b = compressed->data[this_byte];
+    #if CIRCUITPY_TRANSLATE_CACHE_ENTRIES > 0
+    if (cache_lookup(compressed, decompressed)) {
+        return decompressed;
+    }
+    #endif
+
+    const uint8_t* next_byte = compressed->data;
+    // Bits not decoded yet, starting from the most significant bit.
+    uint32_t bits = 0;
+    uint8_t bit_count = 0;
     // Stop one early because the last byte is always NULL.
     for (uint16_t i = 0; i < compressed->length - 1; i++) {
-        uint32_t bits = 0;
+        #if CIRCUITPY_TRANSLATE_FAST_LOOKUP
+        if (bit_count < FAST_LOOKUP_BITS) {
+            // This may read past the end but those bits are never used.
+            bits |= (uint32_t) *next_byte++ << (24 - bit_count);
+            bit_count += 8;
+        }
+        uint16_t fast = fast_lookup[bits >> (32 - FAST_LOOKUP_BITS)];
+        if (fast != 0) {
+            uint8_t code_length = fast >> 8;
+            bits <<= code_length;
+            bit_count -= code_length;
+            decompressed[i] = fast & 0xff;
+            continue;
+        }
+        #endif
+        // Search the canonical code one bit at a time.
+        uint32_t code = 0;
         uint8_t bit_length = 0;
         uint32_t max_code = lengths[0];
         uint32_t searched_length = lengths[0];
         while (true) {
-            bits <<= 1;
-            if ((0x80 & b) != 0) {
-                bits |= 1;
+            if (bit_count == 0) {
+                bits = (uint32_t) *next_byte++ << 24;
+                bit_count = 8;
             }
-            b <<= 1;
+            code = (code << 1) | (bits >> 31);
+            bits <<= 1;
+            bit_count -= 1;
             bit_length += 1;
-            if (this_bit == 0) {
-                this_bit = 7;
-                this_byte += 1;
-                b = compressed->data[this_byte]; // This may read past the end but its never used.
-            } else {
-                this_bit -= 1;
-            }
-            if (max_code > 0 && bits < max_code) {
+            if (max_code > 0 && code < max_code) {
                 break;
             }
             max_code = (max_code << 1) + lengths[bit_length];
             searched_length += lengths[bit_length];
         }
-        decompressed[i] = values[searched_length + bits - max_code];
+        decompressed[i] = values[searched_length + code - max_code];
     }
 
     decompressed[compressed->length-1] = '\0';
+
+    #if CIRCUITPY_TRANSLATE_CACHE_ENTRIES > 0
+    cache_add(compressed, decompressed);
+    #endif
     return decompressed;
 }
 
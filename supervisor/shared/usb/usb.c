@@ -28,6 +28,7 @@
 #include "shared-bindings/microcontroller/Processor.h"
 #include "shared-module/usb_midi/__init__.h"
 #include "supervisor/port.h"
+#include "supervisor/serial.h"
 #include "supervisor/usb.h"
 #include "lib/utils/interrupt_char.h"
 #include "lib/mp-readline/readline.h"
@@ -79,7 +80,7 @@ void usb_init(void) {
 void usb_background(void) {
     if (usb_enabled()) {
         tud_task();
-        tud_cdc_write_flush();
+        serial_write_background();
     }
 }
 
@@ -38,8 +38,31 @@
 
 #define MSC_FLASH_BLOCK_SIZE    512
 
+// Number of blocks buffered for reading ahead of sequential host reads and
+// for collecting host writes into larger disk writes. 0 turns buffering off.
+#ifndef CIRCUITPY_MSC_BUFFER_BLOCKS
+#define CIRCUITPY_MSC_BUFFER_BLOCKS 8
+#endif
+
+#define SCSI_CMD_SYNCHRONIZE_CACHE_10 0x35
+
 static bool ejected[1];
 
+// The buffer holds either clean blocks read ahead of the host or, when dirty,
+// blocks the host has written that haven't reached the disk yet.
+#if CIRCUITPY_MSC_BUFFER_BLOCKS > 0
+static uint8_t msc_buffer[CIRCUITPY_MSC_BUFFER_BLOCKS * MSC_FLASH_BLOCK_SIZE] __attribute__((aligned(4)));
+#else
+// Never used because every transfer is at least a block.
+static uint8_t* const msc_buffer = NULL;
+#endif
+static fs_user_mount_t* buffer_vfs;
+static uint32_t buffer_lba;
+static uint32_t buffer_count;
+static bool buffer_dirty;
+// Where the next read starts if the host is reading sequentially.
+static uint32_t next_read_lba;
+
 // The root FS is always at the end of the list.
 static fs_user_mount_t* get_vfs(int lun) {
     // TODO(tannewt): Return the mount which matches the lun where 0 is the end
@@ -57,6 +80,24 @@ static fs_user_mount_t* get_vfs(int lun) {
     return current_mount->obj;
 }
 
+// Write out any blocks the host has written into the buffer.
+static bool flush_buffer(void) {
+    if (!buffer_dirty) {
+        return true;
+    }
+    uint32_t count = buffer_count;
+    buffer_dirty = false;
+    buffer_count = 0;
+    return disk_write(buffer_vfs, msc_buffer, buffer_lba, count) == RES_OK;
+}
+
+// Forget blocks read ahead. They may go stale once the host stops reading.
+static void drop_read_ahead(void) {
+    if (!buffer_dirty) {
+        buffer_count = 0;
+    }
+}
+
 // Callback invoked when received an SCSI command not in built-in list below
 // - READ_CAPACITY10, READ_FORMAT_CAPACITY, INQUIRY, MODE_SENSE6, REQUEST_SENSE
 // - READ10 and WRITE10 have their own callbacks
@@ -79,6 +120,15 @@ int32_t tud_msc_scsi_cb (uint8_t lun, const uint8_t scsi_cmd[16], void* buffer,
                     resplen = -1;
                 }
             }
+            // Hosts poll with this while idle.
+            drop_read_ahead();
+        break;
+
+        case SCSI_CMD_SYNCHRONIZE_CACHE_10:
+            resplen = 0;
+            if (!flush_buffer()) {
+                resplen = -1;
+            }
         break;
 
         case SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL:
@@ -101,7 +151,7 @@ int32_t tud_msc_scsi_cb (uint8_t lun, const uint8_t scsi_cmd[16], void* buffer,
                     if (current_mount == NULL) {
                         resplen = -1;
                     }
-                    if (disk_ioctl(current_mount, CTRL_SYNC, NULL) != RES_OK) {
+                    if (!flush_buffer() || disk_ioctl(current_mount, CTRL_SYNC, NULL) != RES_OK) {
                         resplen = -1;
                     } else {
                         ejected[lun] = true;
@@ -164,8 +214,53 @@ int32_t tud_msc_read10_cb (uint8_t lun, uint32_t lba, uint32_t offset, void* buf
     const uint32_t block_count = bufsize / MSC_FLASH_BLOCK_SIZE;
 
     fs_user_mount_t * vfs = get_vfs(lun);
-    disk_read(vfs, buffer, lba, block_count);
+    bool sequential = lba == next_read_lba;
+    next_read_lba = lba + block_count;
+
+    // Serve the read from the buffer when it's all there. Dirty blocks are
+    // newer than the disk so they are fine too.
+    if (vfs == buffer_vfs && lba >= buffer_lba && lba + block_count <= buffer_lba + buffer_count) {
+        memcpy(buffer, msc_buffer + (lba - buffer_lba) * MSC_FLASH_BLOCK_SIZE, bufsize);
+        return block_count * MSC_FLASH_BLOCK_SIZE;
+    }
+    if (!flush_buffer()) {
+        return -1;
+    }
+    buffer_count = 0;
 
+    #if CIRCUITPY_MSC_BUFFER_BLOCKS > 0
+    // Only read ahead when MicroPython can't write to the filesystem behind
+    // our back.
+    if (sequential && block_count < CIRCUITPY_MSC_BUFFER_BLOCKS &&
+        (vfs->flags & FSUSER_USB_WRITABLE) != 0) {
+        DWORD sector_count = 0;
+        disk_ioctl(vfs, GET_SECTOR_COUNT, &sector_count);
+        // Don't read past the end of the disk. A read starting beyond it is
+        // left to fail below.
+        uint32_t read_count = CIRCUITPY_MSC_BUFFER_BLOCKS;
+        if (lba >= sector_count) {
+            read_count = 0;
+        } else if (read_count > sector_count - lba) {
+            read_count = sector_count - lba;
+        }
+        if (read_count >= block_count) {
+            if (disk_read(vfs, msc_buffer, lba, read_count) != RES_OK) {
+                return -1;
+            }
+            buffer_vfs = vfs;
+            buffer_lba = lba;
+            buffer_count = read_count;
+            memcpy(buffer, msc_buffer, bufsize);
+            return block_count * MSC_FLASH_BLOCK_SIZE;
+        }
+    }
+    #else
+    (void) sequential;
+    #endif
+
+    if (disk_read(vfs, buffer, lba, block_count) != RES_OK) {
+        return -1;
+    }
     return block_count * MSC_FLASH_BLOCK_SIZE;
 }
 
@@ -178,9 +273,33 @@ int32_t tud_msc_write10_cb (uint8_t lun, uint32_t lba, uint32_t offset, uint8_t*
     const uint32_t block_count = bufsize / MSC_FLASH_BLOCK_SIZE;
 
     fs_user_mount_t * vfs = get_vfs(lun);
-    disk_write(vfs, buffer, lba, block_count);
+    drop_read_ahead();
+    // Collect consecutive blocks so the disk sees fewer, larger writes. They
+    // are written out when the buffer fills or the command completes.
+    if (buffer_dirty && (vfs != buffer_vfs || lba != buffer_lba + buffer_count ||
+                         buffer_count + block_count > CIRCUITPY_MSC_BUFFER_BLOCKS)) {
+        if (!flush_buffer()) {
+            return -1;
+        }
+    }
+    if (block_count > CIRCUITPY_MSC_BUFFER_BLOCKS) {
+        if (disk_write(vfs, buffer, lba, block_count) != RES_OK) {
+            return -1;
+        }
+    } else {
+        if (!buffer_dirty) {
+            buffer_vfs = vfs;
+            buffer_lba = lba;
+            buffer_dirty = true;
+        }
+        memcpy(msc_buffer + buffer_count * MSC_FLASH_BLOCK_SIZE, buffer, bufsize);
+        buffer_count += block_count;
+        if (buffer_count == CIRCUITPY_MSC_BUFFER_BLOCKS && !flush_buffer()) {
+            return -1;
+        }
+    }
     // Since by getting here we assume the mount is read-only to
-    // MicroPython let's update the cached FatFs sector if it's the one
+    // MicroPython let's update the cached FatFs sector if it's one
     // we just wrote.
     #if _MAX_SS != _MIN_SS
     if (vfs->ssize == MSC_FLASH_BLOCK_SIZE) {
@@ -188,7 +307,7 @@ int32_t tud_msc_write10_cb (uint8_t lun, uint32_t lba, uint32_t offset, uint8_t*
     // The compiler can optimize this away.
     if (_MAX_SS == FILESYSTEM_BLOCK_SIZE) {
     #endif
-        if (lba == vfs->fatfs.winsect && lba > 0) {
+        if (vfs->fatfs.winsect >= lba && vfs->fatfs.winsect < lba + block_count && lba > 0) {
             memcpy(vfs->fatfs.win,
                    buffer + MSC_FLASH_BLOCK_SIZE * (vfs->fatfs.winsect - lba),
                    MSC_FLASH_BLOCK_SIZE);
@@ -203,6 +322,11 @@ int32_t tud_msc_write10_cb (uint8_t lun, uint32_t lba, uint32_t offset, uint8_t*
 void tud_msc_write10_complete_cb (uint8_t lun) {
     (void) lun;
 
+    flush_buffer();
+
+    // The host may have changed any file, so forget what import has seen.
+    mp_vfs_import_stat_cache_clear();
+
     // This write is complete, start the autoreload clock.
     autoreload_start();
 }
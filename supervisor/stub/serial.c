@@ -42,6 +42,10 @@ bool serial_bytes_available(void) {
     return false;
 }
 
+uint32_t serial_write_dropped(void) {
+    return 0;
+}
+
 void serial_write(const char* text) {
     (void) text;
 }
@@ -25,6 +25,10 @@ ifdef EXTERNAL_FLASH_DEVICES
 				-DEXTERNAL_FLASH_DEVICE_COUNT=$(EXTERNAL_FLASH_DEVICE_COUNT)
 
 	SRC_SUPERVISOR += supervisor/shared/external_flash/external_flash.c
+	ifeq ($(EXTERNAL_FLASH_FTL),1)
+		CFLAGS += -DEXTERNAL_FLASH_FTL
+		SRC_SUPERVISOR += supervisor/shared/external_flash/ftl.c
+	endif
 	ifeq ($(SPI_FLASH_FILESYSTEM),1)
 		CFLAGS += -DSPI_FLASH_FILESYSTEM
 		SRC_SUPERVISOR += supervisor/shared/external_flash/spi_flash.c
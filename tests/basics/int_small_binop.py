@@ -0,0 +1,23 @@
+# test binary ops on small ints at the edges of the small-int range,
+# where the result must overflow into a big int
+
+for bits in (29, 30, 31, 32, 61, 62, 63, 64):
+    big = 1 << bits
+    a = big - 1
+    print(bits, a + 1, -a - 2, a - -1, (a << 1) >> 1, a >> 100, -a >> 100)
+    print(a | 1, a ^ big, a & 3, a < big, a >= big, a != a + 1, a == a + 1 - 1)
+
+x = 1
+for i in range(70):
+    x += x
+print(x)
+
+for sh in (-1, -100):
+    try:
+        1 << sh
+    except ValueError:
+        print('ValueError')
+    try:
+        1 >> sh
+    except ValueError:
+        print('ValueError')
@@ -0,0 +1,13 @@
+# str arguments are formatted without being converted first
+
+s = 'abcdef'
+print('%s|%5s|%-8s|%.3s|%8.2s' % (s, 'ab', s, s, s))
+print('%s %r' % (s, s))
+print('{}|{!s}|{!r}|{:>8}|{:.2}|{!s:^10}'.format(s, s, s, s, s, s))
+print('%s' % '' + '{}'.format(''))
+print(b'%s' % b'bytes')
+
+class S(str):
+    def __str__(self):
+        return 'sub'
+print('{}|{!s}'.format(S('x'), S('x')), '%s' % S('x'))
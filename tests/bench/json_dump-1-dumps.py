@@ -0,0 +1,9 @@
+import bench
+import ujson
+
+def test(num):
+    obj = {"t": 123456, "temp": 21.5, "hum": 40.0, "acc": [0.01, -0.98, 0.12], "ok": True}
+    for i in iter(range(num // 2000)):
+        ujson.dumps(obj)
+
+bench.run(test)
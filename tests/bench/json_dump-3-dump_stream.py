@@ -0,0 +1,12 @@
+import bench
+import ujson
+import uio
+
+def test(num):
+    obj = {"t": 123456, "temp": 21.5, "hum": 40.0, "acc": [0.01, -0.98, 0.12], "ok": True}
+    s = uio.BytesIO()
+    for i in iter(range(num // 2000)):
+        s.seek(0)
+        ujson.dump(obj, s)
+
+bench.run(test)
@@ -0,0 +1,10 @@
+import bench
+import ure
+
+def test(num):
+    line = "2019-01-02 12:34:56 sensor=temp value=21.5 status=ok note=" + "x" * 40
+    r = ure.compile("value=[0-9.]+")
+    for i in iter(range(num // 2000)):
+        r.search(line)
+
+bench.run(test)
@@ -0,0 +1,298 @@
+// Host tests for the btree page cache. The file is simulated in memory, and
+// everything the cache is given is also kept in a shadow copy, which pages
+// read through the cache and the file are checked against.
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+
+#define PAGE_SIZE (512)
+#define MAX_PAGES (256)
+
+static uint8_t file[MAX_PAGES * PAGE_SIZE];
+static off_t file_size;
+static off_t file_pos;
+static bool write_fails;
+static uint32_t reads;
+static uint32_t writes;
+
+static uint8_t shadow[MAX_PAGES][PAGE_SIZE];
+static uint32_t random_state = 1;
+
+static ssize_t sim_read(virt_fd_t fd, void *buf, size_t len) {
+    if (file_pos >= file_size) {
+        return 0;
+    }
+    if (len > (size_t)(file_size - file_pos)) {
+        len = file_size - file_pos;
+    }
+    memcpy(buf, file + file_pos, len);
+    file_pos += len;
+    reads++;
+    return len;
+}
+
+static ssize_t sim_write(virt_fd_t fd, const void *buf, size_t len) {
+    if (write_fails) {
+        errno = EIO;
+        return -1;
+    }
+    memcpy(file + file_pos, buf, len);
+    file_pos += len;
+    if (file_pos > file_size) {
+        file_size = file_pos;
+    }
+    writes++;
+    return len;
+}
+
+static off_t sim_lseek(virt_fd_t fd, off_t offset, int whence) {
+    file_pos = (whence == SEEK_END ? file_size : whence == SEEK_CUR ? file_pos : 0) + offset;
+    return file_pos;
+}
+
+static int sim_fsync(virt_fd_t fd) {
+    return 0;
+}
+
+static const FILEVTABLE sim_fvtable = {
+    sim_read,
+    sim_write,
+    sim_lseek,
+    sim_fsync,
+};
+
+static uint32_t random_below(uint32_t n) {
+    random_state = random_state * 1103515245 + 12345;
+    return (random_state >> 8) % n;
+}
+
+static bool report(const char *test, bool ok) {
+    printf("%s: %s\n", test, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+static bool check_file(const char *test, pgno_t npages) {
+    for (pgno_t pgno = 0; pgno < npages; pgno++) {
+        if (memcmp(file + pgno * PAGE_SIZE, shadow[pgno], PAGE_SIZE) != 0) {
+            printf("%s: page %u in the file differs\n", test, pgno);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool check_page(const char *test, pgno_t pgno, const uint8_t *page) {
+    if (page == NULL || memcmp(page, shadow[pgno], PAGE_SIZE) != 0) {
+        printf("%s: page %u reads wrong\n", test, pgno);
+        return false;
+    }
+    return true;
+}
+
+// Change a page pinned in the cache, and the shadow copy with it.
+static void change_page(pgno_t pgno, uint8_t *page) {
+    for (int i = 0; i < 16; i++) {
+        uint32_t offset = random_below(PAGE_SIZE);
+        page[offset] = shadow[pgno][offset] = random_below(256);
+    }
+}
+
+static MPOOL *open_pool(pgno_t maxcache) {
+    return mpool_open(NULL, 0, &sim_fvtable, PAGE_SIZE, maxcache);
+}
+
+// Create pages and then get, change and put them at random, with up to 4
+// pinned at a time as btree does while splitting, through a cache much
+// smaller than the file.
+static bool test_random(const char *test, pgno_t maxcache) {
+    file_size = 0;
+    memset(shadow, 0, sizeof(shadow));
+    MPOOL *mp = open_pool(maxcache);
+    bool ok = mp != NULL;
+    pgno_t npages = 0;
+    uint8_t *pinned[4];
+    pgno_t pinned_pgno[4];
+    bool pinned_new[4];
+    for (int op = 0; op < 20000 && ok; op++) {
+        int n_pinned = 1 + random_below(4);
+        for (int i = 0; i < n_pinned && ok; i++) {
+            pgno_t pgno;
+            if (npages < MAX_PAGES && random_below(8) == 0) {
+                pinned[i] = mpool_new(mp, &pgno);
+                ok = pinned[i] != NULL && pgno == npages;
+                pinned_new[i] = true;
+                if (ok) {
+                    npages++;
+                    memset(pinned[i], 0, PAGE_SIZE);
+                    change_page(pgno, pinned[i]);
+                }
+            } else if (npages > (pgno_t)i) {
+                // don't pin a page twice
+                do {
+                    pgno = random_below(npages);
+                } while (i > 0 && (pgno == pinned_pgno[0] || (i > 1 && pgno == pinned_pgno[1])
+                    || (i > 2 && pgno == pinned_pgno[2])));
+                pinned[i] = mpool_get(mp, pgno, 0);
+                pinned_new[i] = false;
+                ok = check_page(test, pgno, pinned[i]);
+            } else {
+                n_pinned = i;
+                break;
+            }
+            pinned_pgno[i] = pgno;
+        }
+        for (int i = 0; i < n_pinned && ok; i++) {
+            // new pages are always put dirty, so they get to the file
+            unsigned int flags = pinned_new[i] ? MPOOL_DIRTY : 0;
+            if (random_below(2)) {
+                change_page(pinned_pgno[i], pinned[i]);
+                flags = MPOOL_DIRTY;
+            }
+            ok = mpool_put(mp, pinned[i], flags) == RET_SUCCESS;
+        }
+        if (ok && op % 1000 == 999) {
+            ok = mpool_sync(mp) == RET_SUCCESS && check_file(test, npages);
+        }
+    }
+    ok = ok && mpool_sync(mp) == RET_SUCCESS && check_file(test, npages);
+    if (mp != NULL) {
+        mpool_close(mp);
+    }
+
+    // open the file again and read it all back through the cache
+    mp = ok ? open_pool(maxcache) : NULL;
+    for (pgno_t pgno = 0; pgno < npages && ok; pgno++) {
+        uint8_t *page = mpool_get(mp, pgno, 0);
+        ok = check_page(test, pgno, page) && mpool_put(mp, page, 0) == RET_SUCCESS;
+    }
+    if (ok) {
+        errno = 0;
+        ok = mpool_get(mp, npages, 0) == NULL && errno == EINVAL;
+    }
+    if (mp != NULL) {
+        mpool_close(mp);
+    }
+    return report(test, ok);
+}
+
+// Pages in use are found in the cache without reading the file again.
+static bool test_hits(const char *test) {
+    MPOOL *mp = open_pool(8);
+    bool ok = mp != NULL;
+    uint32_t reads_before = reads;
+    for (int i = 0; i < 1000 && ok; i++) {
+        pgno_t pgno = random_below(8);
+        uint8_t *page = mpool_get(mp, pgno, 0);
+        ok = check_page(test, pgno, page) && mpool_put(mp, page, 0) == RET_SUCCESS;
+    }
+    if (ok && reads - reads_before != 8) {
+        printf("%s: %u reads for 8 pages\n", test, reads - reads_before);
+        ok = false;
+    }
+    if (mp != NULL) {
+        mpool_close(mp);
+    }
+    return report(test, ok);
+}
+
+// When every page of the cache is pinned, more pages can still be pinned,
+// and they're released when the pool is closed.
+static bool test_all_pinned(const char *test) {
+    MPOOL *mp = open_pool(4);
+    bool ok = mp != NULL;
+    uint8_t *pages[8];
+    for (pgno_t pgno = 0; pgno < 8 && ok; pgno++) {
+        pages[pgno] = mpool_get(mp, pgno, 0);
+        ok = check_page(test, pgno, pages[pgno]);
+    }
+    for (pgno_t pgno = 0; pgno < 8 && ok; pgno++) {
+        change_page(pgno, pages[pgno]);
+        ok = mpool_put(mp, pages[pgno], MPOOL_DIRTY) == RET_SUCCESS;
+    }
+    // reuse the cache for other pages, which writes these back
+    for (pgno_t pgno = 8; pgno < 24 && ok; pgno++) {
+        uint8_t *page = mpool_get(mp, pgno, 0);
+        ok = check_page(test, pgno, page) && mpool_put(mp, page, 0) == RET_SUCCESS;
+    }
+    ok = ok && check_file(test, 24);
+    if (mp != NULL) {
+        mpool_close(mp);
+    }
+    return report(test, ok);
+}
+
+// A dirty page that can't be written stays in the cache.
+static bool test_write_error(const char *test) {
+    MPOOL *mp = open_pool(4);
+    bool ok = mp != NULL;
+    uint8_t *page = ok ? mpool_get(mp, 0, 0) : NULL;
+    ok = ok && page != NULL;
+    if (ok) {
+        change_page(0, page);
+        ok = mpool_put(mp, page, MPOOL_DIRTY) == RET_SUCCESS;
+    }
+    write_fails = true;
+    for (pgno_t pgno = 1; pgno < 4 && ok; pgno++) {
+        page = mpool_get(mp, pgno, 0);
+        ok = page != NULL && mpool_put(mp, page, 0) == RET_SUCCESS;
+    }
+    ok = ok && mpool_get(mp, 4, 0) == NULL && errno == EIO;
+    ok = ok && mpool_sync(mp) == RET_ERROR;
+    write_fails = false;
+    ok = ok && mpool_sync(mp) == RET_SUCCESS && check_file(test, 4);
+    page = ok ? mpool_get(mp, 4, 0) : NULL;
+    ok = ok && check_page(test, 4, page);
+    if (mp != NULL) {
+        mpool_close(mp);
+    }
+    return report(test, ok);
+}
+
+// The file holds pages as the output filter leaves them, and the cache as
+// the input filter does.
+static void invert_page(void *cookie, pgno_t pgno, void *page) {
+    (*(int*)cookie)++;
+    for (int i = 0; i < PAGE_SIZE; i++) {
+        ((uint8_t*)page)[i] ^= 0xff;
+    }
+}
+
+static bool test_filters(const char *test) {
+    MPOOL *mp = open_pool(4);
+    int calls = 0;
+    bool ok = mp != NULL;
+    if (ok) {
+        mpool_filter(mp, invert_page, invert_page, &calls);
+    }
+    uint8_t *page = ok ? mpool_get(mp, 0, 0) : NULL;
+    ok = ok && page != NULL && calls == 1;
+    for (int i = 0; i < PAGE_SIZE && ok; i++) {
+        ok = page[i] == (shadow[0][i] ^ 0xff);
+    }
+    if (ok) {
+        page[0] ^= 1;
+        ok = mpool_put(mp, page, MPOOL_DIRTY) == RET_SUCCESS && mpool_sync(mp) == RET_SUCCESS;
+    }
+    // written out inverted and then inverted back in the cache
+    ok = ok && calls == 3 && file[0] == (shadow[0][0] ^ 1) && page[0] == (shadow[0][0] ^ 0xfe);
+    if (mp != NULL) {
+        mpool_close(mp);
+    }
+    return report(test, ok);
+}
+
+int main(void) {
+    bool ok = true;
+    ok &= test_random("random, 8 page cache", 8);
+    ok &= test_random("random, 64 page cache", 64);
+    ok &= test_hits("cache hits");
+    ok &= test_all_pinned("all pinned");
+    ok &= test_write_error("write error");
+    ok &= test_filters("filters");
+    printf("%u reads, %u writes\n", reads, writes);
+    return ok ? 0 : 1;
+}
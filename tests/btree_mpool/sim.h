@@ -0,0 +1,36 @@
+// Stand-ins for the runtime configuration and the berkeley-db declarations
+// used by the btree page cache.
+#ifndef MICROPY_INCLUDED_TESTS_BTREE_MPOOL_SIM_H
+#define MICROPY_INCLUDED_TESTS_BTREE_MPOOL_SIM_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define MICROPY_PY_BTREE (1)
+#define STATIC static
+
+#define RET_ERROR -1
+#define RET_SUCCESS 0
+
+typedef uint32_t pgno_t;
+typedef int virt_fd_t;
+
+typedef struct {
+    ssize_t (*read)(virt_fd_t, void *, size_t);
+    ssize_t (*write)(virt_fd_t, const void *, size_t);
+    off_t (*lseek)(virt_fd_t, off_t, int);
+    int (*fsync)(virt_fd_t);
+} FILEVTABLE;
+
+typedef struct MPOOL MPOOL;
+MPOOL *mpool_open(void *key, virt_fd_t fd, const FILEVTABLE *fvtable, pgno_t pagesize, pgno_t maxcache);
+void mpool_filter(MPOOL *mp, void (*pgin)(void *, pgno_t, void *), void (*pgout)(void *, pgno_t, void *), void *pgcookie);
+void *mpool_new(MPOOL *mp, pgno_t *pgnoaddr);
+void *mpool_get(MPOOL *mp, pgno_t pgno, unsigned int flags);
+int mpool_put(MPOOL *mp, void *page, unsigned int flags);
+int mpool_sync(MPOOL *mp);
+int mpool_close(MPOOL *mp);
+
+#define MPOOL_DIRTY 0x01
+
+#endif // MICROPY_INCLUDED_TESTS_BTREE_MPOOL_SIM_H
@@ -0,0 +1,77 @@
+# test btree scan(), which copies records into a buffer and returns them as
+# memoryviews
+
+try:
+    import btree
+    import uio
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+f = uio.BytesIO()
+db = btree.open(f, pagesize=512)
+if not hasattr(db, "scan"):
+    print("SKIP")
+    raise SystemExit
+
+for i in range(10):
+    db[("key%d" % i).encode()] = ("val%d" % i).encode()
+
+def show(n, views):
+    print(n, [bytes(v) for v in views[:n]])
+
+# keys, with the views repointed rather than reallocated on each call
+buf = bytearray(64)
+views = [None] * 5
+db.keys()
+n = db.scan(buf, views)
+show(n, views)
+first = views[0]
+n = db.scan(buf, views)
+show(n, views)
+print(views[0] is first, bytes(first))
+print(db.scan(buf, views))
+
+# the views refer to the buffer
+buf[0] = ord("K")
+print(bytes(views[0]))
+
+# items over a range, two records per call; once the end key is reached the
+# range stays finished
+views = [None] * 4
+db.items(b"key2", b"key6")
+for i in range(3):
+    n = db.scan(buf, views)
+    show(2 * n, views)
+print(db.scan(buf, views))
+
+# descending and inclusive ranges
+views = [None] * 5
+db.keys(b"key7", b"key4", btree.DESC)
+show(db.scan(buf, views), views)
+print(db.scan(buf, views))
+db.values(b"key8", b"key9", btree.INCL)
+show(db.scan(buf, views), views)
+
+# a record that doesn't fit is returned by the next call
+buf = bytearray(10)
+views = [None] * 4
+db.items()
+for i in range(3):
+    n = db.scan(buf, views)
+    show(2 * n, views)
+
+# but a buffer too small for a single record is an error
+db.items()
+try:
+    db.scan(bytearray(4), views)
+except ValueError:
+    print("ValueError")
+
+try:
+    db.scan(buf, (None,))
+except TypeError:
+    print("TypeError")
+
+db.close()
+f.close()
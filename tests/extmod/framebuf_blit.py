@@ -0,0 +1,147 @@
+# test blit, blit_scaled and blend against per-pixel reference implementations
+
+try:
+    import framebuf
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+FORMATS = (
+    (framebuf.MONO_VLSB, 1, 1),
+    (framebuf.MONO_HLSB, 1, 1),
+    (framebuf.MONO_HMSB, 1, 1),
+    (framebuf.GS2_HMSB, 2, 1),
+    (framebuf.GS4_HMSB, 4, 1),
+    (framebuf.GS8, 8, 1),
+    (framebuf.RGB565, 16, 2),
+)
+
+seed = 1
+def rand(n):
+    global seed
+    seed = (seed * 1103515245 + 12345) & 0x7fffffff
+    return (seed >> 8) % n
+
+def new_fb(fmt, bits, bpp, w, h, fill=True):
+    buf = bytearray((w * h * bpp * 8 + 7) // 8 + w * bpp)
+    fb = framebuf.FrameBuffer(buf, w, h, fmt)
+    if fill:
+        for y in range(h):
+            for x in range(w):
+                fb.pixel(x, y, rand(1 << bits))
+    return buf, fb
+
+def copy_fb(buf, fmt, w, h):
+    buf2 = bytearray(buf)
+    return buf2, framebuf.FrameBuffer(buf2, w, h, fmt)
+
+def ref_blit(dst, dw, dh, src, sw, sh, x, y, w, h, key=-1, palette=None):
+    xstep = (sw << 16) // w
+    ystep = (sh << 16) // h
+    for j in range(max(0, y), min(dh, y + h)):
+        sy = ((j - y) * ystep + (ystep >> 1)) >> 16
+        for i in range(max(0, x), min(dw, x + w)):
+            sx = ((i - x) * xstep + (xstep >> 1)) >> 16
+            c = src.pixel(sx, sy)
+            if palette is not None and c < 4:
+                c = palette.pixel(c, 0)
+            if c != key:
+                dst.pixel(i, j, c)
+
+# blit between all pairs of formats, at aligned and unaligned positions
+for sfmt, sbits, sbpp in FORMATS:
+    sbuf, src = new_fb(sfmt, sbits, sbpp, 19, 11)
+    ok = True
+    for dfmt, dbits, dbpp in FORMATS:
+        base, _ = new_fb(dfmt, dbits, dbpp, 24, 17)
+        for x, y, key in ((0, 0, -1), (8, 8, -1), (3, 5, 1), (-5, -3, -1), (13, 9, 0), (-2, 10, 2)):
+            rbuf, ref = copy_fb(base, dfmt, 24, 17)
+            ref_blit(ref, 24, 17, src, 19, 11, x, y, 19, 11, key)
+            dbuf, dst = copy_fb(base, dfmt, 24, 17)
+            dst.blit(src, x, y, key)
+            if dbuf != rbuf:
+                ok = False
+                print("mismatch", dfmt, x, y, key)
+    print("blit", sfmt, ok)
+
+# scaled blit
+sbuf, src = new_fb(framebuf.GS4_HMSB, 4, 1, 7, 5)
+for w, h, x, y in ((14, 10, 0, 0), (21, 15, -3, 2), (3, 2, 1, 1), (10, 9, 5, -4), (75, 3, -1, 0)):
+    dbuf, dst = new_fb(framebuf.RGB565, 16, 2, 70, 12)
+    rbuf, ref = copy_fb(dbuf, framebuf.RGB565, 70, 12)
+    ref_blit(ref, 70, 12, src, 7, 5, x, y, w, h, 3)
+    dst.blit_scaled(src, x, y, w, h, 3)
+    print("scaled", w, h, dbuf == rbuf)
+
+# rows longer than the line buffer, and the same format
+for fmt, bits, bpp in FORMATS:
+    sbuf, src = new_fb(fmt, bits, bpp, 77, 3)
+    base, _ = new_fb(fmt, bits, bpp, 90, 4)
+    ok = True
+    for x in (0, 3, 8, 16):
+        rbuf, ref = copy_fb(base, fmt, 90, 4)
+        ref_blit(ref, 90, 4, src, 77, 3, x, 1, 77, 3)
+        dbuf, dst = copy_fb(base, fmt, 90, 4)
+        dst.blit(src, x, 1)
+        ok = ok and dbuf == rbuf
+    print("wide", fmt, ok)
+
+# palette converts between formats
+pbuf, palette = new_fb(framebuf.RGB565, 16, 2, 4, 1, False)
+for i, c in enumerate((0x0000, 0xf800, 0x07e0, 0xffff)):
+    palette.pixel(i, 0, c)
+sbuf, src = new_fb(framebuf.GS2_HMSB, 2, 1, 9, 6)
+dbuf, dst = new_fb(framebuf.RGB565, 16, 2, 12, 8)
+rbuf, ref = copy_fb(dbuf, framebuf.RGB565, 12, 8)
+ref_blit(ref, 12, 8, src, 9, 6, 2, 1, 9, 6, 0xf800, palette)
+dst.blit(src, 2, 1, 0xf800, palette)
+print("palette", dbuf == rbuf)
+
+# alpha blending
+def ref_blend(d, s, a):
+    a5 = (a + 4) >> 3
+    out = 0
+    for sh, bits in ((11, 5), (5, 6), (0, 5)):
+        m = (1 << bits) - 1
+        dc = (d >> sh) & m
+        sc = (s >> sh) & m
+        out |= ((dc + (((sc - dc) * a5) >> 5)) & m) << sh
+    return out
+
+sbuf, src = new_fb(framebuf.RGB565, 16, 2, 5, 4)
+mbuf, mask = new_fb(framebuf.GS8, 8, 1, 5, 4)
+for alpha in (0, 100, 255, mask):
+    dbuf, dst = new_fb(framebuf.RGB565, 16, 2, 8, 6)
+    rbuf, ref = copy_fb(dbuf, framebuf.RGB565, 8, 6)
+    key = src.pixel(1, 1)
+    for y in range(4):
+        for x in range(5):
+            c = src.pixel(x, y)
+            a = alpha if isinstance(alpha, int) else mask.pixel(x, y)
+            if c != key and 0 <= x + 2 < 8 and 0 <= y + 3 < 6:
+                ref.pixel(x + 2, y + 3, ref_blend(ref.pixel(x + 2, y + 3), c, a))
+    dst.blend(src, 2, 3, alpha, key)
+    print("blend", dbuf == rbuf)
+
+try:
+    framebuf.FrameBuffer(bytearray(8), 8, 8, framebuf.GS8).blend(src, 0, 0, 128)
+except ValueError:
+    print("ValueError")
+
+# other FrameBuffer arguments must be FrameBuffers, or subclasses of it
+class FB(framebuf.FrameBuffer):
+    pass
+
+dbuf = bytearray(4)
+dst = framebuf.FrameBuffer(dbuf, 4, 1, framebuf.GS8)
+sub = FB(bytearray(b"\x01\x02"), 2, 1, framebuf.GS8)
+dst.blit(sub, 1, 0, -1, FB(bytearray(b"\x00\x07\x08"), 3, 1, framebuf.GS8))
+print(bytes(dbuf))
+for f in (lambda: dst.blit(bytearray(4), 0, 0),
+          lambda: dst.blit(sub, 0, 0, -1, "abc"),
+          lambda: dst.blit_scaled(sub, 0, 0, 2, 2, -1, 1),
+          lambda: framebuf.FrameBuffer(bytearray(8), 4, 1, framebuf.RGB565).blend(sub, 0, 0, 0.5)):
+    try:
+        f()
+    except TypeError:
+        print("TypeError")
@@ -0,0 +1,77 @@
+# test the uasyncio event loop
+
+try:
+    import uasyncio
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+async def ticker(name, n):
+    for i in range(n):
+        print(name, i)
+        await uasyncio.sleep_ms(0)
+    return name + " done"
+
+async def double(x):
+    await uasyncio.sleep_ms(0)
+    return x * 2
+
+async def fail():
+    await uasyncio.sleep_ms(0)
+    raise ValueError("fail")
+
+async def main():
+    a = uasyncio.create_task(ticker("a", 3))
+    b = uasyncio.create_task(ticker("b", 2))
+    # awaiting a coroutine runs it in this task
+    print(await double(21))
+    # awaiting a task waits for it to finish
+    print(await uasyncio.create_task(double(4)))
+    print(await a, await b, a.done(), b.done())
+    try:
+        await uasyncio.create_task(fail())
+    except ValueError as er:
+        print("ValueError", er)
+    return "main done"
+
+print(uasyncio.run(main()))
+
+# the exception of a failing main task is raised by run() and not printed
+try:
+    uasyncio.run(fail())
+except ValueError as er:
+    print("ValueError", er)
+
+# sleeping tasks wake in order of when they were due; each is due later than
+# the one created before it, however long creating the tasks takes
+async def sleeper(ms):
+    await uasyncio.sleep_ms(ms)
+    print("slept", ms)
+
+async def sleepers():
+    tasks = [uasyncio.create_task(sleeper(ms)) for ms in (10, 20, 30)]
+    await uasyncio.sleep(0.05)
+    print([t.done() for t in tasks])
+
+uasyncio.run(sleepers())
+
+# tasks created before run() start with it, and run() without a coroutine
+# returns once they have all finished
+async def count(name):
+    for i in range(2):
+        print(name, i)
+        await uasyncio.sleep(0)
+
+uasyncio.create_task(count("x"))
+uasyncio.create_task(count("y"))
+print(uasyncio.run())
+
+try:
+    uasyncio.sleep_ms(1)
+except RuntimeError:
+    print("RuntimeError")
+
+try:
+    uasyncio.create_task(1)
+except TypeError:
+    print("TypeError")
@@ -0,0 +1,91 @@
+# test uasyncio.wait_io with UDP sockets
+
+try:
+    import uasyncio
+    uasyncio.wait_io
+    import usocket as socket, uselect as select
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+addrs = []
+socks = []
+try:
+    for port in (8591, 8592):
+        addr = socket.getaddrinfo("127.0.0.1", port)[0][-1]
+        s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        s.bind(addr)
+        addrs.append(addr)
+        socks.append(s)
+except OSError:
+    print("SKIP")
+    raise SystemExit
+
+async def reader(i):
+    await uasyncio.wait_io(socks[i], select.POLLIN)
+    return socks[i].recv(10)
+
+async def main():
+    r0 = uasyncio.create_task(reader(0))
+    r1 = uasyncio.create_task(reader(1))
+    # the readers wait until a datagram arrives
+    await uasyncio.sleep_ms(0)
+    print(r0.done(), r1.done())
+    socks[0].sendto(b"a", addrs[1])
+    print(await r1, r0.done())
+    socks[1].sendto(b"b", addrs[0])
+    print(await r0)
+    # both readers waiting at once
+    r0 = uasyncio.create_task(reader(0))
+    r1 = uasyncio.create_task(reader(1))
+    await uasyncio.sleep_ms(0)
+    socks[0].sendto(b"c", addrs[1])
+    socks[1].sendto(b"d", addrs[0])
+    print(await r0, await r1)
+    # waiting for a socket to be writable completes at once
+    await uasyncio.wait_io(socks[0], select.POLLOUT)
+    print("writable")
+
+uasyncio.run(main())
+
+# a reader and a writer waiting on the same socket wake separately
+async def writer(i):
+    await uasyncio.wait_io(socks[i], select.POLLOUT)
+    return "writable"
+
+async def reader_and_writer():
+    r = uasyncio.create_task(reader(0))
+    w = uasyncio.create_task(writer(0))
+    print(await w, r.done())
+    await uasyncio.sleep_ms(10)
+    print(r.done())
+    socks[1].sendto(b"e", addrs[0])
+    print(await r)
+
+uasyncio.run(reader_and_writer())
+
+# an object that can't be waited on raises in the task, and other tasks go on
+async def bad():
+    try:
+        await uasyncio.wait_io(object(), select.POLLIN)
+    except TypeError:
+        print("TypeError")
+
+async def bad_main():
+    t = uasyncio.create_task(bad())
+    await uasyncio.sleep_ms(0)
+    print("main", t.done())
+    await t
+
+uasyncio.run(bad_main())
+
+# the loop waits on sockets when no task is ready or sleeping
+async def sender():
+    await uasyncio.sleep_ms(10)
+    socks[1].sendto(b"d", addrs[0])
+
+uasyncio.create_task(sender())
+print(uasyncio.run(reader(0)))
+
+for s in socks:
+    s.close()
@@ -0,0 +1,23 @@
+try:
+    import uhashlib as hashlib
+except ImportError:
+    try:
+        import hashlib
+    except ImportError:
+        print("SKIP")
+        raise SystemExit
+try:
+    import uio as io
+except ImportError:
+    import io
+
+if not hasattr(hashlib, "file_digest"):
+    print("SKIP")
+    raise SystemExit
+
+# sizes below, at and above the read buffer size
+for n in (0, 100, 4096, 10000):
+    data = bytes(range(256)) * (n // 256) + b"x" * (n % 256)
+    print(n, hashlib.file_digest(io.BytesIO(data), "sha256").digest() == hashlib.sha256(data).digest())
+
+print(hashlib.file_digest(io.BytesIO(b"abc"), hashlib.sha256).digest())
@@ -0,0 +1,33 @@
+try:
+    import uhashlib as hashlib
+except ImportError:
+    try:
+        import hashlib
+    except ImportError:
+        print("SKIP")
+        raise SystemExit
+
+if not hasattr(hashlib, "hmac_sha256"):
+    print("SKIP")
+    raise SystemExit
+
+# RFC 4231 test case 2
+print(hashlib.hmac_sha256(b"Jefe", b"what do ya want for nothing?").digest())
+
+# data given in pieces, as memoryview and bytearray
+h = hashlib.hmac_sha256(b"Jefe")
+h.update(b"what do ya ")
+h.update(memoryview(b"want for "))
+h.update(bytearray(b"nothing?"))
+print(h.digest())
+
+# digest() can be repeated, and more data added after it
+h = hashlib.hmac_sha256(b"Jefe", b"what do ya want ")
+print(h.digest() == hashlib.hmac_sha256(b"Jefe", b"what do ya want ").digest())
+print(h.digest() == h.digest())
+h.update(b"for nothing?")
+print(h.digest())
+
+# empty key, and keys around the block size; longer keys are hashed first
+for n in (0, 63, 64, 65, 131):
+    print(n, hashlib.hmac_sha256(b"\xaa" * n, b"x" * 100).digest())
@@ -0,0 +1,41 @@
+# test ujson.dumps_into and buffered ujson.dump
+try:
+    import ujson
+    from uio import StringIO
+    ujson.dumps_into
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+buf = bytearray(64)
+n = ujson.dumps_into({"a": [1, 2.5, None, True]}, buf)
+print(n, buf[:n])
+print(ujson.dumps_into("x", memoryview(buf)[10:]), buf[10:13])
+
+# output must fit exactly
+n = ujson.dumps_into([1, 2], bytearray(6))
+print(n)
+try:
+    ujson.dumps_into([1, 2], bytearray(5))
+except ValueError:
+    print("ValueError")
+
+# read-only buffer
+try:
+    ujson.dumps_into(1, b"1234")
+except TypeError:
+    print("TypeError")
+
+# no heap allocation for plain data
+import micropython
+data = {"t": 1234, "v": [1.5, -2.0, 3], "ok": False}
+micropython.heap_lock()
+n = ujson.dumps_into(data, buf)
+micropython.heap_unlock()
+print(buf[:n] == ujson.dumps(data).encode())
+
+# dump output larger than its internal buffer
+for obj in ("s" * 500, list(range(200)), [{"k": "v" * i} for i in range(30)]):
+    s = StringIO()
+    ujson.dump(obj, s)
+    print(s.getvalue() == ujson.dumps(obj))
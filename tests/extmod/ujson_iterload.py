@@ -0,0 +1,31 @@
+try:
+    from uio import StringIO
+    import ujson as json
+    json.iterload
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+def show(s):
+    try:
+        print(list(json.iterload(StringIO(s))))
+    except ValueError:
+        print('ValueError')
+
+show('[]')
+show(' [ 1 , "two", [3, 4], {"a": null}, true, 1.5 ] ')
+show('[' + ','.join(str(i) for i in range(200)) + ']\n')
+
+# elements are parsed one at a time, so an error comes after earlier elements
+it = json.iterload(StringIO('[1, 2, x]'))
+print(next(it), next(it))
+try:
+    next(it)
+except ValueError:
+    print('ValueError')
+
+# only an array is accepted, with nothing but whitespace after it
+show('{}')
+show('1')
+show('[1] 2')
+show('[1')
@@ -0,0 +1,38 @@
+# test matching against objects with the buffer protocol
+
+try:
+    import ure
+    ure.compile("a").finditer
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+buf = bytearray(b"id=12 temp=34 id=56")
+mv = memoryview(buf)
+r = ure.compile(b"id=([0-9]+)")
+print(r.search(buf).group(1))
+print(r.search(mv, 6).group(1))
+print(r.search(mv[6:]).group(0))
+print([m.group(1) for m in r.finditer(mv)])
+print(r.sub(b"X", mv))
+print(ure.compile(b" ").split(mv))
+
+# a bytearray subject may be resized after matching
+buf = bytearray(b"abc id=1 id=2")
+m = ure.search(b"b", buf)
+it = r.finditer(buf)
+print(next(it).group(1))
+buf.extend(b"Q" * 4000)
+import gc
+gc.collect()
+print(m.group(0), m.span())
+print([m.group(1) for m in it])
+buf[:] = b"a"
+print(m.group(0), m.span())
+
+# and a callable replacement may change it while it's scanned
+buf = bytearray(b"id=1 id=2 id=3")
+def repl(m):
+    buf.extend(b"Q" * 4000)
+    return b"<" + m.group(1) + b">"
+print(r.sub(repl, buf))
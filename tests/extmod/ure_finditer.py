@@ -0,0 +1,31 @@
+try:
+    import ure as re
+except ImportError:
+    try:
+        import re
+    except ImportError:
+        print("SKIP")
+        raise SystemExit
+
+try:
+    re.finditer
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+def show(it):
+    print([m.group(0) for m in it])
+
+show(re.finditer("[0-9]+", "a1 b22 c333"))
+show(re.finditer("x", "abc"))
+show(re.finditer("^a", "aaa"))
+show(re.finditer("a*", "baac"))
+show(re.finditer(b"[a-z]+", b"ab12cd"))
+
+r = re.compile("([a-z]+)=([0-9]+)")
+for m in r.finditer("x=1,yy=22,zzz=333"):
+    print(m.group(1), m.group(2))
+
+# iterator is exhausted
+it = r.finditer("a=1")
+print(len(list(it)), len(list(it)))
@@ -0,0 +1,43 @@
+# test the linear-time matcher selected by ure.LINEAR
+
+try:
+    import ure
+    ure.LINEAR
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+# same results as the backtracking matcher
+for pat, s in (
+    ("a|ab", "ab"),
+    ("(a*)(a*)", "aaa"),
+    ("(a*?)(a*)", "aaa"),
+    ("a+?b", "xaaab"),
+    ("(a|b)*c", "ababcab"),
+    ("^abc", "xabc"),
+    ("abc$", "abcabc"),
+    ("[0-9]+", "ab 123 45"),
+    ("\\d+\\.\\d*", "x=21.5;"),
+    ("(x)?y", "y"),
+    ("b", "aaab"),
+    ("", "abc"),
+):
+    r0 = ure.compile(pat)
+    r1 = ure.compile(pat, ure.LINEAR)
+    for f in ("match", "search"):
+        m0 = getattr(r0, f)(s)
+        m1 = getattr(r1, f)(s)
+        if m0 is None or m1 is None:
+            print(pat, f, m0 is None, m1 is None)
+        else:
+            n = pat.count("(") + 1
+            print(pat, f, [m0.group(i) for i in range(n)] == [m1.group(i) for i in range(n)], m1.group(0))
+
+# patterns which backtrack exponentially or recurse without end
+r = ure.compile("(a|aa)*b", ure.LINEAR)
+print(r.match("a" * 40))
+print(r.search("a" * 40 + "b").group(0) == "a" * 40 + "b")
+print(ure.compile("(a*)*", ure.LINEAR).match("aaa").group(0))
+
+# split
+print(ure.compile("[,;]", ure.LINEAR).split("a,b;c"))
@@ -0,0 +1,41 @@
+# test search/match with pos and endpos, and match spans
+
+try:
+    import ure as re
+except ImportError:
+    try:
+        import re
+    except ImportError:
+        print("SKIP")
+        raise SystemExit
+
+try:
+    re.compile("a").search("a").span
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+r = re.compile("[0-9]+")
+s = "ab12cd345"
+print(r.search(s, 0).span())
+print(r.search(s, 3).span())
+print(r.search(s, 4).span())
+print(r.search(s, 4, 7).span())
+print(r.search(s, 4, 6))
+print(r.search(s, 100))
+print(r.search(s, -5).span())
+print(r.search(s, 5, 2))
+print(r.match(s, 2).group(0))
+print(r.match(s, 1))
+
+# ^ only matches at the real start, $ at endpos
+print(re.compile("^c").search(s, 4))
+print(re.compile("c$").search(s, 0, 5).span())
+
+r = re.compile("(a)(x)?")
+m = r.search("bba")
+print(m.span(), m.start(), m.end(), m.span(1), m.span(2))
+try:
+    m.span(3)
+except IndexError:
+    print("IndexError")
@@ -0,0 +1,40 @@
+try:
+    import ure as re
+except ImportError:
+    try:
+        import re
+    except ImportError:
+        print("SKIP")
+        raise SystemExit
+
+try:
+    re.sub
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+print(re.sub("a", "b", "banana"))
+print(re.sub("a", "b", "banana", 2))
+print(re.sub("x", "b", "banana"))
+print(re.sub("(a)(n)", r"\2\1", "banana"))
+print(re.sub("(a)(n)", r"<\g<2>\g<1>>", "banana"))
+print(re.sub("(x)?a", r"[\1]", "banana"))
+print(re.sub("[0-9]+", lambda m: str(int(m.group(0)) * 2), "1 + 20 = 21"))
+print(re.sub("^a", "A", "aaa"))
+print(re.sub("a$", "A", "aaa"))
+print(re.sub(b"[0-9]", b"#", b"a1b22"))
+
+# empty matches
+print(re.sub("x*", "-", "abc"))
+print(re.sub("", "-", ""))
+
+# method of compiled regex
+r = re.compile("[,;] *")
+print(r.sub(",", "a, b;c;  d"))
+print(r.sub(",", "a, b;c;  d", 1))
+
+# invalid group, CPython raises re.error
+try:
+    re.sub("(a)", r"\2", "a")
+except Exception:
+    print("Exception")
@@ -0,0 +1,76 @@
+# test uselect.poll with UDP sockets
+
+try:
+    import usocket as socket, uselect as select
+except ImportError:
+    try:
+        import socket, select
+    except ImportError:
+        print("SKIP")
+        raise SystemExit
+
+addrs = []
+socks = []
+try:
+    for port in (8581, 8582, 8583):
+        addr = socket.getaddrinfo("127.0.0.1", port)[0][-1]
+        s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        s.bind(addr)
+        addrs.append(addr)
+        socks.append(s)
+except OSError:
+    print("SKIP")
+    raise SystemExit
+
+def show(res):
+    print(sorted([socks.index(o), ev] for o, ev in res))
+
+poller = select.poll()
+for s in socks:
+    print(poller.register(s, select.POLLIN))
+
+# nothing to read
+show(poller.poll(0))
+
+# send datagrams, the receiving sockets become readable
+socks[0].sendto(b"a", addrs[1])
+socks[0].sendto(b"b", addrs[2])
+show(poller.poll(1000))
+
+# ipoll gives the same events
+show([(o, ev) for o, ev in poller.ipoll(0)])
+
+# reading clears the event
+print(socks[1].recv(10))
+show(poller.poll(0))
+
+# modify the events polled for
+poller.modify(socks[0], select.POLLIN | select.POLLOUT)
+show(poller.poll(0))
+
+# registering again modifies the events
+poller.register(socks[0], select.POLLIN)
+show(poller.poll(0))
+
+# unregistered sockets aren't reported
+poller.unregister(socks[2])
+show(poller.poll(0))
+
+# raw fds are returned as ints
+poller.register(socks[2].fileno(), select.POLLIN)
+print([ev for o, ev in poller.poll(0) if isinstance(o, int)])
+poller.unregister(socks[2].fileno())
+
+# a closed socket is reported as POLLNVAL (0x20) until it's unregistered
+socks[1].close()
+show(poller.poll(1000))
+show(poller.poll(1000))
+poller.unregister(socks[1])
+show(poller.poll(0))
+
+# a closed socket can be registered too
+poller.register(socks[1], select.POLLIN)
+show(poller.poll(1000))
+
+for s in socks:
+    s.close()
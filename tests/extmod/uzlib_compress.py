@@ -0,0 +1,57 @@
+try:
+    import uzlib as zlib
+    import uio as io
+    zlib.compress
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+log = b"".join(b"%d,temp=21.%d,hum=40,status=ok\n" % (1000 + i, i % 10) for i in range(200))
+data_list = [b"", b"a", b"hello", bytes(range(256)) * 2, b"x" * 1000, log]
+
+def decompress(c, wbits):
+    return zlib.DecompIO(io.BytesIO(c), wbits).read()
+
+# one-shot compression in the raw, zlib and gzip formats
+for data in data_list:
+    for wbits in (-8, -12, 8, 10, 15, 16 + 9, 16 + 15):
+        c = zlib.compress(data, wbits)
+        if decompress(c, wbits) != data:
+            print("mismatch", len(data), wbits)
+    if zlib.decompress(zlib.compress(data)) != data:
+        print("mismatch", len(data))
+print(zlib.compress(b"hello", -10))
+print(len(zlib.compress(log)) < len(log) // 4)
+
+# streaming compression with writes of assorted sizes
+buf = io.BytesIO()
+with zlib.CompIO(buf, 16 + 10) as c:
+    n = 0
+    for i in range(len(log) // 100):
+        c.write(log[n:n + i])
+        n += i
+    c.write(log[n:])
+print(decompress(buf.getvalue(), 16 + 10) == log)
+
+# flush makes everything written so far decodable
+buf = io.BytesIO()
+c = zlib.CompIO(buf, -9)
+c.write(log[:100])
+c.flush()
+print(zlib.DecompIO(io.BytesIO(buf.getvalue()), -9).read(100) == log[:100])
+c.write(log[100:])
+c.close()
+print(decompress(buf.getvalue(), -9) == log)
+
+# writing after close is an error
+try:
+    c.write(b"1")
+except OSError:
+    print("OSError")
+
+# bad wbits
+for wbits in (7, 16, -16, 40):
+    try:
+        zlib.compress(b"", wbits)
+    except ValueError:
+        print("ValueError")
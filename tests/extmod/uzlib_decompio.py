@@ -20,6 +20,13 @@ print(inp.read())
 print(buf.seek(0, 1))
 
 
+# data following the compressed stream is left in the source stream
+buf = io.BytesIO(b'\xcbH\xcd\xc9\xc9\x07\x00tail')
+inp = zlib.DecompIO(buf, -8)
+print(inp.read())
+print(buf.read())
+
+
 # zlib bitstream
 inp = zlib.DecompIO(io.BytesIO(b'x\x9c30\xa0=\x00\x00\xb3q\x12\xc1'))
 print(inp.read(10))
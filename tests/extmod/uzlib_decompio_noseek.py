@@ -0,0 +1,26 @@
+# test DecompIO with a source stream that can't seek, which must not be read
+# past the end of the compressed data
+
+try:
+    import uzlib as zlib
+    import uio as io
+    io.IOBase
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+
+class Stream(io.IOBase):
+    def __init__(self, data):
+        self.buf = io.BytesIO(data)
+
+    def readinto(self, buf):
+        return self.buf.readinto(buf)
+
+
+src = Stream(b'\xcbH\xcd\xc9\xc9\x07\x00tail')
+inp = zlib.DecompIO(src, -8)
+print(inp.read(1))
+print(src.buf.seek(0, 1))
+print(inp.read())
+print(src.buf.read())
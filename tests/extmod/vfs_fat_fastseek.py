@@ -0,0 +1,91 @@
+# Test seeking around large and fragmented files, which may use a cluster map
+
+try:
+    import uos
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+try:
+    uos.VfsFat
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+
+class RAMFS:
+
+    SEC_SIZE = 512
+
+    def __init__(self, blocks):
+        self.data = bytearray(blocks * self.SEC_SIZE)
+
+    def readblocks(self, n, buf):
+        buf[:] = self.data[n * self.SEC_SIZE:n * self.SEC_SIZE + len(buf)]
+        return 0
+
+    def writeblocks(self, n, buf):
+        self.data[n * self.SEC_SIZE:n * self.SEC_SIZE + len(buf)] = buf
+        return 0
+
+    def ioctl(self, op, arg):
+        if op == 4:  # BP_IOCTL_SEC_COUNT
+            return len(self.data) // self.SEC_SIZE
+        if op == 5:  # BP_IOCTL_SEC_SIZE
+            return self.SEC_SIZE
+
+
+try:
+    bdev = RAMFS(200)
+except MemoryError:
+    print("SKIP")
+    raise SystemExit
+
+uos.VfsFat.mkfs(bdev)
+vfs = uos.VfsFat(bdev)
+uos.mount(vfs, '/ramdisk')
+uos.chdir('/ramdisk')
+
+def pattern(name, i):
+    return bytes((name + i + j) & 0xff for j in range(512))
+
+# Interleave the writes so both files end up fragmented.
+with open('a', 'wb') as fa:
+    with open('b', 'wb') as fb:
+        for i in range(40):
+            fa.write(pattern(1, i))
+            if i % 3 == 0:
+                fb.write(pattern(2, i))
+
+def check(mode):
+    ok = True
+    with open('a', mode) as f:
+        for i in (39, 0, 20, 5, 38, 1, 30, 30, 12):
+            for offset in (i * 512, i * 512 + 511):
+                f.seek(offset)
+                if f.read(1)[0] != (1 + i + offset % 512) & 0xff:
+                    ok = False
+        f.seek(0, 2)
+        if f.tell() != 40 * 512:
+            ok = False
+        f.seek(-600, 2)
+        if f.read(600) != pattern(1, 38)[-88:] + pattern(1, 39):
+            ok = False
+    print(mode, ok)
+
+check('rb')
+check('r+b')
+
+# A file opened for writing can still grow after seeking around.
+with open('b', 'r+b') as f:
+    f.seek(0)
+    f.seek(5 * 512)
+    f.seek(0, 2)
+    f.write(b'end')
+with open('b', 'rb') as f:
+    f.seek(-3, 2)
+    print(f.read())
+    f.seek(0)
+    print(f.read(4) == pattern(2, 0)[:4])
+
+uos.umount('/ramdisk')
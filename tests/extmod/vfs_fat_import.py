@@ -0,0 +1,82 @@
+# test importing from a FAT filesystem, which matches names regardless of case
+
+import sys
+
+try:
+    import uos
+    uos.VfsFat
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+
+class RAMFS:
+
+    SEC_SIZE = 512
+
+    def __init__(self, blocks):
+        self.data = bytearray(blocks * self.SEC_SIZE)
+
+    def readblocks(self, n, buf):
+        for i in range(len(buf)):
+            buf[i] = self.data[n * self.SEC_SIZE + i]
+        return 0
+
+    def writeblocks(self, n, buf):
+        for i in range(len(buf)):
+            self.data[n * self.SEC_SIZE + i] = buf[i]
+        return 0
+
+    def ioctl(self, op, arg):
+        if op == 4:  # BP_IOCTL_SEC_COUNT
+            return len(self.data) // self.SEC_SIZE
+        if op == 5:  # BP_IOCTL_SEC_SIZE
+            return self.SEC_SIZE
+
+
+try:
+    bdev = RAMFS(50)
+except MemoryError:
+    print("SKIP")
+    raise SystemExit
+
+uos.VfsFat.mkfs(bdev)
+vfs = uos.VfsFat(bdev)
+uos.mount(vfs, '/ramdisk')
+sys_path = sys.path[:]
+sys.path[:] = ['/ramdisk']
+
+def write(name, data):
+    # use the filesystem directly, not through uos
+    with vfs.open(name, 'w') as f:
+        f.write(data)
+
+def try_import(name):
+    try:
+        __import__(name)
+    except ImportError:
+        print('ImportError', name)
+    sys.modules.pop(name, None)
+
+# names match regardless of case
+write('CaseMod.py', 'print("CaseMod")')
+vfs.mkdir('CasePkg')
+write('CasePkg/__init__.py', 'print("CasePkg")')
+write('CasePkg/Sub.py', 'print("CasePkg.Sub")')
+try_import('casemod')
+try_import('CASEMOD')
+try_import('casepkg.sub')
+sys.modules.pop('casepkg', None)
+
+# changes made through the filesystem object are seen by import
+try_import('fatmod')
+write('fatmod.py', 'print("fatmod")')
+try_import('fatmod')
+vfs.rename('fatmod.py', 'fatmod2.py')
+try_import('fatmod')
+try_import('fatmod2')
+vfs.remove('fatmod2.py')
+try_import('fatmod2')
+
+uos.umount('/ramdisk')
+sys.path[:] = sys_path
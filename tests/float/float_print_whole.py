@@ -0,0 +1,8 @@
+# test printing of floats with whole number values
+
+for x in (0.0, -0.0, 1.0, -1.0, 7.0, 10.0, -100.0, 12345.0, -999999.0, 1e6, 2e6, 1e20, 0.5, -1.5):
+    print(x, repr(x), str(x))
+
+print([1.0, -2.0, 30.0])
+print("%s %r" % (4.0, -5.0))
+print(float(2 ** 20), float(-(2 ** 21)))
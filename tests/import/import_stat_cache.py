@@ -0,0 +1,115 @@
+# test that import answers path lookups from cached directory listings
+
+import sys, uio
+
+try:
+    uio.IOBase
+    import uos, micropython
+    uos.mount
+    micropython.import_stat_count
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+
+class UserFile(uio.IOBase):
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+    def read(self):
+        return self.data
+    def readinto(self, buf):
+        n = 0
+        while n < len(buf) and self.pos < len(self.data):
+            buf[n] = self.data[self.pos]
+            n += 1
+            self.pos += 1
+        return n
+    def write(self, buf):
+        self.data += buf
+        return len(buf)
+    def ioctl(self, req, arg):
+        return 0
+
+
+class UserFS:
+    def __init__(self, files):
+        self.files = files
+        self.calls = []
+    def mount(self, readonly, mksfs):
+        pass
+    def umount(self):
+        pass
+    def stat(self, path):
+        self.calls.append('stat ' + path)
+        if path in self.files:
+            return (32768, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+        for name in self.files:
+            if name.startswith(path + '/'):
+                return (16384, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+        raise OSError
+    def ilistdir(self, path):
+        self.calls.append('ilistdir ' + path)
+        prefix = path.rstrip('/') + '/'
+        entries = {}
+        for name in self.files:
+            if name.startswith(prefix):
+                name = name[len(prefix):]
+                if '/' in name:
+                    entries[name.split('/')[0]] = 0x4000
+                else:
+                    entries[name] = 0x8000
+        if not entries:
+            raise OSError
+        for name in entries:
+            yield (name, entries[name], 0)
+    def open(self, path, mode):
+        if 'w' in mode:
+            self.files[path] = b''
+        return UserFile(self.files[path])
+
+
+user_files = {
+    '/cachemod1.py': b'print("cachemod1")',
+    '/cachemod2.py': b'print("cachemod2")',
+    '/cachepkg/__init__.py': b'print("cachepkg")',
+    '/cachepkg/sub.py': b'print("cachepkg.sub")',
+}
+fs = UserFS(user_files)
+uos.mount(fs, '/userfs')
+# search only the user filesystem, so every query made is logged below
+sys_path = sys.path[:]
+sys.path[:] = ['/userfs']
+
+def show(label):
+    print(label, sorted(fs.calls))
+    fs.calls.clear()
+
+count = micropython.import_stat_count()
+
+# the root dir is listed once and then serves every name in it
+import cachemod1
+import cachemod2
+show('mods')
+
+# a package dir is listed when first searched
+import cachepkg.sub
+show('pkg')
+
+# a missing module needs no filesystem queries at all
+for name in ('missing', 'cachepkg.missing'):
+    try:
+        __import__(name)
+    except ImportError:
+        print('ImportError', name)
+show('missing')
+
+# the cache is invalidated when a file is created
+open('/userfs/cachemod3.py', 'w').write(b'print("cachemod3")')
+import cachemod3
+show('mod3')
+
+print(micropython.import_stat_count() - count)
+
+uos.umount('/userfs')
+sys.path[:] = sys_path
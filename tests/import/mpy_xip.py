@@ -0,0 +1,73 @@
+# test importing of an execute-in-place .mpy file
+
+import sys, uio
+
+try:
+    uio.IOBase
+    import uos
+    uos.mount
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+
+class UserFile(uio.IOBase):
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+    def read(self):
+        return self.data
+    def readinto(self, buf):
+        n = 0
+        while n < len(buf) and self.pos < len(self.data):
+            buf[n] = self.data[self.pos]
+            n += 1
+            self.pos += 1
+        return n
+    def ioctl(self, req, arg):
+        return 0
+
+
+class UserFS:
+    def __init__(self, files):
+        self.files = files
+    def mount(self, readonly, mksfs):
+        pass
+    def umount(self):
+        pass
+    def stat(self, path):
+        if path in self.files:
+            return (32768, 0, 0, 0, 0, 0, 0, 0, 0, 0)
+        raise OSError
+    def open(self, path, mode):
+        return UserFile(self.files[path])
+
+
+# mod.mpy is the output of "mpy-cross -mcache-lookup-bc -mxip" for:
+#   s = "a constant string longer than a qstr" * 2
+#   def f(a, *, b=2):
+#       return a + b
+#   class C:
+#       def m(self, x):
+#           return [x, s[:8], b"bytes"]
+user_files = {
+    '/mod.mpy': b'M\x03\x83\x1f\r\x08<module>\x06mod.py\x01s\x01b\x01f\x01C\x01a\x08__name__\n__module__\x0c__qualname__\x01m\x04self\x01x1\x04\x00\x10\x00\x00\x00\t\x00\x00\x01\x00(M\x00\x00\xff\x17\x01\x82\xf3$\x02\x00\x18S\x00\x82\x16\x03\x00Ta\x02$\x04\x00 `\x03\x16\x05\x00d\x02$\x05\x00\x11[\x01\x02s$a constant string longer than a qstr\x00\x13\x04\x00\x18\x01\x01\x00\x08\x04\x00\x01\x00A\x00\x00\xff\xb0\xb1\xf1[\x00\x00\x06\x03$\x01\x00\x10\x00\x00\x00\t\x05\x00\x01\x00n \x00\x00\xff\x1b\x07\x00\x00$\x08\x00\x16\x05\x00$\t\x00`\x01$\n\x00\x11[\x00\x01\x1f\x06\x00\x10\x02\x00\x00\t\n\x00\x01\x00a@\x00\x00\xff\xb1\x1c\x02\x00\x00\x11\x88X\x02!\x17\x03Q\x03[\x01\x00\x0b\x0cb\x05bytes\x00',
+}
+
+# create and mount a user filesystem
+uos.mount(UserFS(user_files), '/userfs')
+sys.path.append('/userfs')
+
+try:
+    import mod
+except ValueError:
+    # runtime doesn't support the execute-in-place layout
+    print("SKIP")
+else:
+    print(mod.f(1), mod.f(1, b=5), mod.f.__name__)
+    print(mod.C().m(3), mod.C.m.__name__)
+    print(len(mod.s))
+
+# unmount and undo path addition
+uos.umount('/userfs')
+sys.path.pop()
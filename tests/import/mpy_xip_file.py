@@ -0,0 +1,38 @@
+# test importing an execute-in-place .mpy file from the filesystem, which
+# the unix port memory-maps so the bytecode is used in place
+
+import sys
+
+try:
+    import uos
+    remove = getattr(uos, "remove", None) or uos.unlink
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+# output of "mpy-cross -mcache-lookup-bc -mxip", the same module as mpy_xip.py
+data = b'M\x03\x83\x1f\r\x08<module>\x06mod.py\x01s\x01b\x01f\x01C\x01a\x08__name__\n__module__\x0c__qualname__\x01m\x04self\x01x1\x04\x00\x10\x00\x00\x00\t\x00\x00\x01\x00(M\x00\x00\xff\x17\x01\x82\xf3$\x02\x00\x18S\x00\x82\x16\x03\x00Ta\x02$\x04\x00 `\x03\x16\x05\x00d\x02$\x05\x00\x11[\x01\x02s$a constant string longer than a qstr\x00\x13\x04\x00\x18\x01\x01\x00\x08\x04\x00\x01\x00A\x00\x00\xff\xb0\xb1\xf1[\x00\x00\x06\x03$\x01\x00\x10\x00\x00\x00\t\x05\x00\x01\x00n \x00\x00\xff\x1b\x07\x00\x00$\x08\x00\x16\x05\x00$\t\x00`\x01$\n\x00\x11[\x00\x01\x1f\x06\x00\x10\x02\x00\x00\t\n\x00\x01\x00a@\x00\x00\xff\xb1\x1c\x02\x00\x00\x11\x88X\x02!\x17\x03Q\x03[\x01\x00\x0b\x0cb\x05bytes\x00'
+
+try:
+    with open("mpy_xip_mod.mpy", "wb") as f:
+        f.write(data)
+except OSError:
+    print("SKIP")
+    raise SystemExit
+
+sys.path.insert(0, "")
+try:
+    import mpy_xip_mod as mod
+except ValueError:
+    # runtime doesn't support the execute-in-place layout
+    print("SKIP")
+else:
+    print(mod.f(1), mod.f(1, b=5), mod.f.__name__)
+    print(mod.C().m(3), mod.C.m.__name__)
+    print(len(mod.s))
+finally:
+    sys.path.pop(0)
+    remove("mpy_xip_mod.mpy")
+
+# the module keeps working once the file has gone
+print(mod.f(2), mod.C().m(4))
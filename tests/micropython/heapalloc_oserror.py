@@ -0,0 +1,51 @@
+# test that raising an OSError for an errno repeatedly doesn't allocate
+import micropython
+try:
+    import uselect
+    uselect.poll
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+# registering a negative fd raises EBADF on ports that check it; bind the
+# method first so that calling it doesn't allocate
+register = uselect.poll().register
+try:
+    register(-1)
+except OSError as er:
+    first = er
+else:
+    print("SKIP")
+    raise SystemExit
+
+# skip if the port doesn't preallocate OSErrors, as when threads run without
+# the GIL, or if raising allocates in a way other than the exception itself
+micropython.heap_lock()
+try:
+    try:
+        register(-1)
+    except OSError as er:
+        pooled = er is first
+except MemoryError:
+    pooled = False
+finally:
+    micropython.heap_unlock()
+if not pooled:
+    print("SKIP")
+    raise SystemExit
+
+def test():
+    n = 0
+    micropython.heap_lock()
+    try:
+        for i in range(100):
+            try:
+                register(-1)
+            except OSError as er:
+                if er is first:
+                    n += 1
+    finally:
+        micropython.heap_unlock()
+    print(n)
+test()
+print(first.args[0] == first.errno)
@@ -0,0 +1,43 @@
+# check that reading a file into a buffer doesn't allocate heap memory
+
+import micropython
+
+# Check for stackless build, which can't call functions without
+# allocating a frame on heap.
+try:
+    def stackless(): pass
+    micropython.heap_lock(); stackless(); micropython.heap_unlock()
+except RuntimeError:
+    print("SKIP")
+    raise SystemExit
+
+try:
+    f = open("io/data/bigfile1", "rb")
+except OSError:
+    print("SKIP")
+    raise SystemExit
+
+buf = bytearray(100)
+view = memoryview(buf)
+total = 0
+result = None
+
+def test(f):
+    global total
+    i = 0
+    while i < 10:
+        total += f.readinto(buf)
+        total += f.readinto(buf, 10)
+        total += f.readinto(view)
+        f.seek(i * 50)
+        i += 1
+
+micropython.heap_lock()
+try:
+    test(f)
+    result = "no allocation"
+except MemoryError:
+    result = "allocated"
+micropython.heap_unlock()
+f.close()
+print(result, total)
@@ -0,0 +1,282 @@
+// Host tests for the external flash cache, and for the flash translation layer
+// when built with EXTERNAL_FLASH_FTL. The flash is a simulated 2 MiB NOR
+// device whose program operation can only clear bits. Everything written is
+// also kept in a shadow copy, which reads and the flash are checked against.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "supervisor/memory.h"
+#include "supervisor/spi_flash_api.h"
+#include "supervisor/shared/external_flash/common_commands.h"
+#include "supervisor/shared/external_flash/external_flash.h"
+
+#ifdef EXTERNAL_FLASH_FTL
+// Included rather than linked so that a test can drop the block map and have
+// it rebuilt from the flash, as after a reset.
+#include "supervisor/shared/external_flash/ftl.c"
+#endif
+
+#define FLASH_SIZE (1 << 21)
+#define SECTOR_COUNT (FLASH_SIZE / SPI_FLASH_ERASE_SIZE)
+#define PAGES_PER_SECTOR (SPI_FLASH_ERASE_SIZE / SPI_FLASH_PAGE_SIZE)
+// Supervisor memory taken by a sector of ram cache.
+#define CACHE_LINE_MEMORY (SPI_FLASH_ERASE_SIZE + PAGES_PER_SECTOR * sizeof(uint8_t*))
+
+void supervisor_flash_init(void);
+uint32_t supervisor_flash_get_block_count(void);
+void supervisor_flash_flush(void);
+bool external_flash_read_block(uint8_t *dest, uint32_t block);
+bool external_flash_write_block(const uint8_t *data, uint32_t block);
+
+uint8_t **sim_flash_ram_cache;
+bool sim_heap_ok;
+
+// Bounds of the supervisor memory, set by memory_init().
+uint32_t _ebss, _estack;
+extern uint32_t* low_address;
+extern uint32_t* high_address;
+static uint32_t supervisor_ram[8 * 1024];
+
+static uint8_t flash[FLASH_SIZE];
+static uint8_t shadow[FLASH_SIZE];
+static uint32_t sector_erases[SECTOR_COUNT];
+static uint32_t block_count;
+// False when blocks don't map directly to flash addresses.
+static bool direct_mapping = true;
+static mp_uint_t ticks_ms;
+static uint32_t random_state = 1;
+
+mp_uint_t mp_hal_ticks_ms(void) {
+    return ticks_ms;
+}
+
+void common_hal_mcu_delay_us(uint32_t delay) {
+    (void) delay;
+}
+
+void temp_status_color(uint32_t rgb) {
+    (void) rgb;
+}
+
+void clear_temp_status(void) {
+}
+
+bool spi_flash_command(uint8_t command) {
+    return true;
+}
+
+bool spi_flash_read_command(uint8_t command, uint8_t* response, uint32_t length) {
+    // The status registers always read as ready.
+    memset(response, 0, length);
+    if (command == CMD_READ_JEDEC_ID) {
+        // GD25Q16C
+        response[0] = 0xc8;
+        response[1] = 0x40;
+        response[2] = 0x15;
+    }
+    return true;
+}
+
+bool spi_flash_write_command(uint8_t command, uint8_t* data, uint32_t length) {
+    return true;
+}
+
+bool spi_flash_sector_command(uint8_t command, uint32_t address) {
+    if (command == CMD_SECTOR_ERASE) {
+        memset(flash + address, 0xff, SPI_FLASH_ERASE_SIZE);
+        sector_erases[address / SPI_FLASH_ERASE_SIZE]++;
+    }
+    return true;
+}
+
+bool spi_flash_write_data(uint32_t address, uint8_t* data, uint32_t data_length) {
+    // Programming can only clear bits, and can't cross a page.
+    if (address % SPI_FLASH_PAGE_SIZE + data_length > SPI_FLASH_PAGE_SIZE) {
+        return false;
+    }
+    for (uint32_t i = 0; i < data_length; i++) {
+        flash[address + i] &= data[i];
+    }
+    return true;
+}
+
+bool spi_flash_read_data(uint32_t address, uint8_t* data, uint32_t data_length) {
+    memcpy(data, flash + address, data_length);
+    return true;
+}
+
+void spi_flash_init(void) {
+}
+
+void spi_flash_init_device(const external_flash_device* device) {
+}
+
+static uint8_t random_byte(void) {
+    random_state = random_state * 1103515245 + 12345;
+    return random_state >> 16;
+}
+
+// Set how many bytes of supervisor memory there are, and whether the heap can
+// be used. Only call this while nothing is allocated.
+static void set_memory(uint32_t size, bool heap_ok) {
+    memory_init();
+    low_address = supervisor_ram;
+    high_address = supervisor_ram + size / sizeof(uint32_t);
+    sim_heap_ok = heap_ok;
+}
+
+// Fill the flash with old data, as left behind by deleted files.
+static void fill_flash(void) {
+    for (uint32_t i = 0; i < FLASH_SIZE; i++) {
+        flash[i] = shadow[i] = random_byte();
+    }
+}
+
+// Change the given number of bytes of a block.
+static bool change_block(uint32_t block, uint32_t changes) {
+    uint8_t data[FILESYSTEM_BLOCK_SIZE];
+    memcpy(data, shadow + block * FILESYSTEM_BLOCK_SIZE, FILESYSTEM_BLOCK_SIZE);
+    for (uint32_t i = 0; i < changes; i++) {
+        data[(random_byte() << 8 | random_byte()) % FILESYSTEM_BLOCK_SIZE] = random_byte();
+    }
+    memcpy(shadow + block * FILESYSTEM_BLOCK_SIZE, data, FILESYSTEM_BLOCK_SIZE);
+    ticks_ms++;
+    return external_flash_write_block(data, block);
+}
+
+static bool write_block(uint32_t block) {
+    return change_block(block, FILESYSTEM_BLOCK_SIZE);
+}
+
+// Check that every block reads back as last written and, if the cache has
+// been written back, that the flash holds it too.
+static bool check(const char* test, const char* when, bool written_back) {
+    uint8_t data[FILESYSTEM_BLOCK_SIZE];
+    for (uint32_t block = 0; block < block_count; block++) {
+        if (!external_flash_read_block(data, block) ||
+            memcmp(data, shadow + block * FILESYSTEM_BLOCK_SIZE, FILESYSTEM_BLOCK_SIZE) != 0) {
+            printf("%s: block %u reads wrong %s\n", test, block, when);
+            return false;
+        }
+    }
+    if (written_back && direct_mapping &&
+        memcmp(flash, shadow, block_count * FILESYSTEM_BLOCK_SIZE) != 0) {
+        printf("%s: flash differs %s\n", test, when);
+        return false;
+    }
+    return true;
+}
+
+static bool report(const char* test, bool ok, uint32_t erases_before) {
+    printf("%s: %s, %u erases\n", test, ok ? "ok" : "FAIL",
+        external_flash_get_stats().erases - erases_before);
+    return ok;
+}
+
+// Copy a 200 KiB file roughly as a host does over USB: each data block is
+// followed by a FAT update, and every 8 blocks by a directory update.
+static bool test_file_copy(const char* test, uint32_t ram_lines, bool heap_ok) {
+    fill_flash();
+    set_memory(ram_lines * CACHE_LINE_MEMORY, heap_ok);
+    uint32_t erases = external_flash_get_stats().erases;
+    bool ok = true;
+    for (uint32_t i = 0; i < 400 && ok; i++) {
+        ok = write_block(100 + i) && write_block(1 + i / 256) &&
+            (i % 8 != 7 || write_block(20));
+        if (ok && i % 50 == 0) {
+            ok = check(test, "while copying", false);
+        }
+    }
+    ok = ok && check(test, "after copying", false);
+    // Stopping writing for a while writes everything back.
+    ticks_ms += EXTERNAL_FLASH_IDLE_FLUSH_MS;
+    external_flash_background();
+    ok = ok && check(test, "when idle", true);
+    supervisor_flash_flush();
+    ok = ok && check(test, "after flush", true);
+    return report(test, ok, erases);
+}
+
+// Blocks staged in the scratch sector, because no ram was free, must survive
+// a ram cache being allocated for a later write.
+static bool test_scratch_to_ram(const char* test, uint32_t ram_lines, bool heap_ok) {
+    fill_flash();
+    set_memory(0, false);
+    uint32_t erases = external_flash_get_stats().erases;
+    bool ok = write_block(8) && write_block(9) && check(test, "in scratch", false);
+    set_memory(ram_lines * CACHE_LINE_MEMORY, heap_ok);
+    ok = ok && write_block(16) && check(test, "after ram write", false);
+    ok = ok && write_block(10) && write_block(8) && check(test, "after ram rewrite", false);
+    supervisor_flash_flush();
+    ok = ok && check(test, "after flush", true);
+    return report(test, ok, erases);
+}
+
+#ifdef EXTERNAL_FLASH_FTL
+// A data logger on a disk that's 60% full of files that don't change. Each
+// record is flushed, which rewrites the file's last block, a FAT block and
+// the directory entry.
+static bool test_ftl_log(const char* test) {
+    memset(shadow, 0xff, sizeof(shadow));
+    bool ok = true;
+    uint32_t log_start = block_count * 6 / 10 + 16;
+    for (uint32_t block = 0; block < log_start - 16 && ok; block++) {
+        ok = write_block(block);
+    }
+    memset(sector_erases, 0, sizeof(sector_erases));
+    uint32_t erases = external_flash_get_stats().erases;
+    // Log 64 byte records until the disk is full.
+    uint32_t records = (block_count - log_start) * (FILESYSTEM_BLOCK_SIZE / 64);
+    for (uint32_t record = 0; record < records && ok; record++) {
+        uint32_t block = log_start + record * 64 / FILESYSTEM_BLOCK_SIZE;
+        ok = change_block(block, 64) && change_block(1 + block / 256, 2) && change_block(40, 4);
+    }
+    ok = ok && check(test, "after logging", false);
+
+    // Rebuild the map from the sector headers, as after a reset.
+    block_map = NULL;
+    ok = ok && ftl_init(FLASH_SIZE) && check(test, "after reset", false);
+
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+    uint32_t total = 0;
+    for (uint32_t sector = 0; sector < SECTOR_COUNT; sector++) {
+        min = sector_erases[sector] < min ? sector_erases[sector] : min;
+        max = sector_erases[sector] > max ? sector_erases[sector] : max;
+        total += sector_erases[sector];
+    }
+    printf("%s: %u records, per sector erases min %u max %u mean %u\n", test, records, min, max,
+        total / SECTOR_COUNT);
+    return report(test, ok, erases);
+}
+#endif
+
+// Pass --no-ftl-memory to leave no memory for the flash translation layer, so
+// that the flash is used without it.
+int main(int argc, char** argv) {
+    bool no_ftl_memory = argc > 1 && strcmp(argv[1], "--no-ftl-memory") == 0;
+    set_memory(no_ftl_memory ? 0 : sizeof(supervisor_ram), false);
+    supervisor_flash_init();
+    block_count = supervisor_flash_get_block_count();
+
+    bool ok = true;
+    #ifdef EXTERNAL_FLASH_FTL
+    if (block_map != NULL) {
+        direct_mapping = false;
+        ok = test_ftl_log("ftl, data logger");
+        return ok ? 0 : 1;
+    }
+    #endif
+    if (block_count != (FLASH_SIZE - SPI_FLASH_ERASE_SIZE) / FILESYSTEM_BLOCK_SIZE) {
+        printf("wrong block count %u\n", block_count);
+        return 1;
+    }
+    ok &= test_file_copy("copy, ram cache", 4, false);
+    ok &= test_file_copy("copy, heap cache", 0, true);
+    ok &= test_file_copy("copy, scratch sector", 0, false);
+    ok &= test_scratch_to_ram("scratch to ram cache", 4, false);
+    ok &= test_scratch_to_ram("scratch to heap cache", 0, true);
+    return ok ? 0 : 1;
+}
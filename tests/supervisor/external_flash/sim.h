@@ -0,0 +1,32 @@
+// Stand-ins for the runtime and board configuration used by the external
+// flash code.
+#ifndef MICROPY_INCLUDED_TESTS_SUPERVISOR_EXTERNAL_FLASH_SIM_H
+#define MICROPY_INCLUDED_TESTS_SUPERVISOR_EXTERNAL_FLASH_SIM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+typedef uintptr_t mp_uint_t;
+
+#define FILESYSTEM_BLOCK_SIZE (512)
+#define EXTERNAL_FLASH_DEVICE_COUNT (1)
+#define EXTERNAL_FLASH_DEVICES GD25Q16C
+
+// The VM heap, which a test can make fail.
+extern bool sim_heap_ok;
+#define m_malloc_maybe(num_bytes, long_lived) (sim_heap_ok ? malloc(num_bytes) : NULL)
+#define m_free(ptr) free(ptr)
+
+extern uint8_t **sim_flash_ram_cache;
+#define MP_STATE_VM(x) sim_##x
+
+mp_uint_t mp_hal_ticks_ms(void);
+void common_hal_mcu_delay_us(uint32_t delay);
+
+#define ACTIVE_WRITE (0)
+void temp_status_color(uint32_t rgb);
+void clear_temp_status(void);
+
+#endif // MICROPY_INCLUDED_TESTS_SUPERVISOR_EXTERNAL_FLASH_SIM_H
@@ -0,0 +1,211 @@
+// Host tests for the supervisor memory allocator. Every allocation is filled
+// with a pattern that is checked after each step, along with the allocations
+// staying inside ram and not overlapping.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "supervisor/memory.h"
+
+#define RAM_WORDS (48 * 1024 / 4)
+// Slots for the allocations a test holds, at most the allocator's own count.
+#define SLOTS (8)
+
+// Bounds of the supervisor memory, set by memory_init().
+uint32_t _ebss, _estack;
+extern uint32_t* low_address;
+extern uint32_t* high_address;
+static uint32_t ram[RAM_WORDS];
+
+static supervisor_allocation* live[SLOTS];
+static uint32_t pattern[SLOTS];
+static uint32_t moves;
+
+static void moved(supervisor_allocation* allocation) {
+    moves++;
+}
+
+static void reset(void) {
+    for (int i = 0; i < SLOTS; i++) {
+        if (live[i] != NULL) {
+            free_memory(live[i]);
+            live[i] = NULL;
+        }
+    }
+    memory_init();
+    low_address = ram;
+    high_address = ram + RAM_WORDS;
+    moves = 0;
+}
+
+static void fill(int i) {
+    pattern[i] = rand();
+    for (uint32_t w = 0; w < live[i]->length / 4; w++) {
+        live[i]->ptr[w] = pattern[i] + w;
+    }
+}
+
+static bool check(const char* test) {
+    for (int i = 0; i < SLOTS; i++) {
+        supervisor_allocation* a = live[i];
+        if (a == NULL) {
+            continue;
+        }
+        if (a->ptr < ram || a->ptr + a->length / 4 > ram + RAM_WORDS) {
+            printf("%s: allocation %d outside ram\n", test, i);
+            return false;
+        }
+        for (uint32_t w = 0; w < a->length / 4; w++) {
+            if (a->ptr[w] != pattern[i] + w) {
+                printf("%s: allocation %d corrupted\n", test, i);
+                return false;
+            }
+        }
+        for (int j = 0; j < i; j++) {
+            supervisor_allocation* b = live[j];
+            if (b != NULL && a->ptr < b->ptr + b->length / 4 && b->ptr < a->ptr + a->length / 4) {
+                printf("%s: allocations %d and %d overlap\n", test, i, j);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static uint32_t used(void) {
+    uint32_t total = 0;
+    for (int i = 0; i < SLOTS; i++) {
+        if (live[i] != NULL) {
+            total += live[i]->length;
+        }
+    }
+    return total;
+}
+
+static bool report(const char* test, bool ok) {
+    printf("%s: %s\n", test, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+// Allocate and free at random, with a stack at the top of ram, fixed and
+// movable allocations, and now and then a large buffer whenever there is
+// enough free memory for it.
+static bool test_random(const char* test) {
+    reset();
+    live[0] = allocate_memory(8 * 1024, true);
+    bool ok = live[0] != NULL && live[0]->ptr + live[0]->length / 4 == high_address;
+    if (ok) {
+        fill(0);
+    }
+    uint32_t large = 0;
+    uint32_t large_failed = 0;
+    for (int step = 0; step < 200000 && ok; step++) {
+        int i = 1 + rand() % (SLOTS - 2);
+        if (live[i] != NULL) {
+            free_memory(live[i]);
+            live[i] = NULL;
+        } else {
+            uint32_t length = (1 + rand() % 16) * 1024;
+            live[i] = i >= 3 ? allocate_movable_memory(length, moved) : allocate_memory(length, false);
+            if (live[i] != NULL) {
+                fill(i);
+            }
+        }
+        if (step % 100 == 0 && used() + 12 * 1024 <= sizeof(ram)) {
+            large++;
+            live[SLOTS - 1] = allocate_memory(12 * 1024, false);
+            if (live[SLOTS - 1] == NULL) {
+                large_failed++;
+            } else {
+                fill(SLOTS - 1);
+                ok = check(test);
+                free_memory(live[SLOTS - 1]);
+                live[SLOTS - 1] = NULL;
+            }
+        }
+        ok = ok && check(test) && live[0]->ptr + live[0]->length / 4 == high_address;
+    }
+    printf("%s: large buffer failed %u of %u times, %u moves\n", test, large_failed, large, moves);
+    return report(test, ok);
+}
+
+// High allocations are stacked down from the end of ram and never placed in
+// a lower gap.
+static bool test_high(const char* test) {
+    reset();
+    live[0] = allocate_memory(4096, true);
+    live[1] = allocate_memory(4096, true);
+    bool ok = live[0] != NULL && live[1] != NULL &&
+        live[0]->ptr + 1024 == high_address && live[1]->ptr + 1024 == live[0]->ptr;
+    // leave a 16 KiB gap at the bottom and 4 KiB below the high allocations
+    live[2] = allocate_memory(16 * 1024, false);
+    live[3] = allocate_memory(RAM_WORDS * 4 - 28 * 1024, false);
+    ok = ok && live[2] != NULL && live[3] != NULL;
+    if (ok) {
+        free_memory(live[2]);
+        live[2] = NULL;
+        ok = allocate_memory(8 * 1024, true) == NULL;
+    }
+    // the top gap is still used
+    live[4] = ok ? allocate_memory(4096, true) : NULL;
+    ok = ok && live[4] != NULL && live[4]->ptr + 1024 == live[1]->ptr;
+    // and freeing the top allocation makes room there again
+    if (ok) {
+        free_memory(live[0]);
+        live[0] = allocate_memory(2048, true);
+        ok = live[0] != NULL && live[0]->ptr + 512 == high_address;
+    }
+    return report(test, ok);
+}
+
+// Movable allocations in the way of a high allocation are moved down.
+static bool test_high_compacts(const char* test) {
+    reset();
+    live[0] = allocate_memory(RAM_WORDS * 4 - 24 * 1024, false);
+    live[1] = allocate_movable_memory(8 * 1024, moved);
+    live[2] = allocate_movable_memory(8 * 1024, moved);
+    bool ok = live[0] != NULL && live[1] != NULL && live[2] != NULL;
+    if (ok) {
+        fill(0);
+        fill(1);
+        fill(2);
+        free_memory(live[1]);
+        live[1] = NULL;
+        live[3] = allocate_memory(16 * 1024, true);
+        ok = live[3] != NULL && live[3]->ptr + 4096 == high_address && moves == 1;
+    }
+    if (ok) {
+        fill(3);
+        ok = check(test);
+    }
+    return report(test, ok);
+}
+
+// The remaining memory is the largest gap.
+static bool test_remaining(const char* test) {
+    reset();
+    live[0] = allocate_memory(4096, true);
+    live[1] = allocate_memory(4096, false);
+    live[2] = allocate_memory(8192, false);
+    live[3] = allocate_memory(4096, false);
+    bool ok = live[0] != NULL && live[1] != NULL && live[2] != NULL && live[3] != NULL;
+    if (ok) {
+        free_memory(live[2]);
+        live[2] = NULL;
+        live[4] = allocate_remaining_memory();
+        ok = live[4] != NULL && live[4]->ptr == live[3]->ptr + 1024 &&
+            live[4]->length == RAM_WORDS * 4 - 20 * 1024;
+    }
+    return report(test, ok);
+}
+
+int main(void) {
+    srand(1);
+    bool ok = true;
+    ok &= test_random("random");
+    ok &= test_high("high");
+    ok &= test_high_compacts("high, compacted");
+    ok &= test_remaining("remaining");
+    return ok ? 0 : 1;
+}
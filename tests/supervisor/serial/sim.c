@@ -0,0 +1,154 @@
+// Host tests for the buffered serial output. The CDC FIFO holds 256 bytes and
+// the simulated host takes up to one 64 byte packet from it on each flush,
+// while it's reading. Time advances by a microsecond on each tick read.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "supervisor/serial.h"
+#include "supervisor/usb.h"
+
+#define FIFO_SIZE (256)
+#define PACKET_SIZE (64)
+
+static uint8_t fifo[FIFO_SIZE];
+static uint32_t fifo_count;
+static bool host_reading = true;
+static uint32_t flushes;
+static uint64_t now_us;
+
+static uint8_t received[1 << 17];
+static uint32_t received_count;
+static uint8_t sent[1 << 17];
+static uint32_t sent_count;
+
+void current_tick(uint64_t* ms, uint32_t* us_until_ms) {
+    now_us++;
+    *ms = now_us / 1000;
+    *us_until_ms = 1000 - now_us % 1000;
+}
+
+bool tud_cdc_connected(void) {
+    return true;
+}
+
+int32_t tud_cdc_read_char(void) {
+    return -1;
+}
+
+uint32_t tud_cdc_available(void) {
+    return 0;
+}
+
+uint32_t tud_cdc_write(const void* buffer, uint32_t length) {
+    if (length > FIFO_SIZE - fifo_count) {
+        length = FIFO_SIZE - fifo_count;
+    }
+    memcpy(fifo + fifo_count, buffer, length);
+    fifo_count += length;
+    return length;
+}
+
+void tud_cdc_write_flush(void) {
+    flushes++;
+    if (!host_reading) {
+        return;
+    }
+    uint32_t length = fifo_count < PACKET_SIZE ? fifo_count : PACKET_SIZE;
+    memcpy(received + received_count, fifo, length);
+    received_count += length;
+    memmove(fifo, fifo + length, fifo_count - length);
+    fifo_count -= length;
+}
+
+void usb_init(void) {
+}
+
+void usb_background(void) {
+    serial_write_background();
+}
+
+static void send_text(const char* text, uint32_t length) {
+    serial_write_substring(text, length);
+    memcpy(sent + sent_count, text, length);
+    sent_count += length;
+}
+
+static void run_usb(int times) {
+    for (int i = 0; i < times; i++) {
+        usb_background();
+    }
+}
+
+static bool report(const char* test, bool ok) {
+    printf("%s: %s\n", test, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+// Output written while the host reads arrives intact, batched into packets.
+static bool test_reading(const char* test) {
+    uint32_t flushes_before = flushes;
+    for (int i = 0; i < 5000; i++) {
+        char line[32];
+        int length = snprintf(line, sizeof(line), "line %d\r\n", i);
+        send_text(line, length);
+        run_usb(20);
+    }
+    run_usb(10000);
+    uint32_t per_flush = received_count / (flushes - flushes_before);
+    printf("%s: %u bytes, %u per flush\n", test, received_count, per_flush);
+    return report(test, received_count == sent_count && memcmp(received, sent, sent_count) == 0 &&
+        serial_write_dropped() == 0 && per_flush >= PACKET_SIZE / 2);
+}
+
+// When the host stops reading, one write waits for the timeout and the rest
+// are dropped without waiting. What arrives once it reads again depends on
+// which output is dropped.
+static bool test_stalled(const char* test) {
+    received_count = 0;
+    sent_count = 0;
+    host_reading = false;
+    uint64_t start_us = now_us;
+    char chunk[12];
+    for (int i = 0; i < 2000; i++) {
+        snprintf(chunk, sizeof(chunk), "%010d", i);
+        send_text(chunk, 10);
+    }
+    uint64_t elapsed_ms = (now_us - start_us) / 1000;
+    uint32_t kept = FIFO_SIZE + CIRCUITPY_SERIAL_TX_BUFFER_SIZE;
+    uint32_t dropped = serial_write_dropped();
+    printf("%s: waited %u ms, dropped %u bytes\n", test, (uint32_t) elapsed_ms, dropped);
+    bool ok = elapsed_ms >= CIRCUITPY_SERIAL_TX_TIMEOUT_MS && elapsed_ms < 2 * CIRCUITPY_SERIAL_TX_TIMEOUT_MS &&
+        dropped == sent_count - kept;
+
+    host_reading = true;
+    run_usb(10000);
+    ok = ok && received_count == kept && memcmp(received, sent, FIFO_SIZE) == 0;
+    #if CIRCUITPY_SERIAL_TX_DROP_OLDEST
+    const uint8_t* buffered = sent + sent_count - CIRCUITPY_SERIAL_TX_BUFFER_SIZE;
+    #else
+    const uint8_t* buffered = sent + FIFO_SIZE;
+    #endif
+    ok = ok && memcmp(received + FIFO_SIZE, buffered, CIRCUITPY_SERIAL_TX_BUFFER_SIZE) == 0;
+    return report(test, ok);
+}
+
+// Output isn't dropped any more once the host reads again.
+static bool test_resumed(const char* test) {
+    received_count = 0;
+    uint32_t dropped = serial_write_dropped();
+    send_text("after\r\n", 7);
+    run_usb(10000);
+    return report(test, received_count == 7 && memcmp(received, "after\r\n", 7) == 0 &&
+        serial_write_dropped() == dropped);
+}
+
+int main(void) {
+    serial_init();
+    bool ok = true;
+    ok &= test_reading("reading");
+    ok &= test_stalled("stalled");
+    ok &= test_resumed("resumed");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+// Stand-ins for the runtime, tick and TinyUSB CDC functions used by the
+// serial code.
+#ifndef MICROPY_INCLUDED_TESTS_SUPERVISOR_SERIAL_SIM_H
+#define MICROPY_INCLUDED_TESTS_SUPERVISOR_SERIAL_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CIRCUITPY_SERIAL_TX_BUFFER_SIZE (1024)
+#define CIRCUITPY_SERIAL_TX_TIMEOUT_MS (100)
+
+void current_tick(uint64_t* ms, uint32_t* us_until_ms);
+
+bool tud_cdc_connected(void);
+int32_t tud_cdc_read_char(void);
+uint32_t tud_cdc_available(void);
+uint32_t tud_cdc_write(const void* buffer, uint32_t length);
+void tud_cdc_write_flush(void);
+
+#endif // MICROPY_INCLUDED_TESTS_SUPERVISOR_SERIAL_SIM_H
@@ -0,0 +1,229 @@
+// Host tests for the USB mass storage callbacks. The host is simulated by
+// calling the READ10 and WRITE10 callbacks one 512 byte chunk at a time, as
+// TinyUSB does at full speed. Everything written is also kept in a shadow
+// copy, which reads and the disk are checked against.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+#ifndef CIRCUITPY_MSC_BUFFER_BLOCKS
+#define CIRCUITPY_MSC_BUFFER_BLOCKS (8)
+#endif
+
+#define BLOCK_SIZE (512)
+#define DISK_BLOCKS (4096)
+
+int32_t tud_msc_scsi_cb(uint8_t lun, const uint8_t scsi_cmd[16], void* buffer, uint16_t bufsize);
+int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize);
+int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset, uint8_t* buffer, uint32_t bufsize);
+void tud_msc_write10_complete_cb(uint8_t lun);
+
+static uint8_t disk[DISK_BLOCKS * BLOCK_SIZE];
+static uint8_t shadow[DISK_BLOCKS * BLOCK_SIZE];
+static uint32_t disk_reads;
+static uint32_t disk_writes;
+static uint32_t disk_syncs;
+
+static fs_user_mount_t vfs = { .flags = FSUSER_USB_WRITABLE, .writeblocks = { &vfs } };
+static mp_vfs_mount_t mount = { &vfs, NULL };
+mp_vfs_mount_t* sim_vfs_mount_table = &mount;
+
+void tud_msc_set_sense(uint8_t lun, uint8_t sense_key, uint8_t add_sense_code, uint8_t add_sense_qualifier) {
+}
+
+void mp_vfs_import_stat_cache_clear(void) {
+}
+
+void autoreload_start(void) {
+}
+
+DRESULT disk_read(void* drv, BYTE* buff, DWORD sector, UINT count) {
+    if (sector + count > DISK_BLOCKS) {
+        return RES_ERROR;
+    }
+    disk_reads++;
+    memcpy(buff, disk + sector * BLOCK_SIZE, count * BLOCK_SIZE);
+    return RES_OK;
+}
+
+DRESULT disk_write(void* drv, const BYTE* buff, DWORD sector, UINT count) {
+    if (sector + count > DISK_BLOCKS) {
+        return RES_ERROR;
+    }
+    disk_writes++;
+    memcpy(disk + sector * BLOCK_SIZE, buff, count * BLOCK_SIZE);
+    return RES_OK;
+}
+
+DRESULT disk_ioctl(void* drv, BYTE cmd, void* buff) {
+    if (cmd == GET_SECTOR_COUNT) {
+        *(DWORD*) buff = DISK_BLOCKS;
+    } else if (cmd == GET_SECTOR_SIZE) {
+        *(uint16_t*) buff = BLOCK_SIZE;
+    } else if (cmd == CTRL_SYNC) {
+        disk_syncs++;
+    }
+    return RES_OK;
+}
+
+static int32_t scsi(uint8_t cmd_code, uint8_t byte4) {
+    uint8_t cmd[16] = { cmd_code, 0, 0, 0, byte4 };
+    return tud_msc_scsi_cb(0, cmd, NULL, 0);
+}
+
+static bool host_read(const char* test, uint32_t lba) {
+    uint8_t chunk[BLOCK_SIZE];
+    if (tud_msc_read10_cb(0, lba, 0, chunk, BLOCK_SIZE) != BLOCK_SIZE) {
+        printf("%s: read of block %u failed\n", test, lba);
+        return false;
+    }
+    if (memcmp(chunk, shadow + lba * BLOCK_SIZE, BLOCK_SIZE) != 0) {
+        printf("%s: block %u reads wrong\n", test, lba);
+        return false;
+    }
+    return true;
+}
+
+static bool host_write(uint32_t lba) {
+    uint8_t chunk[BLOCK_SIZE];
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        chunk[i] = rand();
+    }
+    memcpy(shadow + lba * BLOCK_SIZE, chunk, BLOCK_SIZE);
+    return tud_msc_write10_cb(0, lba, 0, chunk, BLOCK_SIZE) == BLOCK_SIZE;
+}
+
+static bool check_disk(const char* test) {
+    if (memcmp(disk, shadow, sizeof(disk)) != 0) {
+        printf("%s: disk differs\n", test);
+        return false;
+    }
+    return true;
+}
+
+// Disk calls expected for count sequential blocks.
+static uint32_t calls_for(uint32_t count) {
+    return CIRCUITPY_MSC_BUFFER_BLOCKS > 0 ? (count + CIRCUITPY_MSC_BUFFER_BLOCKS - 1) / CIRCUITPY_MSC_BUFFER_BLOCKS : count;
+}
+
+static bool report(const char* test, bool ok) {
+    printf("%s: %s\n", test, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+// Sequential reads are served by fewer, larger disk reads, up to the end of
+// the disk, and a read beyond the end fails.
+static bool test_read(const char* test) {
+    scsi(SCSI_CMD_TEST_UNIT_READY, 0);
+    disk_reads = 0;
+    bool ok = true;
+    for (uint32_t lba = 0; lba < 2048 && ok; lba++) {
+        ok = host_read(test, lba);
+    }
+    printf("%s: 2048 blocks in %u disk reads\n", test, disk_reads);
+    ok = ok && disk_reads == calls_for(2048);
+    for (uint32_t lba = DISK_BLOCKS - 3; lba < DISK_BLOCKS && ok; lba++) {
+        ok = host_read(test, lba);
+    }
+    uint8_t chunk[BLOCK_SIZE];
+    ok = ok && tud_msc_read10_cb(0, DISK_BLOCKS, 0, chunk, BLOCK_SIZE) < 0;
+    return report(test, ok);
+}
+
+// Blocks read ahead are forgotten when the host goes idle, since MicroPython
+// may change the disk after that.
+static bool test_idle(const char* test) {
+    scsi(SCSI_CMD_TEST_UNIT_READY, 0);
+    bool ok = host_read(test, 100) && host_read(test, 101);
+    disk[102 * BLOCK_SIZE] ^= 0xff;
+    shadow[102 * BLOCK_SIZE] ^= 0xff;
+    scsi(SCSI_CMD_TEST_UNIT_READY, 0);
+    ok = ok && host_read(test, 102);
+    return report(test, ok);
+}
+
+// Nothing is read ahead when MicroPython can write to the disk.
+static bool test_read_only(const char* test) {
+    vfs.flags &= ~FSUSER_USB_WRITABLE;
+    scsi(SCSI_CMD_TEST_UNIT_READY, 0);
+    disk_reads = 0;
+    bool ok = true;
+    for (uint32_t lba = 200; lba < 264 && ok; lba++) {
+        ok = host_read(test, lba);
+    }
+    ok = ok && disk_reads == 64;
+    vfs.flags |= FSUSER_USB_WRITABLE;
+    return report(test, ok);
+}
+
+// Sequential writes reach the disk in fewer, larger writes, and reads see
+// blocks that haven't been written out yet.
+static bool test_write(const char* test) {
+    disk_writes = 0;
+    bool ok = true;
+    for (uint32_t lba = 100; lba < 2148 && ok; lba++) {
+        ok = host_write(lba);
+        if (lba % 128 == 99) {
+            tud_msc_write10_complete_cb(0);
+        }
+        if (lba == 1000) {
+            ok = ok && host_read(test, 999) && host_read(test, 1000);
+        }
+    }
+    tud_msc_write10_complete_cb(0);
+    printf("%s: 2048 blocks in %u disk writes\n", test, disk_writes);
+    ok = ok && check_disk(test) && disk_writes == calls_for(2048);
+    return report(test, ok);
+}
+
+// Buffered blocks are written out when a write doesn't follow on, and on
+// SYNCHRONIZE CACHE.
+static bool test_write_out(const char* test) {
+    bool ok = host_write(3000) && host_write(3001) && host_write(2000);
+    ok = ok && memcmp(disk + 3000 * BLOCK_SIZE, shadow + 3000 * BLOCK_SIZE, 2 * BLOCK_SIZE) == 0;
+    ok = ok && scsi(0x35, 0) == 0 && check_disk(test);
+    return report(test, ok);
+}
+
+// FatFs's cached sector is updated when the host writes it, also in the
+// middle of a multiple block write.
+static bool test_fatfs_window(const char* test) {
+    vfs.fatfs.winsect = 502;
+    uint8_t blocks[4 * BLOCK_SIZE];
+    for (int i = 0; i < (int) sizeof(blocks); i++) {
+        blocks[i] = rand();
+    }
+    memcpy(shadow + 500 * BLOCK_SIZE, blocks, sizeof(blocks));
+    bool ok = tud_msc_write10_cb(0, 500, 0, blocks, sizeof(blocks)) == sizeof(blocks);
+    tud_msc_write10_complete_cb(0);
+    ok = ok && memcmp(vfs.fatfs.win, blocks + 2 * BLOCK_SIZE, BLOCK_SIZE) == 0 && check_disk(test);
+    return report(test, ok);
+}
+
+// Ejecting writes everything out and syncs the disk, after which the unit
+// isn't ready.
+static bool test_eject(const char* test) {
+    uint32_t syncs = disk_syncs;
+    bool ok = host_write(10) && host_write(11);
+    ok = ok && scsi(SCSI_CMD_START_STOP_UNIT, 0x02) == 0 && check_disk(test) && disk_syncs == syncs + 1;
+    ok = ok && scsi(SCSI_CMD_TEST_UNIT_READY, 0) < 0;
+    return report(test, ok);
+}
+
+int main(void) {
+    for (int i = 0; i < (int) sizeof(disk); i++) {
+        disk[i] = rand();
+    }
+    memcpy(shadow, disk, sizeof(disk));
+    bool ok = true;
+    ok &= test_read("read");
+    ok &= test_idle("idle");
+    ok &= test_read_only("read only");
+    ok &= test_write("write");
+    ok &= test_write_out("write out");
+    ok &= test_fatfs_window("fatfs window");
+    ok &= test_eject("eject");
+    return ok ? 0 : 1;
+}
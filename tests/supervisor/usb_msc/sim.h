@@ -0,0 +1,76 @@
+// Stand-ins for the TinyUSB, FatFs and runtime definitions used by the USB
+// mass storage code.
+#ifndef MICROPY_INCLUDED_TESTS_SUPERVISOR_USB_MSC_SIM_H
+#define MICROPY_INCLUDED_TESTS_SUPERVISOR_USB_MSC_SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define SCSI_CMD_TEST_UNIT_READY (0x00)
+#define SCSI_CMD_START_STOP_UNIT (0x1b)
+#define SCSI_CMD_PREVENT_ALLOW_MEDIUM_REMOVAL (0x1e)
+#define SCSI_SENSE_ILLEGAL_REQUEST (0x05)
+
+typedef struct __attribute__((packed)) {
+    uint8_t cmd_code;
+    uint8_t immded;
+    uint8_t reserved1;
+    uint8_t power_condition_mod;
+    uint8_t start : 1;
+    uint8_t load_eject : 1;
+    uint8_t no_flush : 1;
+    uint8_t reserved2 : 1;
+    uint8_t power_condition : 4;
+    uint8_t control;
+} scsi_start_stop_unit_t;
+
+void tud_msc_set_sense(uint8_t lun, uint8_t sense_key, uint8_t add_sense_code, uint8_t add_sense_qualifier);
+
+#define _MAX_SS (512)
+#define _MIN_SS (512)
+#define FILESYSTEM_BLOCK_SIZE (512)
+
+typedef uint8_t BYTE;
+typedef uint32_t DWORD;
+typedef unsigned int UINT;
+
+typedef struct {
+    DWORD winsect;
+    BYTE win[_MAX_SS];
+} FATFS;
+
+typedef enum {
+    RES_OK = 0,
+    RES_ERROR,
+} DRESULT;
+
+#define CTRL_SYNC (0)
+#define GET_SECTOR_COUNT (1)
+#define GET_SECTOR_SIZE (2)
+
+DRESULT disk_read(void* drv, BYTE* buff, DWORD sector, UINT count);
+DRESULT disk_write(void* drv, const BYTE* buff, DWORD sector, UINT count);
+DRESULT disk_ioctl(void* drv, BYTE cmd, void* buff);
+
+#define MP_OBJ_NULL (NULL)
+#define FSUSER_USB_WRITABLE (0x0008)
+
+typedef struct {
+    uint16_t flags;
+    void* writeblocks[2];
+    FATFS fatfs;
+} fs_user_mount_t;
+
+typedef struct _mp_vfs_mount_t {
+    void* obj;
+    struct _mp_vfs_mount_t* next;
+} mp_vfs_mount_t;
+
+extern mp_vfs_mount_t* sim_vfs_mount_table;
+#define MP_STATE_VM(x) sim_##x
+
+void mp_vfs_import_stat_cache_clear(void);
+void autoreload_start(void);
+
+#endif // MICROPY_INCLUDED_TESTS_SUPERVISOR_USB_MSC_SIM_H
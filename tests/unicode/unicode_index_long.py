@@ -0,0 +1,36 @@
+# test indexing and slicing of long unicode strings
+
+def check(s):
+    n = len(s)
+    chars = [c for c in s]
+    ok = True
+    for i in range(n):
+        if s[i] != chars[i] or s[-1 - i] != chars[n - 1 - i]:
+            ok = False
+    for i in range(0, n + 10, 7):
+        if s[i:i + 13] != ''.join(chars[i:i + 13]) or s[-i:] != ''.join(chars[-i:]):
+            ok = False
+    for i in (n, -n - 1, 10 * n):
+        try:
+            s[i]
+            ok = False
+        except IndexError:
+            pass
+    print(n, ok, s[n // 2], s[-n // 3], s[n // 4:n // 4 + 5])
+
+# ASCII, mixed widths, and long enough to need several checkpoint strides
+check('abcdefghij' * 10)
+check('aé€😀' * 40)
+check(''.join(chr(0x41 + i % 26) if i % 3 else chr(0x3b1 + i % 24) for i in range(2000)))
+
+# alternating between two strings
+a = 'π' * 100 + 'x'
+b = 'y' + 'ё' * 100
+print(a[100], b[0], a[50], b[100], a[-1], b[-101])
+
+# the cache is dropped by a garbage collection
+import gc
+c = 'ж' * 64 + 'z'
+print(c[64], c[10])
+gc.collect()
+print(c[64], c[-2])
@@ -487,6 +487,8 @@ def read_mpy(filename):
         if header[1] != config.MPY_VERSION:
             raise Exception('incompatible .mpy version')
         feature_flags = header[2]
+        if feature_flags & 0x80:
+            raise Exception('execute-in-place .mpy files cannot be frozen')
         config.MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE = (feature_flags & 1) != 0
         config.MICROPY_PY_BUILTINS_STR_UNICODE = (feature_flags & 2) != 0
         config.mp_small_int_bits = header[3]